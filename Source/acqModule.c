@@ -0,0 +1,412 @@
+/*
+ acqModule.c
+ Timer triggered analog acquisition source file
+
+ Captures N samples of one analog channel at a fixed rate
+ TIM1 update event triggers ADC1 through TRGO and
+ DMA1 Channel 1 moves each conversion to user memory
+
+ Buffers must be in the user dictionary (CREATE/ALLOT) because
+ the PAD is in CCM RAM that cannot be reached by the DMA
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "analog.h"        // Analog module header
+#include "acqModule.h"     // This module header
+
+// External variables
+extern const AnalogChannel AChannels[NUM_CHANNELS];
+
+// Acquisition data
+static AcqData acq;
+
+// DMA allocation flag
+static int32_t acqDmaAllocated=0;
+
+// ADC1 configuration before the capture
+static uint32_t acqSavedCFGR;
+
+// Semaphore signaled each time a block is ready
+static BinarySemaphore acqSem;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Program the trigger timer for the given frequency
+// Returns the real frequency obtained
+static int32_t acqTimerSet(int32_t freq)
+ {
+ uint32_t div,psc,arr;
+
+ // Total division from the timer clock
+ div=ACQ_TIMER_CLOCK/freq;
+
+ // Prescaler needed to fit the 16 bit counter
+ psc=div/65536;
+ arr=(div/(psc+1))-1;
+
+ // Configure the timer stopped
+ ACQ_TIMER->CR1=0;
+ ACQ_TIMER->PSC=psc;
+ ACQ_TIMER->ARR=arr;
+
+ // Update event is selected as TRGO
+ ACQ_TIMER->CR2=TIM_CR2_MMS_1;
+
+ // Load prescaler and clear flags
+ ACQ_TIMER->EGR=TIM_EGR_UG;
+ ACQ_TIMER->SR=0;
+
+ return ACQ_TIMER_CLOCK/((psc+1)*(arr+1));
+ }
+
+// Stops the timer and the ADC1 conversions
+// Restores ADC1 to software triggered mode
+// Can be called from the DMA interrupt
+static void acqHardwareStop(void)
+ {
+ // Stop the trigger
+ ACQ_TIMER->CR1&=~TIM_CR1_CEN;
+
+ // Stop ADC1 conversions if running
+ if ((ADC1->CR)&ADC_CR_ADSTART)
+      {
+	  ADC1->CR|=ADC_CR_ADSTP;
+	  while ((ADC1->CR)&ADC_CR_ADSTP);
+      }
+
+ // Restore ADC1 configuration
+ ADC1->CFGR=acqSavedCFGR;
+
+ // Stop the DMA
+ dmaStreamDisable(ACQ_DMA_STREAM);
+ }
+
+// Marks one block as ready
+// Counts an overrun if the block was not read
+// Must be called inside a lock zone
+static void acqBlockReady(int32_t block)
+ {
+ if (acq.Ready&BIT(block)) acq.Overruns++;
+ acq.Ready|=BIT(block);
+ chBSemSignalI(&acqSem);
+ }
+
+// DMA interrupt callback
+static void acqDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+
+ chSysLockFromIsr();
+
+ // Transfer error ends the capture
+ if (flags&STM32_DMA_ISR_TEIF)
+      {
+	  acqHardwareStop();
+	  acq.Overruns++;
+	  acq.Status=ACQS_STOP;
+	  chBSemSignalI(&acqSem);
+	  chSysUnlockFromIsr();
+	  return;
+      }
+
+ if (acq.Mode==ACQ_MODE_SINGLE)
+    {
+	// Single mode ends at transfer complete
+	if (flags&STM32_DMA_ISR_TCIF)
+	     {
+		 acqHardwareStop();
+		 acq.Status=ACQS_DONE;
+		 acqBlockReady(0);
+	     }
+    }
+   else
+    {
+	// Double mode gives first half and second half
+	if (flags&STM32_DMA_ISR_HTIF) acqBlockReady(0);
+	if (flags&STM32_DMA_ISR_TCIF) acqBlockReady(1);
+    }
+
+ chSysUnlockFromIsr();
+ }
+
+// Count and clear ADC1 overrun flag
+static void acqCheckOverrun(void)
+ {
+ // Only meaningful if ADC1 has been used by a capture
+ if (!acqDmaAllocated) return;
+
+ if ((ADC1->ISR)&ADC_ISR_OVR)
+     {
+	 ADC1->ISR=ADC_ISR_OVR;
+	 acq.Overruns++;
+     }
+ }
+
+// Stops any capture and releases the DMA
+static void acqStop(void)
+ {
+ // Stop the hardware if running
+ if (acq.Status==ACQS_RUN)
+	 acqHardwareStop();
+
+ // Count last overrun
+ acqCheckOverrun();
+
+ // Release the DMA
+ if (acqDmaAllocated)
+     {
+	 dmaStreamRelease(ACQ_DMA_STREAM);
+	 acqDmaAllocated=0;
+     }
+
+ acq.Status=ACQS_STOP;
+ }
+
+// Try to get the capture parameters from the stack
+// ( addr n uch -- )
+// Returns 0 on error
+static int32_t getCaptureParameters(ContextType *context,int32_t mode
+		                     ,int32_t *addr,int32_t *n,int32_t *ch)
+ {
+ // Try to get them from the stack
+ if (PstackPop(context,ch)) return 0;
+ if (PstackPop(context,n)) return 0;
+ if (PstackPop(context,addr)) return 0;
+
+ // Check channel
+ if (((*ch)<0)||((*ch)>=NUM_CHANNELS))
+       {
+	   consoleErrorMessage(context,"Invalid analog channel");
+	   return 0;
+       }
+
+ // Check number of samples
+ if (((*n)<1)||((*n)>ACQ_MAX_SAMPLES))
+       {
+	   consoleErrorMessage(context,"Invalid number of samples");
+	   return 0;
+       }
+
+ // Double mode needs two equal halves
+ if ((mode==ACQ_MODE_DOUBLE)&&((*n)&1))
+       {
+	   consoleErrorMessage(context,"Double capture needs an even number of samples");
+	   return 0;
+       }
+
+ // Check buffer
+ if (((*addr)&1)||(!portDmaBuffer((uint32_t)(*addr),(*n)*sizeof(uint16_t))))
+       {
+	   consoleErrorMessage(context,"Invalid capture buffer");
+	   return 0;
+       }
+
+ return 1; // Ok
+ }
+
+// Starts a capture
+static void acqStart(ContextType *context,int32_t mode)
+ {
+ int32_t addr,n,ch;
+ uint32_t dmaMode;
+
+ // Check that we are not running
+ if (acq.Status==ACQS_RUN)
+     {
+	 consoleErrorMessage(context,"Capture already running");
+	 return;
+     }
+
+ // Get parameters
+ if (!getCaptureParameters(context,mode,&addr,&n,&ch)) return;
+
+ // Release last capture if needed
+ acqStop();
+
+ // Try to allocate the DMA
+ if (dmaStreamAllocate(ACQ_DMA_STREAM,ACQ_IRQ_PRIORITY,acqDmaCallback,NULL))
+     {
+	 consoleErrorMessage(context,"Capture DMA is busy");
+	 return;
+     }
+ acqDmaAllocated=1;
+
+ // Set capture data
+ acq.Buffer=(uint16_t*)addr;
+ acq.Samples=n;
+ acq.Mode=mode;
+ acq.Ready=0;
+ acq.Overruns=0;
+ acq.Next=0;
+ chBSemReset(&acqSem,TRUE);
+
+ // Program the timer
+ acqTimerSet(acq.Freq);
+
+ // Program ADC1 for the channel triggered by TIM1 TRGO on rising edge
+ acqSavedCFGR=ADC1->CFGR;
+ ADC1->SQR1=(AChannels[ch].channel&0x1F)<<6;
+ ADC1->ISR=ADC_ISR_OVR;
+ ADC1->CFGR=(acqSavedCFGR&(~(ADC_CFGR_EXTSEL|ADC_CFGR_EXTEN|ADC_CFGR_DMACFG|ADC_CFGR_CONT)))
+		   |(ACQ_ADC_EXTSEL<<6)|ADC_CFGR_EXTEN_0|ADC_CFGR_DMAEN;
+ if (mode==ACQ_MODE_DOUBLE) ADC1->CFGR|=ADC_CFGR_DMACFG;
+
+ // Program the DMA
+ dmaMode=STM32_DMA_CR_DIR_P2M|STM32_DMA_CR_MINC|STM32_DMA_CR_PSIZE_HWORD
+		|STM32_DMA_CR_MSIZE_HWORD|STM32_DMA_CR_TCIE|STM32_DMA_CR_TEIE
+		|STM32_DMA_CR_PL(ACQ_DMA_PRIORITY);
+ if (mode==ACQ_MODE_DOUBLE) dmaMode|=STM32_DMA_CR_CIRC|STM32_DMA_CR_HTIE;
+ dmaStreamSetPeripheral(ACQ_DMA_STREAM,&(ADC1->DR));
+ dmaStreamSetMemory0(ACQ_DMA_STREAM,acq.Buffer);
+ dmaStreamSetTransactionSize(ACQ_DMA_STREAM,n);
+ dmaStreamSetMode(ACQ_DMA_STREAM,dmaMode);
+ dmaStreamEnable(ACQ_DMA_STREAM);
+
+ // Arm ADC1 so it waits for the trigger
+ acq.Status=ACQS_RUN;
+ ADC1->CR|=ADC_CR_ADSTART;
+
+ // Start the trigger timer
+ ACQ_TIMER->CR1|=TIM_CR1_CEN;
+ }
+
+// Waits for the next block
+// Returns its address or 0 on error
+static uint32_t acqWait(ContextType *context)
+ {
+ int32_t block;
+
+ while (1)
+     {
+	 // Check if the next block is ready
+	 chSysLock();
+	 block=acq.Next;
+	 if (acq.Ready&BIT(block))
+	       {
+		   acq.Ready&=~BIT(block);
+		   if (acq.Mode==ACQ_MODE_DOUBLE) acq.Next^=1;
+		   chSysUnlock();
+
+		   // Return the start of the block
+		   return (uint32_t)(acq.Buffer+block*(acq.Samples/2));
+	       }
+	 chSysUnlock();
+
+	 // Error if nothing will come
+	 if (acq.Status!=ACQS_RUN)
+	      {
+		  runtimeErrorMessage(context,"No capture running");
+		  return 0;
+	      }
+
+	 // Check user abort
+	 if (PORT_ABORT)
+	      {
+		  runtimeErrorMessage(context,"Capture wait aborted");
+		  return 0;
+	      }
+
+	 // Wait for the DMA
+	 chBSemWaitTimeout(&acqSem,ACQ_WAIT_POLL);
+     }
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void acqModuleInit(void)
+ {
+ // Enable trigger timer clock
+ RCC->APB2ENR|=RCC_APB2ENR_TIM1EN;
+
+ // Semaphore starts taken
+ chBSemInit(&acqSem,TRUE);
+
+ // Default values
+ acq.Freq=ACQ_DEF_FREQ;
+ acq.Status=ACQS_STOP;
+ acq.Ready=0;
+ acq.Overruns=0;
+ }
+
+// Check if ADC1 is being used by a capture
+int32_t acqIsRunning(void)
+ {
+ return (acq.Status==ACQS_RUN);
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic acquisition function
+int32_t acqFunction(ContextType *context,int32_t value)
+ {
+ int32_t data;
+ uint32_t addr;
+
+ switch (value)
+     {
+     case ACQ_F_FREQ: // Set sample frequency ( uf -- uf )
+    	 if (PstackPop(context,&data)) return 0;
+    	 // Check range
+    	 if ((data<ACQ_MIN_FREQ)||(data>ACQ_MAX_FREQ))
+    	       {
+    		   consoleErrorMessage(context,"Invalid frequency");
+    		   return 0;
+    	       }
+    	 // Cannot change while running
+    	 if (acq.Status==ACQS_RUN)
+    	       {
+    		   consoleErrorMessage(context,"Capture running");
+    		   return 0;
+    	       }
+    	 acq.Freq=data;
+    	 // Give real frequency
+    	 PstackPush(context,acqTimerSet(data));
+    	 break;
+
+     case ACQ_F_SINGLE: // Start single capture ( addr n uch -- )
+    	 acqStart(context,ACQ_MODE_SINGLE);
+    	 break;
+
+     case ACQ_F_DOUBLE: // Start double buffered capture ( addr n uch -- )
+    	 acqStart(context,ACQ_MODE_DOUBLE);
+    	 break;
+
+     case ACQ_F_WAIT: // Wait for a block ( -- addr )
+    	 acqCheckOverrun();
+    	 addr=acqWait(context);
+    	 if (addr) PstackPush(context,(int32_t)addr);
+    	 break;
+
+     case ACQ_F_READY: // Check if a block is ready ( -- f )
+    	 if (acq.Ready&BIT(acq.Next))
+    		 PstackPush(context,FTRUE);
+    	    else
+    	     PstackPush(context,FFALSE);
+    	 break;
+
+     case ACQ_F_OVERRUNS: // Number of lost blocks ( -- n )
+    	 acqCheckOverrun();
+    	 PstackPush(context,acq.Overruns);
+    	 break;
+
+     case ACQ_F_STOP: // Stop capture
+    	 acqStop();
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in acqFunction");
+     }
+
+ return 0;
+ }
+
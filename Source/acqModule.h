@@ -0,0 +1,67 @@
+/*
+ acqModule.h
+ Timer triggered analog acquisition header file
+
+ ADC1 conversions are triggered by TIM1 TRGO and the
+ results are moved by DMA1 Channel 1 to user memory
+ */
+
+#ifndef _ACQ_MODULE
+#define _ACQ_MODULE
+
+// Hardware used for this module
+#define ACQ_TIMER            TIM1                // Trigger timer
+#define ACQ_DMA_STREAM       STM32_DMA1_STREAM1  // ADC1 DMA channel
+#define ACQ_DMA_PRIORITY     2                   // DMA priority (0..3)
+#define ACQ_IRQ_PRIORITY     6                   // DMA IRQ priority
+#define ACQ_ADC_EXTSEL       9                   // ADC12 EXT9 is TIM1_TRGO
+
+// Acquisition limits
+#define ACQ_TIMER_CLOCK      72000000    // TIM1 clock (f APB2 x 2)
+#define ACQ_MIN_FREQ         1           // Min sample frequency
+#define ACQ_MAX_FREQ         1000000     // Max sample frequency
+#define ACQ_MAX_SAMPLES      65535       // DMA counter limit
+#define ACQ_DEF_FREQ         10000       // Default sample frequency
+
+// Wait poll interval for abort check (in system ticks)
+#define ACQ_WAIT_POLL        10
+
+// Acquisition modes
+#define ACQ_MODE_SINGLE      0    // Fill the buffer once
+#define ACQ_MODE_DOUBLE      1    // Circular buffer in two halves
+
+// Acquisition status
+#define ACQS_STOP            0    // Not running
+#define ACQS_RUN             1    // Capture in progress
+#define ACQS_DONE            2    // Single capture completed
+
+// Acquisition data
+typedef struct
+ {
+ uint16_t *Buffer;     // Start of the sample buffer
+ int32_t Samples;      // Total number of samples in the buffer
+ int32_t Mode;         // Single or double buffer
+ int32_t Freq;         // Sample frequency
+ volatile int32_t Status;     // Acquisition status
+ volatile int32_t Ready;      // Bit mask of blocks ready to be read
+ volatile int32_t Overruns;   // Number of blocks lost
+ int32_t Next;         // Next block to give in double mode
+ }
+ AcqData;
+
+// Function prototypes
+void acqModuleInit(void);
+int32_t acqIsRunning(void);
+
+// Command functions
+int32_t acqFunction(ContextType *context,int32_t value);
+#define ACQ_F_FREQ        0   // Set sample frequency
+#define ACQ_F_SINGLE      1   // Start single capture
+#define ACQ_F_DOUBLE      2   // Start double buffered capture
+#define ACQ_F_WAIT        3   // Wait for a block
+#define ACQ_F_READY       4   // Check if there is a block ready
+#define ACQ_F_OVERRUNS    5   // Get number of overruns
+#define ACQ_F_STOP        6   // Stop the capture
+
+#endif // _ACQ_MODULE
+
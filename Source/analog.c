@@ -16,6 +16,7 @@
 #include "gizmo.h"         // Main include for the project
 #include "chprintf.h"	   // chprintf function
 #include "analog.h"        // This module header file
+#include "acqModule.h"     // Analog capture module
 
 // Channel definitions
 const AnalogChannel AChannels[NUM_CHANNELS]={
@@ -78,6 +79,22 @@ static void analogSetSingle(int32_t channel)
  }
 
 
+// Check if one analogFunction command uses ADC1
+static int32_t analogUsesADC(int32_t value)
+ {
+ switch (value)
+     {
+     case ANALOG_F_DAC:
+     case ANALOG_F_NMEAN:
+     case ANALOG_F_SINGLE_CONVERT:
+     case ANALOG_F_DIFFERENTIAL_CONVERT:
+     case ANALOG_F_MV2COUNTS:
+    	 return 0;
+     }
+
+ return 1;
+ }
+
 /****************** PUBLIC FUNCTIONS *********************/
 
 // Calibrates ADC1,2 for single channel
@@ -402,6 +419,13 @@ int32_t analogFunction(ContextType *context,int32_t value)
  {
  int32_t channel,channel2,data,data2;
 
+ // ADC1 cannot be used during a capture
+ if (acqIsRunning()&&analogUsesADC(value))
+       {
+	   runtimeErrorMessage(context,"ADC busy in capture");
+	   return 0;
+       }
+
  switch (value)
      {
      case ANALOG_F_READ:    // Read one channel ------------------
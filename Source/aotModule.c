@@ -0,0 +1,32 @@
+/*
+ aotModule.c
+ Translated words source file
+
+ This module holds user words translated to C functions
+ To add a word:
+
+   1. Compile the word and check it works as expected
+   2. Run CGEN name and paste the function at the end of this file
+   3. Add its prototype in aotModule.h
+   4. Add the register line given by CGEN in fp_portDictionary.h
+
+ Translated words use Base Dictionary codes, so they should be
+ translated again if the MForth version changes. Values and
+ variables are accessed at their user dictionary positions so
+ the dictionary must be loaded in the same order.
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_screen.h"
+#include "fm_translate.h"  // Runtime for translated words
+
+#include "gizmo.h"         // Main include for the project
+#include "aotModule.h"     // This module header
+
+/*********************** TRANSLATED WORDS ****************************/
+
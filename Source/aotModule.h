@@ -0,0 +1,15 @@
+/*
+ aotModule.h
+ Translated words header file
+
+ Prototypes of the words translated to C with CGEN
+ */
+
+#ifndef _AOT_MODULE
+#define _AOT_MODULE
+
+// Command functions
+// Add here one prototype for each translated word
+//   int32_t aotNAME(ContextType *context,int32_t value);
+
+#endif // _AOT_MODULE
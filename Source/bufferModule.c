@@ -0,0 +1,350 @@
+/*
+ bufferModule.c
+ Buffer math functions source file
+
+ Native one pass kernels over (addr, n, usize) arrays
+ so captured data don't need a Forth loop per element
+
+ Sums of half words use the Cortex-M4 dual 16 bit MAC
+ instructions when available. A plain C version is
+ used on other targets.
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "analog.h"        // Analog module header
+#include "bufferModule.h"  // This module header
+
+// External variables
+extern int32_t VddCal;     // Vdd calibration in analog.c
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Try to get buffer parameters from the stack
+// ( addr n usize -- )
+// Returns 0 on error
+static int32_t getBuffer(ContextType *context,uint8_t **addr,int32_t *n,int32_t *size)
+ {
+ int32_t data,bytes;
+
+ // Try to get them from the stack
+ if (PstackPop(context,size)) return 0;
+ if (PstackPop(context,n)) return 0;
+ if (PstackPop(context,&data)) return 0;
+
+ // Check element size
+ if (((*size)!=1)&&((*size)!=2)&&((*size)!=4)
+	 &&((*size)!=-1)&&((*size)!=-2)&&((*size)!=-4))
+       {
+	   consoleErrorMessage(context,"Invalid element size");
+	   return 0;
+       }
+
+ // Check number of elements
+ if (((*n)<1)||((*n)>BUF_MAX_ELEMENTS))
+       {
+	   consoleErrorMessage(context,"Invalid number of elements");
+	   return 0;
+       }
+
+ // Check alignment and memory zone
+ bytes=((*size)<0)?-(*size):(*size);
+ if ((data%bytes)||(!portUserBuffer((uint32_t)data,(*n)*bytes)))
+       {
+	   consoleErrorMessage(context,"Invalid buffer");
+	   return 0;
+       }
+
+ (*addr)=(uint8_t*)(uintptr_t)data;
+ return 1; // Ok
+ }
+
+// Get one element of a buffer
+static int32_t bufGet(uint8_t *addr,int32_t i,int32_t size)
+ {
+ switch (size)
+     {
+     case 1:  return ((uint8_t*)addr)[i];
+     case -1: return ((int8_t*)addr)[i];
+     case 2:  return ((uint16_t*)addr)[i];
+     case -2: return ((int16_t*)addr)[i];
+     }
+ return ((int32_t*)addr)[i];
+ }
+
+// Set one element of a buffer
+static void bufSet(uint8_t *addr,int32_t i,int32_t size,int32_t value)
+ {
+ switch (size)
+     {
+     case 1:
+     case -1: ((uint8_t*)addr)[i]=(uint8_t)value;   return;
+     case 2:
+     case -2: ((uint16_t*)addr)[i]=(uint16_t)value; return;
+     }
+ ((int32_t*)addr)[i]=value;
+ }
+
+#ifdef __ARM_FEATURE_DSP
+// Sum and sum of squares of a half word buffer
+// Two elements are processed in each 32 bit access
+// Unsigned data is biased to signed with an xor
+// so that SMLALD can be used and corrected afterwards:
+//      x=y+32768
+//      Sum(x)  = Sum(y) + 32768n
+//      Sum(x2) = Sum(y2) + 65536 Sum(y) + n 2^30
+static void bufSumHalfs(uint8_t *addr,int32_t n,int32_t size
+		               ,int64_t *sum,int64_t *sumsq)
+ {
+ uint16_t *p;
+ uint32_t *pw,w,bias;
+ int64_t s=0,s2=0;
+ int32_t i,y,total=n;
+
+ // Bias only for unsigned data
+ bias=(size==2)?0x80008000:0;
+
+ p=(uint16_t*)addr;
+
+ // Align to 32 bits
+ if (((uintptr_t)p)&2)
+     {
+	 y=(int16_t)((*p)^(uint16_t)bias);
+	 s+=y;
+	 s2+=y*y;
+	 p++;
+	 n--;
+     }
+
+ // Process pairs
+ pw=(uint32_t*)p;
+ for(i=n/2;i>0;i--)
+     {
+	 w=(*pw++)^bias;
+	 s=(int64_t)__SMLALD(w,0x00010001,(uint64_t)s);
+	 s2=(int64_t)__SMLALD(w,w,(uint64_t)s2);
+     }
+
+ // Last element if any
+ if (n&1)
+     {
+	 p=(uint16_t*)pw;
+	 y=(int16_t)((*p)^(uint16_t)bias);
+	 s+=y;
+	 s2+=y*y;
+     }
+
+ // Undo the bias
+ if (bias)
+     {
+	 s2=s2+65536*s+(((int64_t)total)<<30);
+	 s=s+32768*(int64_t)total;
+     }
+
+ (*sum)=s;
+ (*sumsq)=s2;
+ }
+#endif //__ARM_FEATURE_DSP
+
+// Sum and sum of squares of a buffer
+static void bufSums(uint8_t *addr,int32_t n,int32_t size
+		               ,int64_t *sum,int64_t *sumsq)
+ {
+ int32_t i,data;
+ int64_t s=0,s2=0;
+
+#ifdef __ARM_FEATURE_DSP
+ // Half words use the DSP instructions
+ if ((size==2)||(size==-2))
+     {
+	 bufSumHalfs(addr,n,size,sum,sumsq);
+	 return;
+     }
+#endif //__ARM_FEATURE_DSP
+
+ for(i=0;i<n;i++)
+     {
+	 data=bufGet(addr,i,size);
+	 s+=data;
+	 s2+=((int64_t)data)*data;
+     }
+
+ (*sum)=s;
+ (*sumsq)=s2;
+ }
+
+// Locates maximum (dir=1) or minimum (dir=-1) of a buffer
+// Returns the index of the first one found
+static int32_t bufLocate(uint8_t *addr,int32_t n,int32_t size,int32_t dir
+		                ,int32_t *value)
+ {
+ int32_t i,data,best,index=0;
+
+ best=bufGet(addr,0,size);
+ for(i=1;i<n;i++)
+     {
+	 data=bufGet(addr,i,size);
+	 if (dir>0)
+	     { if (data>best) { best=data; index=i; } }
+	    else
+	     { if (data<best) { best=data; index=i; } }
+     }
+
+ (*value)=best;
+ return index;
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Integer square root of a 64 bit number
+int32_t bufferSqrt64(uint64_t value)
+ {
+ uint64_t result=0,bit;
+
+ // Highest power of four below the value
+ bit=((uint64_t)1)<<62;
+ while (bit>value) bit>>=2;
+
+ // Digit by digit calculation
+ while (bit)
+     {
+	 if (value>=result+bit)
+	      {
+		  value-=result+bit;
+		  result=(result>>1)+bit;
+	      }
+	     else
+	      result>>=1;
+	 bit>>=2;
+     }
+
+ return (int32_t)result;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Buffer math function
+// All words start with ( addr n usize -- )
+int32_t bufferFunction(ContextType *context,int32_t value)
+ {
+ uint8_t *addr;
+ int32_t n,size,i,data,mul=0,div=1,index;
+ int64_t sum,sumsq;
+
+ // Get extra parameters if needed
+ if (value==BUF_F_SCALE)
+     {
+	 if (PstackPop(context,&div)) return 0;
+	 if (PstackPop(context,&mul)) return 0;
+	 if (!div)
+	     {
+		 runtimeErrorMessage(context,"Division by zero");
+		 return 0;
+	     }
+     }
+ if (value==BUF_F_OFFSET)
+	 if (PstackPop(context,&mul)) return 0;
+
+ // Get buffer
+ if (!getBuffer(context,&addr,&n,&size)) return 0;
+
+ switch (value)
+     {
+     case BUF_F_SUM: // Sum ( addr n usize -- sum )
+    	 bufSums(addr,n,size,&sum,&sumsq);
+    	 PstackPush(context,(int32_t)sum);
+    	 break;
+
+     case BUF_F_MEAN: // Mean ( addr n usize -- mean )
+    	 bufSums(addr,n,size,&sum,&sumsq);
+    	 PstackPush(context,(int32_t)(sum/n));
+    	 break;
+
+     case BUF_F_MAX: // Maximum ( addr n usize -- max index )
+    	 index=bufLocate(addr,n,size,1,&data);
+    	 PstackPush(context,data);
+    	 PstackPush(context,index);
+    	 break;
+
+     case BUF_F_MIN: // Minimum ( addr n usize -- min index )
+    	 index=bufLocate(addr,n,size,-1,&data);
+    	 PstackPush(context,data);
+    	 PstackPush(context,index);
+    	 break;
+
+     case BUF_F_RMS: // Root mean square ( addr n usize -- rms )
+    	 bufSums(addr,n,size,&sum,&sumsq);
+    	 PstackPush(context,bufferSqrt64(((uint64_t)sumsq)/n));
+    	 break;
+
+     case BUF_F_OFFSET: // Add offset ( addr n usize off -- )
+    	 for(i=0;i<n;i++)
+    		 bufSet(addr,i,size,bufGet(addr,i,size)+mul);
+    	 break;
+
+     case BUF_F_SCALE: // Scale ( addr n usize mul div -- )
+    	 for(i=0;i<n;i++)
+    		 bufSet(addr,i,size,(int32_t)((((int64_t)bufGet(addr,i,size))*mul)/div));
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in bufferFunction");
+     }
+
+ return 0;
+ }
+
+// Conversion of analog readings to mV in place
+// Buffers are half words as given by the capture module
+// ( addr n -- )
+int32_t bufferConvertFunction(ContextType *context,int32_t value)
+ {
+ uint16_t *addr;
+ int32_t n,data,vdd,i;
+
+ // Try to get the buffer
+ if (PstackPop(context,&n)) return 0;
+ if (PstackPop(context,&data)) return 0;
+
+ // Check it
+ if ((n<1)||(n>BUF_MAX_ELEMENTS)||(data&1)
+	 ||(!portUserBuffer((uint32_t)data,n*sizeof(uint16_t))))
+       {
+	   consoleErrorMessage(context,"Invalid buffer");
+	   return 0;
+       }
+ addr=(uint16_t*)(uintptr_t)data;
+
+ // Vdd to use
+ if (VddCal==VDD_NOT_CALIBRATED)
+	 vdd=3000;
+    else
+     vdd=VddCal;
+
+ switch (value)
+     {
+     case BUF_F_SINGLE2MV: // Single readings to mV
+    	 for(i=0;i<n;i++)
+    		 addr[i]=(uint16_t)((addr[i]*vdd)/4096);
+    	 break;
+
+     case BUF_F_DIFF2MV: // Differential readings to signed mV
+    	 for(i=0;i<n;i++)
+    		 ((int16_t*)addr)[i]=(int16_t)(((addr[i]-2048)*vdd)/2048);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in bufferConvertFunction");
+     }
+
+ return 0;
+ }
+
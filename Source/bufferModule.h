@@ -0,0 +1,36 @@
+/*
+ bufferModule.h
+ Buffer math functions header file
+
+ Reductions and in place operations over arrays
+ in user memory
+ */
+
+#ifndef _BUFFER_MODULE
+#define _BUFFER_MODULE
+
+// Element size codes
+//    1,2,4 : Unsigned bytes, unsigned halfs and cells
+//   -1,-2  : Signed bytes and signed halfs
+//   -4     : Same as 4
+#define BUF_MAX_ELEMENTS   65535   // Max number of elements
+
+// Function prototypes
+int32_t bufferSqrt64(uint64_t value);
+
+// Command functions
+int32_t bufferFunction(ContextType *context,int32_t value);
+#define BUF_F_SUM        0   // Sum of all elements
+#define BUF_F_MEAN       1   // Mean of all elements
+#define BUF_F_MAX        2   // Maximum and its index
+#define BUF_F_MIN        3   // Minimum and its index
+#define BUF_F_RMS        4   // Root mean square
+#define BUF_F_OFFSET     5   // Add offset in place
+#define BUF_F_SCALE      6   // Multiply and divide in place
+
+int32_t bufferConvertFunction(ContextType *context,int32_t value);
+#define BUF_F_SINGLE2MV  0   // Single readings to mV in place
+#define BUF_F_DIFF2MV    1   // Differential readings to mV in place
+
+#endif // _BUFFER_MODULE
+
@@ -16,6 +16,11 @@
 
 #include "gizmo.h"         // Main include for the project
 #include "chprintf.h"	   // chprintf function
+#include "imuModule.h"     // IMU sampling service
+#include "pwmModule.h"     // PWM duty streaming
+#include "captureModule.h" // Input capture
+#include "uartModule.h"    // UART data port
+#include "patternModule.h" // Pattern engine
 #include "buses.h"         // This module header
 
 // Gyroscope Variables --------------------------
@@ -61,6 +66,31 @@ int16_t SPI_Running=0; // SPI is not running now
 // SPI Chip Selects pins at SPI3 port
 const uint16_t SPI_ChipSelects[N_SPI_CS]={7,8,9,13};
 
+// SPI asynchronous buffer transfers
+static volatile int16_t SPI_AsyncBusy=0;  // Transfer in progress
+static int16_t SPI_AsyncSem=0;            // Semaphore to signal at the end
+
+// Semaphore array in thservices.c
+extern BinarySemaphore semaphores[MAX_SEMAPHORES];
+
+// I2C asynchronous transfers ---------------------
+
+// Transfer submitted to the I2C2 worker thread
+static struct
+  {
+  int32_t addr;        // 7bit address
+  uint8_t *tBuf;       // Write buffer
+  int32_t nt;          // Bytes to write
+  uint8_t *rBuf;       // Read buffer
+  int32_t nr;          // Bytes to read
+  int32_t sem;         // User semaphore to signal at the end
+  } I2C_Async;
+
+static volatile int16_t I2C_AsyncBusy=0;    // Transfer in progress
+static int32_t I2C_AsyncResult=0;           // Result of last transfer
+static BinarySemaphore I2C_AsyncStart;      // Wakes the worker thread
+static WORKING_AREA(waI2CThread,I2C_THREAD_WA);
+
 // Information for SPI configuration ---------------
 // The SPI configuration is defined in a typedef in
 // ChibiOS_2.6.2\os\hal\platforms\STM32\SPIv2
@@ -111,9 +141,12 @@ static const SPIConfig spi1cfg = {
 
 // SPI Data ---------------------------------------------------
 
+// SPI3 end of transfer callback
+static void spiEndCallback(SPIDriver *spip);
+
 // Configuration for SPI3
 static SPIConfig spi3cfg = {
-  NULL,             // No callback
+  spiEndCallback,   // Callback for async transfers
   SPI3_PORT,        // CS Port for SPI3
   SPI3_CS0_PIN,     // CS0 Pin
   // SPI CR1 Data
@@ -223,6 +256,18 @@ static void gyrRead(void)
  {
  uint8_t txBuf[8],rxBuf[8];
  int16_t *px,*py,*pz;
+ int16_t xyz[3];
+
+ // Use the IMU service sample if it is running
+ // as reading the registers would remove FIFO data
+ if (imuIsRunning())
+     {
+	 imuLatest(IMU_GYR,xyz);
+	 GyrX=((int32_t)xyz[0])-GyrZeroX;
+	 GyrY=((int32_t)xyz[1])-GyrZeroY;
+	 GyrZ=((int32_t)xyz[2])-GyrZeroZ;
+	 return;
+     }
 
  // Set pointers
  px=(int16_t*)&(rxBuf[1]);
@@ -240,6 +285,9 @@ static void gyrRead(void)
  txBuf[5]=0xff;     // Dummy value
  txBuf[6]=0xff;     // Dummy value
 
+ // Get exclusive access to the bus
+ spiAcquireBus(&SPID1);
+
  // Select the slave
  spiSelect(&SPID1);
 
@@ -249,6 +297,9 @@ static void gyrRead(void)
  // End of transmision
  spiUnselect(&SPID1);
 
+ // Release the bus
+ spiReleaseBus(&SPID1);
+
  // Set data
  GyrX=((int32_t)(*px))-GyrZeroX;
  GyrY=((int32_t)(*py))-GyrZeroY;
@@ -307,15 +358,58 @@ static void SPIStart(int32_t n)
  }
 
 // Ends SPI3 releasing slave
+// The driver is stopped to free its DMA channels
 static void SPIEnd(void)
  {
  // End of transmision
  spiUnselect(&SPID3);
 
+ // Release the driver
+ spiStop(&SPID3);
+
  // Set SPI  as not running
  SPI_Running=0;
  }
 
+// SPI3 end of transfer callback
+// Executes in interrupt context
+static void spiEndCallback(SPIDriver *spip)
+ {
+ UNUSED(spip);
+
+ // Only asynchronous transfers signal
+ if (!SPI_AsyncBusy) return;
+
+ chSysLockFromIsr();
+ chBSemSignalI(semaphores+SPI_AsyncSem);
+ SPI_AsyncBusy=0;
+ chSysUnlockFromIsr();
+ }
+
+// Check that SPI3 can start a new operation
+// Returns 0 if not
+static int32_t SPICheckReady(ContextType *context)
+ {
+ if (SPI_AsyncBusy)
+      {
+	  consoleErrorMessage(context,"SPI transfer in progress");
+	  return 0;
+      }
+ return 1;
+ }
+
+// Check that SPI3 is started
+// Returns 0 if not
+static int32_t SPICheckRunning(ContextType *context)
+ {
+ if (!SPI_Running)
+     {
+	 consoleErrorMessage(context,"SPI not started");
+	 return 0;
+     }
+ return 1;
+ }
+
 // SPI3 Exchange of one byte
 static int32_t SPIExchangeByte(int32_t data)
  {
@@ -354,6 +448,13 @@ static int32_t I2C_WriteRegister(I2CDriver *driver,I2CConfig *config
  // Message returned by i2c transmit function
  msg_t message;
 
+ // I2C DMA channels can be in use by other modules
+ if ((driver==&I2CD1)&&(pwmIsStreaming())) return 1;
+ if ((driver==&I2CD2)&&(captureIsRunning()||uartIsOpen())) return 1;
+
+ // Get exclusive access to the bus
+ i2cAcquireBus(driver);
+
  // Start I2C1
  i2cStart(driver,config);
 
@@ -372,6 +473,9 @@ static int32_t I2C_WriteRegister(I2CDriver *driver,I2CConfig *config
  // Stop the driver
  i2cStop(driver);
 
+ // Release the bus
+ i2cReleaseBus(driver);
+
  if (message==RDY_RESET) return 1;   // Operation error
 
  if (message==RDY_TIMEOUT) return 2;  // Timeout error
@@ -392,6 +496,13 @@ static int32_t I2C_ReadRegister(I2CDriver *driver,I2CConfig *config
  // Message returned by i2c transmit function
  msg_t message;
 
+ // I2C DMA channels can be in use by other modules
+ if ((driver==&I2CD1)&&(pwmIsStreaming())) return 1;
+ if ((driver==&I2CD2)&&(captureIsRunning()||uartIsOpen())) return 1;
+
+ // Get exclusive access to the bus
+ i2cAcquireBus(driver);
+
  // Start I2C1
  i2cStart(driver,config);
 
@@ -409,6 +520,9 @@ static int32_t I2C_ReadRegister(I2CDriver *driver,I2CConfig *config
  // Stop the driver
  i2cStop(driver);
 
+ // Release the bus
+ i2cReleaseBus(driver);
+
  if (message==RDY_RESET) return 1;   // Operation error
 
  if (message==RDY_TIMEOUT) return 2;  // Timeout error
@@ -429,22 +543,41 @@ static int32_t I2C_WriteAndRead(I2CDriver *driver,I2CConfig *config,int32_t addr
  {
  // Message returned by i2c transmit function
  msg_t message;
+ // Timeout grows with the transfer length
+ systime_t timeout=I2C_TIMEOUT_BASE+(nt+nr)/I2C_BYTES_PER_TICK;
+
+ // I2C DMA channels can be in use by other modules
+ if ((driver==&I2CD1)&&(pwmIsStreaming())) return 1;
+ if ((driver==&I2CD2)&&(captureIsRunning()||uartIsOpen())) return 1;
+
+ // Get exclusive access to the bus
+ i2cAcquireBus(driver);
 
  // Start I2C1
  i2cStart(driver,config);
 
  // Send command
- message=i2cMasterTransmitTimeout( driver,           // Driver
+ if ((!nt)&&(nr))
+   message=i2cMasterReceiveTimeout( driver,          // Driver
+		                            address,         // Device Address
+		                            rBuf,            // RX Buffer
+		                            nr,              // Bytes to receive
+		                            timeout);        // Timeout
+  else
+   message=i2cMasterTransmitTimeout( driver,           // Driver
 		                           address,          // Device Address
 	                               tBuf,             // TX Buffer
 	                               nt,               // Bytes to send
 	                               rBuf,             // RX Buffer
 	                               nr,               // Bytes to receive
-	                               50);            // 10ms timeout
+	                               timeout);         // Timeout
 
  // Stop the driver
  i2cStop(driver);
 
+ // Release the bus
+ i2cReleaseBus(driver);
+
  if (message==RDY_RESET) return 1;   // Operation error
 
  if (message==RDY_TIMEOUT) return 2;  // Timeout error
@@ -473,6 +606,61 @@ static int32_t I2C_Check(ContextType *context,int32_t addr,int32_t nreg)
  return 0;
  }
 
+// Try to get an I2C buffer from the stack ( buf n -- )
+// Zero bytes are allowed and then buf is not checked
+// but the whole transfer must have at least one byte
+// Returns 0 on error
+static int32_t getI2CBuffer(ContextType *context,uint8_t **buf,int32_t *n)
+ {
+ int32_t addr;
+
+ if (PstackPop(context,n)) return 0;
+ if (PstackPop(context,&addr)) return 0;
+
+ // Check size
+ if (((*n)<0)||((*n)>I2C_MAX_BUFFER))
+     {
+	 consoleErrorMessage(context,"Invalid number of bytes");
+	 return 0;
+     }
+
+ // Check buffer
+ if ((*n)&&(!portDmaBuffer((uint32_t)addr,*n)))
+     {
+	 consoleErrorMessage(context,"Invalid buffer");
+	 return 0;
+     }
+
+ (*buf)=(uint8_t*)addr;
+ return 1;
+ }
+
+// I2C2 worker thread for asynchronous transfers
+static msg_t I2CThread(void *arg)
+ {
+ UNUSED(arg);
+
+ while (1)
+    {
+	// Wait for a transfer
+	chBSemWait(&I2C_AsyncStart);
+
+	// Do it
+	I2C_AsyncResult=-I2C_WriteAndRead(&I2CD2,&i2c2cfg,I2C_Async.addr
+			                          ,I2C_Async.tBuf,I2C_Async.nt
+			                          ,I2C_Async.rBuf,I2C_Async.nr);
+
+	// Signal the end
+	chSysLock();
+	I2C_AsyncBusy=0;
+	chBSemSignalI(semaphores+I2C_Async.sem);
+	chSchRescheduleS();
+	chSysUnlock();
+    }
+
+ return 0;
+ }
+
 /************ ACCELEROMETER / MAGNETOMETER STATIC FUNCTIONS ******************/
 
 // Initializes the accelerometer
@@ -494,6 +682,18 @@ static void accelRead(void)
  uint8_t tBuf[2];      // Transmit buffer
  uint8_t Buf[6];       // Receive buffer
  int16_t *px,*py,*pz;  // 16 bit integer values
+ int16_t xyz[3];
+
+ // Use the IMU service sample if it is running
+ // as reading the registers would remove FIFO data
+ if (imuIsRunning())
+     {
+	 imuLatest(IMU_ACC,xyz);
+	 AccX=((int32_t)xyz[0])-AccZeroX;
+	 AccY=((int32_t)xyz[1])-AccZeroY;
+	 AccZ=((int32_t)xyz[2])-AccZeroZ;
+	 return;
+     }
 
  // Set pointers to match integers and bytes
  px=(int16_t*)&(Buf[0]);
@@ -548,11 +748,21 @@ static void magnetInit(void)
 // and places the result on MagX,MagY,MagZ
 static void magnetRead(void)
  {
- int32_t value;
  uint8_t tBuf[2];
  uint8_t rBuf[6];
  volatile uint8_t Buf[6];
  volatile int16_t *px,*py,*pz;
+ int16_t xyz[3];
+
+ // Use the IMU service sample if it is running
+ if (imuIsRunning())
+     {
+	 imuLatest(IMU_MAG,xyz);
+	 MagX=((int32_t)xyz[0])-MagZeroX;
+	 MagY=((int32_t)xyz[1])-MagZeroY;
+	 MagZ=((int32_t)xyz[2])-MagZeroZ;
+	 return;
+     }
 
  // Set pointers
  px=(int16_t*)&(Buf[0]);
@@ -565,9 +775,6 @@ static void magnetRead(void)
  // Read six registers
  I2C_WriteAndRead(&I2CD1,&i2c1cfg,MAGNET_ADDR,tBuf,1,rBuf,6);
 
- // Read also status register
- I2C_ReadRegister(&I2CD1,&i2c1cfg,MAGNET_ADDR,0x09,&value);
-
  // Reorder data for LSB and MSB
  Buf[0]=rBuf[1]; Buf[1]=rBuf[0];
  Buf[2]=rBuf[3]; Buf[3]=rBuf[2];
@@ -598,6 +805,81 @@ void busesInit(void)
 
  // Initializes I2C Channel 2
  I2C2init();
+
+ // Asynchronous I2C2 transfers worker
+ chBSemInit(&I2C_AsyncStart,TRUE);
+ chThdCreateStatic(waI2CThread,sizeof(waI2CThread),I2C_THREAD_PRIO,I2CThread,NULL);
+ }
+
+// Reads n consecutive gyroscope registers starting at reg
+// Returns 0 (SPI has no error information)
+int32_t busesGyrRead(int32_t reg,uint8_t *buf,int32_t n)
+ {
+ uint8_t tx;
+
+ // Read and autoincrement flags
+ tx=0x80|0x40|reg;
+
+ spiAcquireBus(&SPID1);
+ spiSelect(&SPID1);
+
+ // Send register and read data
+ spiSend(&SPID1,1,&tx);
+ spiReceive(&SPID1,n,buf);
+
+ spiUnselect(&SPID1);
+ spiReleaseBus(&SPID1);
+
+ return 0;
+ }
+
+// Writes one gyroscope register
+void busesGyrWrite(int32_t reg,int32_t value)
+ {
+ uint8_t txBuf[2],rxBuf[2];
+
+ txBuf[0]=reg;
+ txBuf[1]=value;
+
+ spiAcquireBus(&SPID1);
+ spiSelect(&SPID1);
+ spiExchange(&SPID1,2,txBuf,rxBuf);
+ spiUnselect(&SPID1);
+ spiReleaseBus(&SPID1);
+ }
+
+// Reads n registers of a I2C1 sensor in one transfer
+// Set bit 7 of reg for accelerometer autoincrement
+// Returns 0 if Ok
+int32_t busesSensorRead(int32_t addr,int32_t reg,uint8_t *buf,int32_t n)
+ {
+ uint8_t tBuf[2];
+
+ tBuf[0]=reg;
+ return I2C_WriteAndRead(&I2CD1,&i2c1cfg,addr,tBuf,1,buf,n);
+ }
+
+// Writes one register of a I2C1 sensor
+// Returns 0 if Ok
+int32_t busesSensorWrite(int32_t addr,int32_t reg,int32_t value)
+ {
+ return I2C_WriteRegister(&I2CD1,&i2c1cfg,addr,reg,value);
+ }
+
+// Gets the zero values of a sensor
+void busesZero(int32_t sensor,int32_t *zero)
+ {
+ switch (sensor)
+     {
+     case IMU_GYR:
+    	 zero[0]=GyrZeroX; zero[1]=GyrZeroY; zero[2]=GyrZeroZ;
+    	 break;
+     case IMU_ACC:
+    	 zero[0]=AccZeroX; zero[1]=AccZeroY; zero[2]=AccZeroZ;
+    	 break;
+     default:
+    	 zero[0]=MagZeroX; zero[1]=MagZeroY; zero[2]=MagZeroZ;
+     }
  }
 
 /********************* COMMAND FUNCTIONS ************************************/
@@ -694,16 +976,26 @@ int32_t busesFunction(ContextType *context,int32_t value)
     	 break;
 
      case SPI_F_START:    // Starts on selected channel
+    	 if (!SPICheckReady(context)) return 0;
+    	 // SPI3 RX DMA is shared with the pattern engine
+    	 if (patternDmaInUse())
+    	       {
+    		   consoleErrorMessage(context,"SPI DMA used by pattern engine");
+    		   return 0;
+    	       }
     	 if (!PstackPop(context,&data)) // Try to pop one value
     		   if ((data>=0)&&(data<N_SPI_CS))  // Check number of slave
     			   SPIStart(data);
          break;
 
      case SPI_F_END:    // Ends on selected channel
+    	 if (!SPICheckReady(context)) return 0;
     	 SPIEnd();
     	 break;
 
      case SPI_F_EX8:    // Exchange a Byte
+    	 if (!SPICheckReady(context)) return 0;
+    	 if (!SPICheckRunning(context)) return 0;
     	 if (!PstackPop(context,&data)) // Try to pop one value
     		 if ((data>=0)&&(data<256))  // Check range
     		     {
@@ -853,7 +1145,8 @@ int32_t internalRegistersFunction(ContextType *context,int32_t value)
     	txBuf[0]=nreg; txBuf[1]=0xFF;
     	txBuf[0]|=0x80;     // Read Flag in register number
 
-    	// Select the slave
+    	// Select the slave with exclusive access
+    	spiAcquireBus(&SPID1);
     	spiSelect(&SPID1);
 
     	// Exchange data
@@ -861,6 +1154,7 @@ int32_t internalRegistersFunction(ContextType *context,int32_t value)
 
     	// End of transmision
     	spiUnselect(&SPID1);
+    	spiReleaseBus(&SPID1);
 
     	// Push obtained result
     	data=rxBuf[1];
@@ -882,7 +1176,8 @@ int32_t internalRegistersFunction(ContextType *context,int32_t value)
     	// Set tx buffer
     	txBuf[0]=nreg; txBuf[1]=data;
 
-    	// Select the slave
+    	// Select the slave with exclusive access
+    	spiAcquireBus(&SPID1);
     	spiSelect(&SPID1);
 
     	// Exchange data
@@ -890,6 +1185,7 @@ int32_t internalRegistersFunction(ContextType *context,int32_t value)
 
     	// End of transmision
     	spiUnselect(&SPID1);
+    	spiReleaseBus(&SPID1);
     	break;
 
     case INTREG_F_FRR:  // Read Accelerometer register
@@ -968,6 +1264,9 @@ int32_t spiNexangeFunction(ContextType *context,int32_t value)
  uint8_t tx[STACK_SIZE],rx[STACK_SIZE];   // Data arrays
  int32_t n,i,pos;
 
+ if (!SPICheckReady(context)) return 0;
+ if (!SPICheckRunning(context)) return 0;
+
  if (PstackPop(context,&n)) return 0; // Try to pop number of bytes to transfer
 
  // Check if there are enough elements
@@ -1001,6 +1300,80 @@ int32_t spiNexangeFunction(ContextType *context,int32_t value)
  return 0;
  }
 
+// SPI transfer between user memory buffers
+// Data moves by DMA so buffers cannot be in the PAD (CCM)
+// A zero txaddr sends 0xFF bytes and a zero rxaddr discards the data
+// Includes:
+//   SPI_F_BUF_SYNC     Transfer  ( txaddr rxaddr n -- )
+//   SPI_F_BUF_ASYNC    Start transfer and signal usem at the end
+//                                ( txaddr rxaddr n usem -- )
+//   SPI_F_BUF_BUSY     Check async transfer ( -- f )
+int32_t spiBufferFunction(ContextType *context,int32_t value)
+ {
+ int32_t tx,rx,n,sem=0;
+
+ // Busy check needs no parameters
+ if (value==SPI_F_BUF_BUSY)
+     {
+	 PstackPush(context,SPI_AsyncBusy?FTRUE:FFALSE);
+	 return 0;
+     }
+
+ // Get parameters
+ if (value==SPI_F_BUF_ASYNC)
+	 if (PstackPop(context,&sem)) return 0;
+ if (PstackPop(context,&n)) return 0;
+ if (PstackPop(context,&rx)) return 0;
+ if (PstackPop(context,&tx)) return 0;
+
+ // Check them
+ if ((sem<0)||(sem>=MAX_SEMAPHORES))
+     {
+	 consoleErrorMessage(context,"Invalid semaphore number");
+	 return 0;
+     }
+ if ((n<1)||(n>SPI_MAX_BUFFER))
+     {
+	 consoleErrorMessage(context,"Invalid number of bytes");
+	 return 0;
+     }
+ if (((tx)&&(!portDmaBuffer((uint32_t)tx,n)))
+	 ||((rx)&&(!portDmaBuffer((uint32_t)rx,n))))
+     {
+	 consoleErrorMessage(context,"Invalid buffer");
+	 return 0;
+     }
+ if (!SPICheckRunning(context)) return 0;
+ if (!SPICheckReady(context)) return 0;
+
+ // Synchronous transfer
+ if (value==SPI_F_BUF_SYNC)
+     {
+	 if (!rx)
+		 spiSend(&SPID3,n,(void*)tx);
+	    else
+	     if (!tx)
+	    	 spiReceive(&SPID3,n,(void*)rx);
+	        else
+	         spiExchange(&SPID3,n,(void*)tx,(void*)rx);
+	 return 0;
+     }
+
+ // Asynchronous transfer
+ chBSemReset(semaphores+sem,TRUE);
+ SPI_AsyncSem=sem;
+ SPI_AsyncBusy=1;
+ if (!rx)
+	 spiStartSend(&SPID3,n,(void*)tx);
+    else
+     if (!tx)
+    	 spiStartReceive(&SPID3,n,(void*)rx);
+        else
+         spiStartExchange(&SPID3,n,(void*)tx,(void*)rx);
+
+ return 0;
+ }
+
 // SPI set speed to operate
 // Pops selected speed in kHz
 // Range is from 150 to 16000
@@ -1409,3 +1782,112 @@ void magnetTest(void)
  consolePrintf("%",BREAK);
  }
 #endif //TEST_MAGNET
+
+// I2C transfers between user memory buffers on I2C2
+// Buffers are moved by DMA so they cannot be in the PAD (CCM)
+// Includes:
+//   I2C_F_BUF_WRITE   Write buffer         ( addr buf n -- )
+//   I2C_F_BUF_READ    Read to buffer       ( addr buf n -- )
+//   I2C_F_BUF_REGS    Burst register read with one start condition
+//                                          ( addr reg buf n -- )
+//   I2C_F_BUF_TRANS   Write and then read with a repeated start
+//                                          ( addr txbuf nt rxbuf nr -- )
+//   I2C_F_BUF_ASYNC   Start a transfer and signal usem at the end
+//                                          ( addr txbuf nt rxbuf nr usem -- )
+//   I2C_F_BUF_BUSY    Check async transfer ( -- f )
+//   I2C_F_BUF_RESULT  Result of last async transfer ( -- n )
+//                     0 Ok  -1 Operation error  -2 Timeout
+int32_t i2cBufferFunction(ContextType *context,int32_t value)
+ {
+ int32_t addr,reg,nt=0,nr=0,sem=0,error;
+ uint8_t *tBuf=NULL,*rBuf=NULL;
+ uint8_t regBuf[1];
+
+ switch (value)
+     {
+     case I2C_F_BUF_BUSY:
+    	 PstackPush(context,I2C_AsyncBusy?FTRUE:FFALSE);
+    	 return 0;
+
+     case I2C_F_BUF_RESULT:
+    	 PstackPush(context,I2C_AsyncResult);
+    	 return 0;
+
+     case I2C_F_BUF_WRITE:
+    	 if (!getI2CBuffer(context,&tBuf,&nt)) return 0;
+    	 break;
+
+     case I2C_F_BUF_READ:
+    	 if (!getI2CBuffer(context,&rBuf,&nr)) return 0;
+    	 break;
+
+     case I2C_F_BUF_REGS:
+    	 if (!getI2CBuffer(context,&rBuf,&nr)) return 0;
+    	 if (PstackPop(context,&reg)) return 0;
+    	 if ((reg<0)||(reg>255))
+    	      {
+    		  consoleErrorMessage(context,"Invalid 8bit I2C register");
+    		  return 0;
+    	      }
+    	 regBuf[0]=reg;
+    	 tBuf=regBuf;
+    	 nt=1;
+    	 break;
+
+     case I2C_F_BUF_ASYNC:
+    	 if (PstackPop(context,&sem)) return 0;
+    	 if ((sem<0)||(sem>=MAX_SEMAPHORES))
+    	      {
+    		  consoleErrorMessage(context,"Invalid semaphore number");
+    		  return 0;
+    	      }
+    	 // Continue to get the buffers
+     case I2C_F_BUF_TRANS:
+    	 if (!getI2CBuffer(context,&rBuf,&nr)) return 0;
+    	 if (!getI2CBuffer(context,&tBuf,&nt)) return 0;
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in i2cBufferFunction");
+    	 return 0;
+     }
+
+ // Get and check address
+ if (PstackPop(context,&addr)) return 0;
+ if (I2C_Check(context,addr,0)) return 0;
+
+ // The driver needs at least one byte
+ if (!(nt+nr))
+     {
+	 consoleErrorMessage(context,"No bytes to transfer");
+	 return 0;
+     }
+
+ // Asynchronous transfer
+ if (value==I2C_F_BUF_ASYNC)
+     {
+	 if (I2C_AsyncBusy)
+	      {
+		  consoleErrorMessage(context,"I2C transfer in progress");
+		  return 0;
+	      }
+	 I2C_Async.addr=addr;
+	 I2C_Async.tBuf=tBuf;
+	 I2C_Async.nt=nt;
+	 I2C_Async.rBuf=rBuf;
+	 I2C_Async.nr=nr;
+	 I2C_Async.sem=sem;
+	 chBSemReset(semaphores+sem,TRUE);
+	 I2C_AsyncBusy=1;
+	 chBSemSignal(&I2C_AsyncStart);
+	 return 0;
+     }
+
+ // Synchronous transfer
+ error=I2C_WriteAndRead(&I2CD2,&i2c2cfg,addr,tBuf,nt,rBuf,nr);
+ if (error)
+	 consoleErrorInt(context,"Transfer error: ",-error);
+
+ return 0;
+ }
+
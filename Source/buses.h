@@ -51,11 +51,16 @@
 #define GYR_Z_L    0x2C
 #define GYR_Z_H    0x2D
 
+// FIFO control (RW) and source (R) registers
+#define GYR_FIFO_CTRL  0x2E
+#define GYR_FIFO_SRC   0x2F
+
 // There are more registers but they are not listed here
 
 // SPI2 definitions ------------------------------------
 
 #define N_SPI_CS    4  // Number of SPI Chip Selects 0..3
+#define SPI_MAX_BUFFER  65535  // Max bytes in one buffer transfer (DMA limit)
 
 // I2C definitions ------------------------------------
 
@@ -65,6 +70,12 @@ typedef struct
   uint32_t TIMINGR;
   } I2C_Speed_Data;
 
+#define I2C_MAX_BUFFER     255   // Max bytes in each direction (NBYTES field)
+#define I2C_TIMEOUT_BASE   50    // Minimum transfer timeout (ticks)
+#define I2C_BYTES_PER_TICK 4     // Timeout increase with length (50kHz worst case)
+#define I2C_THREAD_WA      256   // Async transfers thread working area
+#define I2C_THREAD_PRIO    (NORMALPRIO+10)
+
 // Accelerometer information ------------------------------------
 //
 // By default the end of scale is +/-2g
@@ -93,6 +104,10 @@ typedef struct
 // Bit 1: Y Enable
 // Bit 0: X Enable
 
+// Interrupt and FIFO enable control registers
+#define ACCEL_CTRL_REG3_A    0x22
+#define ACCEL_CTRL_REG5_A    0x24
+
 // Output registers for X,Y,Z Low and High Bytes
 #define ACCE_OUT_XL  0x28
 #define ACCE_OUT_XH  0x29
@@ -101,6 +116,10 @@ typedef struct
 #define ACCE_OUT_ZL  0x2C
 #define ACCE_OUT_ZH  0x2D
 
+// FIFO control (RW) and source (R) registers
+#define ACCEL_FIFO_CTRL_A    0x2E
+#define ACCEL_FIFO_SRC_A     0x2F
+
 // The rest of registers are not considered in this program
 
 // Magnetometer information -----------------------------
@@ -192,12 +211,34 @@ typedef struct
 // Public functions -----------------------------------
 void busesInit(void);
 
+// Sensor register access
+// Reads return 0 if Ok
+int32_t busesGyrRead(int32_t reg,uint8_t *buf,int32_t n);
+void busesGyrWrite(int32_t reg,int32_t value);
+int32_t busesSensorRead(int32_t addr,int32_t reg,uint8_t *buf,int32_t n);
+int32_t busesSensorWrite(int32_t addr,int32_t reg,int32_t value);
+
+// Zero values of a sensor (IMU_GYR, IMU_ACC or IMU_MAG)
+void busesZero(int32_t sensor,int32_t *zero);
+
 // Command functions
 int32_t busesFunction(ContextType *context,int32_t value);
 int32_t spiNexangeFunction(ContextType *context,int32_t value);
 int32_t spiSetSpeed(ContextType *context,int32_t value);
+int32_t spiBufferFunction(ContextType *context,int32_t value);
+#define SPI_F_BUF_SYNC      0    // Buffer transfer
+#define SPI_F_BUF_ASYNC     1    // Asynchronous buffer transfer
+#define SPI_F_BUF_BUSY      2    // Asynchronous transfer in progress
 int32_t i2cSetSpeed(ContextType *context,int32_t value);
 int32_t i2cTransfer(ContextType *context,int32_t value);
+int32_t i2cBufferFunction(ContextType *context,int32_t value);
+#define I2C_F_BUF_WRITE     0    // Write buffer
+#define I2C_F_BUF_READ      1    // Read to buffer
+#define I2C_F_BUF_REGS      2    // Burst register read
+#define I2C_F_BUF_TRANS     3    // Write and read
+#define I2C_F_BUF_ASYNC     4    // Asynchronous write and read
+#define I2C_F_BUF_BUSY      5    // Asynchronous transfer in progress
+#define I2C_F_BUF_RESULT    6    // Result of last asynchronous transfer
 int32_t internalRegistersFunction(ContextType *context,int32_t value);
 
 // Public test functions
@@ -0,0 +1,214 @@
+/*
+ captureModule.c
+ Input capture measurement source file
+
+ TIM2 works in PWM input mode. TI1 rising edges capture the
+ period in CCR1 and reset the counter and TI1 falling edges
+ capture the high time in CCR2
+
+ Each CC1 event requests a DMA burst that reads CCR1 and CCR2
+ into the next ring position so the measurement runs in
+ hardware. The DMA half and full interrupts count the captures
+
+ DMA1 Channel 5 is also used by the I2C2 driver so the I2C2
+ bus cannot be used while the measurement is running. It is
+ also the RX channel of the UART data port so the measurement
+ cannot start while the port is open
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"           // Main include for the project
+#include "captureModule.h"   // This module header
+
+// Capture ring
+static CapSample capRing[CAP_RING_SIZE];
+
+// Number of half rings completed
+static volatile uint32_t capHalves=0;
+
+// Running flag
+static int32_t capRunning=0;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// DMA interrupt callback
+// Counts the completed halves of the ring
+static void capDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+
+ if (flags&STM32_DMA_ISR_HTIF) capHalves++;
+ if (flags&STM32_DMA_ISR_TCIF) capHalves++;
+ }
+
+// Get the number of captures and the last one
+// Returns 0 if there is no capture yet
+static int32_t capLast(CapSample *sample,uint32_t *count)
+ {
+ uint32_t halves,pairs;
+
+ // Read a coherent pair of counters
+ do
+   {
+   halves=capHalves;
+   pairs=(CAP_RING_SIZE*2-dmaStreamGetTransactionSize(CAP_DMA_STREAM))/2;
+   }
+   while (halves!=capHalves);
+
+ (*count)=halves*(CAP_RING_SIZE/2)+(pairs%(CAP_RING_SIZE/2));
+ if (!(*count)) return 0;
+
+ // Last complete capture
+ (*sample)=capRing[(pairs+CAP_RING_SIZE-1)%CAP_RING_SIZE];
+
+ return 1;
+ }
+
+// Stops the measurement
+static void capStop(void)
+ {
+ if (!capRunning) return;
+
+ CAP_TIMER->CR1=0;
+ CAP_TIMER->DIER=0;
+ dmaStreamDisable(CAP_DMA_STREAM);
+ dmaStreamRelease(CAP_DMA_STREAM);
+
+ // Line back to input
+ palSetPadMode(CAP_PORT,CAP_PIN,PAL_MODE_INPUT);
+
+ capRunning=0;
+ }
+
+// Starts the measurement
+static void capStart(ContextType *context)
+ {
+ // Restart if running
+ capStop();
+
+ // Try to allocate the DMA
+ if (dmaStreamAllocate(CAP_DMA_STREAM,CAP_IRQ_PRIORITY,capDmaCallback,NULL))
+      {
+	  consoleErrorMessage(context,"Capture DMA is busy");
+	  return;
+      }
+ capRunning=1;
+ capHalves=0;
+
+ // Input line to the timer
+ palSetPadMode(CAP_PORT,CAP_PIN,PAL_MODE_ALTERNATE(CAP_AF));
+
+ // Free running 32 bit counter at the timer clock
+ CAP_TIMER->CR1=0;
+ CAP_TIMER->PSC=0;
+ CAP_TIMER->ARR=0xFFFFFFFF;
+
+ // IC1 on TI1 rising edges and IC2 on TI1 falling edges
+ CAP_TIMER->CCER=0;
+ CAP_TIMER->CCMR1=TIM_CCMR1_CC1S_0|(CAP_FILTER<<4)
+		         |TIM_CCMR1_CC2S_1|(CAP_FILTER<<12);
+ CAP_TIMER->CCER=TIM_CCER_CC1E|TIM_CCER_CC2E|TIM_CCER_CC2P;
+
+ // Reset the counter on TI1FP1
+ CAP_TIMER->SMCR=(5<<4)|4;
+
+ // DMA burst of CCR1 and CCR2 on each CC1 event
+ CAP_TIMER->DCR=(1<<8)|CAP_DBA_CCR1;
+ dmaStreamSetPeripheral(CAP_DMA_STREAM,&(CAP_TIMER->DMAR));
+ dmaStreamSetMemory0(CAP_DMA_STREAM,capRing);
+ dmaStreamSetTransactionSize(CAP_DMA_STREAM,CAP_RING_SIZE*2);
+ dmaStreamSetMode(CAP_DMA_STREAM,STM32_DMA_CR_DIR_P2M|STM32_DMA_CR_MINC
+		          |STM32_DMA_CR_PSIZE_WORD|STM32_DMA_CR_MSIZE_WORD
+		          |STM32_DMA_CR_CIRC|STM32_DMA_CR_HTIE|STM32_DMA_CR_TCIE
+		          |STM32_DMA_CR_PL(CAP_DMA_PRIORITY));
+ dmaStreamEnable(CAP_DMA_STREAM);
+
+ // Start the counter
+ CAP_TIMER->EGR=TIM_EGR_UG;
+ CAP_TIMER->SR=0;
+ CAP_TIMER->DIER=TIM_DIER_CC1DE;
+ CAP_TIMER->CR1=TIM_CR1_CEN;
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void captureModuleInit(void)
+ {
+ // Enable capture timer clock
+ RCC->APB1ENR|=RCC_APB1ENR_TIM2EN;
+ }
+
+// Gives non zero if the measurement is using the DMA
+int32_t captureIsRunning(void)
+ {
+ return capRunning;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic capture function
+int32_t captureFunction(ContextType *context,int32_t value)
+ {
+ CapSample sample;
+ uint32_t count;
+ int32_t valid;
+
+ switch (value)
+     {
+     case CAP_F_START: // Start measurement
+    	 capStart(context);
+    	 return 0;
+
+     case CAP_F_STOP: // Stop measurement
+    	 capStop();
+    	 return 0;
+     }
+
+ // Measurement values
+ valid=0;
+ count=0;
+ if (capRunning) valid=capLast(&sample,&count);
+ if (valid&&(!sample.Period)) valid=0;
+
+ switch (value)
+     {
+     case CAP_F_TICKS: // Period in clock counts ( -- n )
+    	 PstackPush(context,valid?(int32_t)sample.Period:0);
+    	 break;
+
+     case CAP_F_PERIOD: // Period in us ( -- n )
+    	 PstackPush(context,valid?(int32_t)(sample.Period/CAP_TIMER_MHZ):0);
+    	 break;
+
+     case CAP_F_FREQ: // Frequency in mHz ( -- n )
+    	 PstackPush(context,valid?(int32_t)((1000ULL*CAP_TIMER_CLOCK)/sample.Period):0);
+    	 break;
+
+     case CAP_F_DUTY: // Duty cycle ( -- n )
+    	 PstackPush(context,valid?(int32_t)(((uint64_t)sample.High*CAP_DUTY_SCALE)/sample.Period):0);
+    	 break;
+
+     case CAP_F_HIGH: // High time in us ( -- n )
+    	 PstackPush(context,valid?(int32_t)(sample.High/CAP_TIMER_MHZ):0);
+    	 break;
+
+     case CAP_F_COUNT: // Number of captures ( -- n )
+    	 PstackPush(context,(int32_t)count);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in captureFunction");
+     }
+
+ return 0;
+ }
+
@@ -0,0 +1,54 @@
+/*
+ captureModule.h
+ Input capture measurement header file
+
+ TIM2 in PWM input mode measures period and high time of the
+ signal on GPIO line 1 (PD3) and DMA1 Channel 5 stores them
+ in a ring in RAM
+ */
+
+#ifndef _CAPTURE_MODULE
+#define _CAPTURE_MODULE
+
+// Hardware used for this module
+#define CAP_TIMER            TIM2                // Capture timer (32 bit)
+#define CAP_DMA_STREAM       STM32_DMA1_STREAM5  // TIM2 CH1 DMA channel
+#define CAP_DMA_PRIORITY     2                   // DMA priority (0..3)
+#define CAP_IRQ_PRIORITY     6                   // DMA IRQ priority
+#define CAP_PORT             GPIOD               // Input port
+#define CAP_PIN              3                   // TIM2 CH1 (GPIO line 1)
+#define CAP_AF               2                   // Alternate function
+#define CAP_DBA_CCR1         13                  // CCR1 offset in timer registers
+#define CAP_FILTER           2                   // Input filter (fck N=4)
+
+// Measurement definitions
+#define CAP_TIMER_CLOCK      72000000    // TIM2 clock (f APB1 x 2)
+#define CAP_TIMER_MHZ        72          // Timer clock in MHz
+#define CAP_RING_SIZE        16          // Captures in the ring (even)
+#define CAP_DUTY_SCALE       10000       // Duty cycle is given in 1/10000
+
+// One capture in the ring as read by the DMA burst
+typedef struct
+ {
+ uint32_t Period;     // CCR1: Clock counts between rising edges
+ uint32_t High;       // CCR2: Clock counts at high level
+ }
+ CapSample;
+
+// Function prototypes
+void captureModuleInit(void);
+int32_t captureIsRunning(void);
+
+// Command functions
+int32_t captureFunction(ContextType *context,int32_t value);
+#define CAP_F_START       0   // Start measurement
+#define CAP_F_STOP        1   // Stop measurement
+#define CAP_F_TICKS       2   // Last period in clock counts
+#define CAP_F_PERIOD      3   // Last period in us
+#define CAP_F_FREQ        4   // Last frequency in mHz
+#define CAP_F_DUTY        5   // Last duty cycle
+#define CAP_F_HIGH        6   // Last high time in us
+#define CAP_F_COUNT       7   // Number of captures
+
+#endif // _CAPTURE_MODULE
+
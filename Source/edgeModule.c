@@ -0,0 +1,385 @@
+/*
+ edgeModule.c
+ GPIO edge events source file
+
+ Each GPIO line uses the EXTI channel of its pin number.
+ The interrupt counts the edge, measures the time from the
+ previous one and pushes the timestamp in the line queue
+
+ Events are taken from the queue with EdgeWait or are
+ given to a callback word that executes in the edge thread
+ with the event time on the stack
+
+ GPIO lines 0 and 2 (PD2 and PD4) share their EXTI channels with
+ the magnetometer and accelerometer interrupts so they cannot be
+ used while the IMU service is running
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+#include "fm_register.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "gpioModule.h"    // GPIO module header
+#include "timeModule.h"    // Microsecond clock
+#include "imuModule.h"     // IMU service
+#include "edgeModule.h"    // This module header
+
+// GPIO Array in gpioModule.c
+extern const uint16_t GpioArray[10];
+
+// Line data
+static EdgeLine edgeLines[EDGE_NLINES];
+
+// Line associated to each EXTI channel (-1 if none)
+static int8_t edgeChannelLine[16];
+
+// Callback thread
+static WORKING_AREA(waEdgeThread,EDGE_THREAD_WA);
+static BinarySemaphore EdgeSemaphore;
+static ContextType EdgeContext;
+
+// Semaphores to wake waiting threads
+static BinarySemaphore EdgeWaitSem[EDGE_NLINES];
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// EXTI callback
+// Executes in interrupt context
+static void edgeExtCallback(EXTDriver *extp,expchannel_t channel)
+ {
+ EdgeLine *pLine;
+ int32_t line;
+ uint32_t now;
+
+ UNUSED(extp);
+
+ line=edgeChannelLine[channel];
+ if (line<0) return;
+ pLine=edgeLines+line;
+
+ chSysLockFromIsr();
+
+ now=timeMicrosI();
+
+ // Counters
+ pLine->Period=now-pLine->Last;
+ pLine->Last=now;
+ pLine->Count++;
+
+ // Queue the event
+ if ((pLine->Head-pLine->Tail)<EDGE_QUEUE_SIZE)
+     {
+	 pLine->Time[pLine->Head&(EDGE_QUEUE_SIZE-1)]=now;
+	 pLine->Head++;
+     }
+    else
+     pLine->Lost++;
+
+ // Wake the consumer
+ if (pLine->Word!=NO_WORD)
+	 chBSemSignalI(&EdgeSemaphore);
+    else
+     chBSemSignalI(EdgeWaitSem+line);
+
+ chSysUnlockFromIsr();
+ }
+
+// Takes one event from a line queue
+// Returns 0 if the queue is empty
+static int32_t edgePop(EdgeLine *pLine,uint32_t *time)
+ {
+ if (pLine->Head==pLine->Tail) return 0;
+
+ (*time)=pLine->Time[pLine->Tail&(EDGE_QUEUE_SIZE-1)];
+ pLine->Tail++;
+
+ return 1;
+ }
+
+// Callback thread
+// Executes the callback words for the queued events
+static msg_t edgeThread(void *arg)
+ {
+ int32_t line,any;
+ uint32_t time;
+ uint16_t word;
+
+ UNUSED(arg);
+
+ while (1)
+    {
+	chBSemWait(&EdgeSemaphore);
+
+	// Drain all lines with callbacks
+	do
+	  {
+	  any=0;
+	  for(line=0;line<EDGE_NLINES;line++)
+	      {
+		  word=edgeLines[line].Word;
+		  if (word==NO_WORD) continue;
+		  if (!edgePop(edgeLines+line,&time)) continue;
+
+		  // Execute the word with the event time
+		  PstackInit(&EdgeContext);
+		  RstackInit(&EdgeContext);
+		  clearContextAbort(&EdgeContext);
+		  PstackPush(&EdgeContext,(int32_t)time);
+		  programExecute(&EdgeContext,word,0);
+		  any=1;
+	      }
+	  }
+	  while (any);
+    }
+
+ return 0;
+ }
+
+// Programs the EXTI channel of a line
+static void edgeLineSet(int32_t line,int32_t mode)
+ {
+ static const uint32_t extModes[4]={EXT_CH_MODE_DISABLED,EXT_CH_MODE_RISING_EDGE
+		                           ,EXT_CH_MODE_FALLING_EDGE,EXT_CH_MODE_BOTH_EDGES};
+ int32_t channel=GpioArray[line];
+
+ // Disable before changing the line data
+ gpioExtSet(channel,EXT_CH_MODE_DISABLED,NULL);
+ edgeChannelLine[channel]=-1;
+ edgeLines[line].Mode=mode;
+
+ if (mode==EDGE_MODE_NONE) return;
+
+ edgeChannelLine[channel]=line;
+ gpioExtSet(channel,extModes[mode]|EXT_MODE_GPIOD,edgeExtCallback);
+ }
+
+// Clears the queue and counters of a line
+static void edgeLineClear(int32_t line)
+ {
+ EdgeLine *pLine=edgeLines+line;
+
+ chSysLock();
+ pLine->Tail=pLine->Head;
+ pLine->Count=0;
+ pLine->Lost=0;
+ pLine->Period=0;
+ chSysUnlock();
+ }
+
+// Try to get a line number from the stack
+// Returns 0 on error
+static int32_t getLine(ContextType *context,int32_t *line)
+ {
+ if (PstackPop(context,line)) return 0;
+
+ if (((*line)<0)||((*line)>=EDGE_NLINES))
+      {
+	  consoleErrorMessage(context,"Invalid line");
+	  return 0;
+      }
+
+ return 1; // Ok
+ }
+
+// Try to get word number
+// Returns 0 on error
+static int32_t getWord(ContextType *context,int32_t *pos)
+ {
+ char *name;
+
+ // Get word to dump
+ name=tokenGet();
+
+ // Check if name is noword
+ if (!strCaseCmp(name,"NOWORD")) return NO_WORD;
+
+ // Locate this user word
+ (*pos)=locateUserWord(name);
+
+ // Error if not found
+ if ((*pos)==(int32_t)NO_WORD)
+     {
+	 consoleErrorMessage(context,"Word not found");
+	 return 0;
+     }
+
+ return 1; // Ok
+ }
+
+// Wait for an event of a line ( line ums -- time f )
+static void edgeWait(ContextType *context)
+ {
+ int32_t line,timeout;
+ uint32_t time;
+ systime_t start;
+
+ if (PstackPop(context,&timeout)) return;
+ if (!getLine(context,&line)) return;
+
+ if (edgeLines[line].Word!=NO_WORD)
+      {
+	  consoleErrorMessage(context,"Line has a callback word");
+	  return;
+      }
+
+ start=chTimeNow();
+ while (!edgePop(edgeLines+line,&time))
+     {
+	 // Check timeout
+	 if ((timeout>=0)&&((int32_t)(chTimeNow()-start)>=timeout))
+	      {
+		  PstackPush(context,0);
+		  PstackPush(context,FFALSE);
+		  return;
+	      }
+
+	 // Check abort
+	 if (PORT_ABORT)
+	      {
+		  runtimeErrorMessage(context,"Edge wait aborted");
+		  return;
+	      }
+
+	 chBSemWaitTimeout(EdgeWaitSem+line,EDGE_WAIT_POLL);
+     }
+
+ PstackPush(context,(int32_t)time);
+ PstackPush(context,FTRUE);
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void edgeModuleInit(void)
+ {
+ int32_t i;
+
+ for(i=0;i<16;i++)
+	 edgeChannelLine[i]=-1;
+
+ for(i=0;i<EDGE_NLINES;i++)
+     {
+	 edgeLines[i].Word=NO_WORD;
+	 edgeLines[i].Mode=EDGE_MODE_NONE;
+	 chBSemInit(EdgeWaitSem+i,TRUE);
+     }
+
+ // Callback context
+ EdgeContext.Process=FOREGROUND;
+ EdgeContext.VerboseLevel=0;
+ EdgeContext.Flags=0;
+
+ // Callback thread
+ chBSemInit(&EdgeSemaphore,TRUE);
+ chThdCreateStatic(waEdgeThread,sizeof(waEdgeThread),EDGE_THREAD_PRIO,edgeThread,NULL);
+ }
+
+// Check if there is any edge callback
+int32_t isAnyEdgeCallback(void)
+ {
+ int32_t i,any=0;
+
+ for(i=0;i<EDGE_NLINES;i++)
+	 if (edgeLines[i].Word!=NO_WORD)
+	     {
+		 if (SHOW_INFO((&MainContext)))
+			 { consolePrintf("Line %d has a registered edge callback%s",i,BREAK); }
+		 any=1;
+	     }
+
+ return any;
+ }
+
+// Indicates if an EXTI channel is used by an edge line
+int32_t edgeChannelUsed(int32_t channel)
+ {
+ return (edgeChannelLine[channel]>=0);
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic edge events function
+int32_t edgeFunction(ContextType *context,int32_t value)
+ {
+ int32_t line,data,word=NO_WORD;
+
+ switch (value)
+     {
+     case EDGE_F_SET: // Set edge mode ( line umode -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 if (!getLine(context,&line)) return 0;
+    	 if ((data<EDGE_MODE_NONE)||(data>EDGE_MODE_BOTH))
+    	      {
+    		  consoleErrorMessage(context,"Invalid edge mode");
+    		  return 0;
+    	      }
+    	 if ((imuIsRunning())
+    		 &&((GpioArray[line]==GYR_INT2_PIN)||(GpioArray[line]==ACCEL_INT1_PIN)
+    		    ||(GpioArray[line]==MAG_DRDY_PIN)))
+    	      {
+    		  consoleErrorMessage(context,"Line interrupt used by the IMU service");
+    		  return 0;
+    	      }
+    	 edgeLineSet(line,data);
+    	 break;
+
+     case EDGE_F_WAIT: // Wait event ( line ums -- time f )
+    	 edgeWait(context);
+    	 break;
+
+     case EDGE_F_AVAIL: // Events in the queue ( line -- n )
+    	 if (!getLine(context,&line)) return 0;
+    	 PstackPush(context,(int32_t)(edgeLines[line].Head-edgeLines[line].Tail));
+    	 break;
+
+     case EDGE_F_COUNT: // Number of edges ( line -- n )
+    	 if (!getLine(context,&line)) return 0;
+    	 PstackPush(context,(int32_t)edgeLines[line].Count);
+    	 break;
+
+     case EDGE_F_PERIOD: // Time between last two edges ( line -- us )
+    	 if (!getLine(context,&line)) return 0;
+    	 PstackPush(context,(int32_t)edgeLines[line].Period);
+    	 break;
+
+     case EDGE_F_LOST: // Lost events ( line -- n )
+    	 if (!getLine(context,&line)) return 0;
+    	 PstackPush(context,(int32_t)edgeLines[line].Lost);
+    	 break;
+
+     case EDGE_F_CLEAR: // Clear queue and counters ( line -- )
+    	 if (!getLine(context,&line)) return 0;
+    	 edgeLineClear(line);
+    	 break;
+
+     case EDGE_F_WORD: // Set callback word ( line -- )
+    	 if (!getWord(context,&word)) return 0;
+    	 if (!getLine(context,&line)) return 0;
+    	 edgeLines[line].Word=(uint16_t)word;
+    	 // Events queued before are given to the word
+    	 if (word!=NO_WORD) chBSemSignal(&EdgeSemaphore);
+    	 break;
+
+     case EDGE_F_RESET: // Disable all lines and callbacks
+    	 for(line=0;line<EDGE_NLINES;line++)
+    	     {
+    		 edgeLineSet(line,EDGE_MODE_NONE);
+    		 edgeLines[line].Word=NO_WORD;
+    		 edgeLineClear(line);
+    	     }
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in edgeFunction");
+     }
+
+ return 0;
+ }
+
@@ -0,0 +1,60 @@
+/*
+ edgeModule.h
+ GPIO edge events header file
+
+ EXTI interrupts on the GPIO lines store timestamped
+ events in one lock free queue for each line
+ */
+
+#ifndef _EDGE_MODULE
+#define _EDGE_MODULE
+
+// Module definitions
+#define EDGE_NLINES         10             // GPIO lines
+#define EDGE_QUEUE_SIZE     32             // Events per line (power of 2)
+#define EDGE_THREAD_WA      512            // Callback thread working area
+#define EDGE_THREAD_PRIO    (NORMALPRIO+5) // Callback thread priority
+#define EDGE_WAIT_POLL      10             // Ticks between abort checks
+
+// Edge modes
+#define EDGE_MODE_NONE      0    // Line disabled
+#define EDGE_MODE_RISING    1    // Rising edges
+#define EDGE_MODE_FALLING   2    // Falling edges
+#define EDGE_MODE_BOTH      3    // Both edges
+
+// Queue and counters for one line
+// Head is only written in the interrupt and tail
+// only in thread context so no lock is needed
+typedef struct
+ {
+ uint32_t Time[EDGE_QUEUE_SIZE];  // Event timestamps in us
+ volatile uint32_t Head;          // Next event to write
+ volatile uint32_t Tail;          // Next event to read
+ volatile uint32_t Count;         // Total number of edges
+ volatile uint32_t Lost;          // Events lost with the queue full
+ volatile uint32_t Last;          // Time of the last edge
+ volatile uint32_t Period;        // Time between the last two edges
+ uint16_t Word;                   // Callback word (or NO_WORD)
+ uint8_t Mode;                    // Edge mode
+ }
+ EdgeLine;
+
+// Function prototypes
+void edgeModuleInit(void);
+int32_t isAnyEdgeCallback(void);
+int32_t edgeChannelUsed(int32_t channel);
+
+// Command functions
+int32_t edgeFunction(ContextType *context,int32_t value);
+#define EDGE_F_SET        0   // Set line edge mode
+#define EDGE_F_WAIT       1   // Wait for an event
+#define EDGE_F_AVAIL      2   // Events in the queue
+#define EDGE_F_COUNT      3   // Number of edges
+#define EDGE_F_PERIOD     4   // Time between the last two edges
+#define EDGE_F_LOST       5   // Number of lost events
+#define EDGE_F_CLEAR      6   // Clear queue and counters
+#define EDGE_F_WORD       7   // Set callback word
+#define EDGE_F_RESET      8   // Disable all lines and callbacks
+
+#endif // _EDGE_MODULE
+
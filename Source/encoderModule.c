@@ -0,0 +1,296 @@
+/*
+ encoderModule.c
+ Quadrature encoder interface source file
+
+ The 16 bit TIM4 counter is extended to 32 bits in the update
+ interrupt. The counter register also holds a copy of the update
+ flag (UIFREMAP) so an overflow not yet handled by the interrupt
+ is detected when reading the position
+
+ The index pulse is captured in CCR3 so the position at the
+ index edge is exact even with interrupt latency
+
+ A virtual timer computes the velocity in counts per second
+ over a fixed window
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"           // Main include for the project
+#include "encoderModule.h"   // This module header
+
+// Counter extension (high part of the 32 bit count)
+static volatile int32_t encHigh=0;
+
+// Offset of the user position from the count
+static volatile int32_t encOffset=0;
+
+// Index mode and count
+static volatile int32_t encIndexMode=ENC_INDEX_NONE;
+static volatile int32_t encIndexCount=0;
+
+// Velocity
+static VirtualTimer encTimer;
+static int32_t encWindow=ENC_DEF_WINDOW;
+static int32_t encLastCount=0;
+static volatile int32_t encVelocity=0;
+
+// Running flag
+static int32_t encRunning=0;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// 32 bit count from a CNT register value (I-Class)
+// Must be called from a locked state or an ISR
+static int32_t encCountFromI(uint32_t cnt)
+ {
+ int32_t high;
+
+ high=encHigh;
+
+ // Overflow pending to be processed
+ if (cnt&ENC_CNT_UIFCPY)
+     {
+	 if ((cnt&0xFFFF)<0x8000)
+		 high+=0x10000;
+	    else
+	     high-=0x10000;
+     }
+
+ return high+(int32_t)(cnt&0xFFFF);
+ }
+
+// 32 bit count (I-Class)
+// Must be called from a locked state or an ISR
+static int32_t encCountI(void)
+ {
+ return encCountFromI(ENC_TIMER->CNT);
+ }
+
+// Velocity virtual timer callback
+// Executes locked in the system tick interrupt
+static void encTimerCallback(void *p)
+ {
+ int32_t count;
+
+ UNUSED(p);
+
+ count=encCountI();
+ encVelocity=((count-encLastCount)*1000)/encWindow;
+ encLastCount=count;
+
+ chVTSetI(&encTimer,MS2ST(encWindow),encTimerCallback,NULL);
+ }
+
+// Stops the encoder interface
+static void encStop(void)
+ {
+ if (!encRunning) return;
+
+ nvicDisableVector(STM32_TIM4_NUMBER);
+ ENC_TIMER->CR1=0;
+ ENC_TIMER->DIER=0;
+
+ chSysLock();
+ if (chVTIsArmedI(&encTimer)) chVTResetI(&encTimer);
+ chSysUnlock();
+
+ // Lines back to input
+ palSetPadMode(ENC_PORT,ENC_PIN_A,PAL_MODE_INPUT);
+ palSetPadMode(ENC_PORT,ENC_PIN_B,PAL_MODE_INPUT);
+ palSetPadMode(ENC_PORT,ENC_PIN_INDEX,PAL_MODE_INPUT);
+
+ encRunning=0;
+ }
+
+// Starts the encoder interface
+static void encStart(ContextType *context)
+ {
+ int32_t mode;
+
+ if (PstackPop(context,&mode)) return;
+ if ((mode<ENC_MODE_A)||(mode>ENC_MODE_AB))
+      {
+	  consoleErrorMessage(context,"Invalid encoder mode");
+	  return;
+      }
+
+ // Restart if running
+ encStop();
+
+ // Lines to the timer
+ palSetPadMode(ENC_PORT,ENC_PIN_A,PAL_MODE_ALTERNATE(ENC_AF));
+ palSetPadMode(ENC_PORT,ENC_PIN_B,PAL_MODE_ALTERNATE(ENC_AF));
+ palSetPadMode(ENC_PORT,ENC_PIN_INDEX,PAL_MODE_ALTERNATE(ENC_AF));
+
+ // Full 16 bit range
+ ENC_TIMER->CR1=ENC_CR1_UIFREMAP;
+ ENC_TIMER->PSC=0;
+ ENC_TIMER->ARR=0xFFFF;
+
+ // IC1 on TI1, IC2 on TI2 and IC3 on TI3 rising edges
+ ENC_TIMER->CCER=0;
+ ENC_TIMER->CCMR1=1|(ENC_FILTER<<4)|(1<<8)|(ENC_FILTER<<12);
+ ENC_TIMER->CCMR2=1|(ENC_FILTER<<4);
+ ENC_TIMER->CCER=TIM_CCER_CC3E;
+
+ // Encoder mode
+ ENC_TIMER->SMCR=mode;
+
+ // Clear the count
+ chSysLock();
+ ENC_TIMER->CNT=0;
+ ENC_TIMER->SR=0;
+ encHigh=0;
+ encOffset=0;
+ encLastCount=0;
+ encVelocity=0;
+ encIndexCount=0;
+ chSysUnlock();
+
+ // Interrupts on overflow and index
+ ENC_TIMER->DIER=TIM_DIER_UIE|TIM_DIER_CC3IE;
+ nvicEnableVector(STM32_TIM4_NUMBER,CORTEX_PRIORITY_MASK(ENC_IRQ_PRIORITY));
+
+ // Start counting
+ ENC_TIMER->CR1|=TIM_CR1_CEN;
+ encRunning=1;
+
+ // Start the velocity timer
+ chSysLock();
+ chVTSetI(&encTimer,MS2ST(encWindow),encTimerCallback,NULL);
+ chSysUnlock();
+ }
+
+/*********************** INTERRUPT FUNCTIONS *************************/
+
+// TIM4 interrupt
+// Extends the counter and processes the index captures
+CH_IRQ_HANDLER(STM32_TIM4_HANDLER)
+ {
+ uint32_t sr,cnt;
+ int32_t index;
+
+ CH_IRQ_PROLOGUE();
+
+ chSysLockFromIsr();
+
+ sr=ENC_TIMER->SR;
+ ENC_TIMER->SR=~sr;
+
+ // Overflow or underflow
+ if (sr&TIM_SR_UIF)
+     {
+	 cnt=ENC_TIMER->CNT&0xFFFF;
+	 if (cnt<0x8000)
+		 encHigh+=0x10000;
+	    else
+	     encHigh-=0x10000;
+     }
+
+ // Index pulse
+ if (sr&TIM_SR_CC3IF)
+     {
+	 encIndexCount++;
+
+	 // Count at the index edge from the current count
+	 // Both come from the same CNT read
+	 cnt=ENC_TIMER->CNT;
+	 index=encCountFromI(cnt)+(int16_t)(ENC_TIMER->CCR3-cnt);
+
+	 if (encIndexMode!=ENC_INDEX_NONE)
+	     {
+		 encOffset=index;
+		 if (encIndexMode==ENC_INDEX_ONCE) encIndexMode=ENC_INDEX_NONE;
+	     }
+     }
+
+ chSysUnlockFromIsr();
+
+ CH_IRQ_EPILOGUE();
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void encoderModuleInit(void)
+ {
+ // Enable encoder timer clock
+ RCC->APB1ENR|=RCC_APB1ENR_TIM4EN;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic encoder function
+int32_t encoderFunction(ContextType *context,int32_t value)
+ {
+ int32_t data;
+
+ switch (value)
+     {
+     case ENC_F_START: // Start interface ( umode -- )
+    	 encStart(context);
+    	 break;
+
+     case ENC_F_STOP: // Stop interface
+    	 encStop();
+    	 break;
+
+     case ENC_F_POS: // Get position ( -- n )
+    	 chSysLock();
+    	 data=encCountI()-encOffset;
+    	 chSysUnlock();
+    	 PstackPush(context,data);
+    	 break;
+
+     case ENC_F_SET: // Set position ( n -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 chSysLock();
+    	 encOffset=encCountI()-data;
+    	 chSysUnlock();
+    	 break;
+
+     case ENC_F_VEL: // Get velocity ( -- n )
+    	 PstackPush(context,encVelocity);
+    	 break;
+
+     case ENC_F_WINDOW: // Set velocity window ( ums -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 if ((data<ENC_MIN_WINDOW)||(data>ENC_MAX_WINDOW))
+    	      {
+    		  consoleErrorMessage(context,"Invalid velocity window");
+    		  return 0;
+    	      }
+    	 chSysLock();
+    	 encWindow=data;
+    	 chSysUnlock();
+    	 break;
+
+     case ENC_F_INDEX: // Set index mode ( umode -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 if ((data<ENC_INDEX_NONE)||(data>ENC_INDEX_ALWAYS))
+    	      {
+    		  consoleErrorMessage(context,"Invalid index mode");
+    		  return 0;
+    	      }
+    	 encIndexMode=data;
+    	 break;
+
+     case ENC_F_ICOUNT: // Number of index pulses ( -- n )
+    	 PstackPush(context,encIndexCount);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in encoderFunction");
+     }
+
+ return 0;
+ }
+
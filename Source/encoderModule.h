@@ -0,0 +1,57 @@
+/*
+ encoderModule.h
+ Quadrature encoder interface header file
+
+ TIM4 in encoder mode counts the A and B signals on GPIO
+ lines 6 and 7 (PD12 and PD13) and captures the index
+ pulse on GPIO line 8 (PD14)
+ */
+
+#ifndef _ENCODER_MODULE
+#define _ENCODER_MODULE
+
+// Hardware used for this module
+#define ENC_TIMER            TIM4        // Encoder timer (16 bit)
+#define ENC_PORT             GPIOD       // Encoder port
+#define ENC_PIN_A            12          // TIM4 CH1 (GPIO line 6)
+#define ENC_PIN_B            13          // TIM4 CH2 (GPIO line 7)
+#define ENC_PIN_INDEX        14          // TIM4 CH3 (GPIO line 8)
+#define ENC_AF               2           // Alternate function
+#define ENC_FILTER           3           // Input filter (fck N=8)
+#define ENC_IRQ_PRIORITY     5           // TIM4 IRQ priority
+
+// Counter bits not in the CMSIS headers of all versions
+#define ENC_CR1_UIFREMAP     BIT11       // Update flag copied to CNT bit 31
+#define ENC_CNT_UIFCPY       BIT31       // Update flag copy in CNT
+
+// Velocity window limits in ms
+#define ENC_MIN_WINDOW       1
+#define ENC_MAX_WINDOW       1000
+#define ENC_DEF_WINDOW       10
+
+// Counting modes (SMS encoder modes, RM0316)
+#define ENC_MODE_A           1    // Count edges on A (TI1FP1)
+#define ENC_MODE_B           2    // Count edges on B (TI2FP2)
+#define ENC_MODE_AB          3    // Count edges on A and B
+
+// Index modes
+#define ENC_INDEX_NONE       0    // Index ignored
+#define ENC_INDEX_ONCE       1    // Next index sets position to zero
+#define ENC_INDEX_ALWAYS     2    // All index pulses set position to zero
+
+// Function prototypes
+void encoderModuleInit(void);
+
+// Command functions
+int32_t encoderFunction(ContextType *context,int32_t value);
+#define ENC_F_START       0   // Start the encoder interface
+#define ENC_F_STOP        1   // Stop the encoder interface
+#define ENC_F_POS         2   // Get position
+#define ENC_F_SET         3   // Set position
+#define ENC_F_VEL         4   // Get velocity
+#define ENC_F_WINDOW      5   // Set velocity window
+#define ENC_F_INDEX       6   // Set index mode
+#define ENC_F_ICOUNT      7   // Number of index pulses
+
+#endif // _ENCODER_MODULE
+
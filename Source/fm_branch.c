@@ -21,6 +21,25 @@
 
 // External variables
 extern uint16_t CodePosition;
+extern uint16_t LastCodeStart;
+extern uint16_t LastCodeEnd;
+
+// Relational words that can be fused with a following JZ
+// Each one is replaced by the jump taken when it is false
+static const char *const FuseTable[][2]=
+        {
+		{"<","JGE"},
+		{">","JLE"},
+		{"<=","JGT"},
+		{">=","JLT"},
+		{"=","JNE"},
+		{"<>","JEQ"},
+		{"0<","J0GE"},
+		{"0>","J0LE"},
+		{"0=","JNZ"},
+		{"0<>","JZ"},
+		{NULL,NULL}
+        };
 
 /***************** COMPILATION STATIC FUNCTIONS *****************/
 
@@ -31,6 +50,35 @@ static void set16uValue(int32_t position,uint16_t value)
 
  pointer=(uint16_t*)&(UDict.Mem[position]);
  (*pointer)=value;
+
+ // Current position is now a jump destination
+ // so the previous code cannot be fused
+ LastCodeEnd=0;
+ }
+
+// Code a jump if zero
+// If the previous code is a relational word that
+// is not a jump destination, both are fused in one code
+// Returns the baseCode result
+static int32_t codeJZ(void)
+ {
+ int32_t i;
+
+ // Check that the last code is a single byte that ends here
+ if ((LastCodeEnd!=CodePosition)||((LastCodeStart+1)!=CodePosition))
+	 return baseCode("JZ");
+
+ // Search it in the fuse table
+ for(i=0;FuseTable[i][0]!=NULL;i++)
+	 if (searchRegister((DictionaryEntry*)BaseDictionary,(char*)FuseTable[i][0])
+			 ==UDict.Mem[CodePosition-1])
+	      {
+		  // Overwrite the relational code
+		  CodePosition--;
+		  return baseCode((char*)FuseTable[i][1]);
+	      }
+
+ return baseCode("JZ");
  }
 
 // Initialize leave for a loop
@@ -99,29 +147,12 @@ static void processLeaves(void)
 
 	 // Set value in pointer to current code position
 	 (*pointer)=CodePosition;
+
+	 // Don't fuse over this jump destination
+	 LastCodeEnd=0;
      }
   }
 
-// Get the second element value in the return stack
-// to be used in loop
-// Returns 0 if OK
-//         1 there is not enough data on return stack
-static int32_t loopGetLimit(ContextType *context,int32_t *value)
- {
- int32_t pointer;
-
- // Get return stack pointer
- pointer=context->rstack.Pointer;
-
- // Check that there are at least two elements
- if (pointer<1) return 1;
-
- // Give the value
- (*value)=context->rstack.data[pointer-1];
-
- return 0;
- }
-
 /***************** COMPILATION PUBLIC FUNCTIONS *****************/
 
 // Code a uint16_t value at current position
@@ -155,7 +186,7 @@ int32_t allocate16u(uint16_t value)
 
 // IF ELSE THEN ---------------------------------------------------
 /*
- *  IF : Code "JZ"
+ *  IF : Code "JZ" (or a fused compare jump)
  *       CPUSH_HERE | BHEAD_IF
  *       allocate16u
  *
@@ -176,7 +207,7 @@ int32_t CompileIF(ContextType *context,int32_t value)
  UNUSED(value); UNUSED(context);
 
  // Try to compile the IF execute command
- if (baseCode("JZ"))
+ if (codeJZ())
         {
 	    consoleErrorMessage(&MainContext,"Error compiling IF");
 	    return 0;
@@ -449,7 +480,7 @@ int32_t CompileQ_LEAVE(ContextType *context,int32_t value)
  *
  * UNTIL : CPOP addr+HEAD
  *         Check and remove BHEAD_BEGIN
- *         CODE "JZ"
+ *         CODE "JZ" (or a fused compare jump)
  *         allocate16u(addr)
  *         Process leaves
  */
@@ -464,6 +495,9 @@ int32_t CompileBEGIN(ContextType *context,int32_t value)
  // Push current position
  CPUSH_HERE(BHEAD_BEGIN);
 
+ // This is a jump destination
+ LastCodeEnd=0;
+
  return 0;
  }
 
@@ -491,7 +525,7 @@ int32_t CompileUNTIL(ContextType *context,int32_t value)
  addr&=BRANCH_MASK;
 
  // Try to compile the JZ execute command
- if (baseCode("JZ"))
+ if (codeJZ())
         {
 	    consoleErrorMessage(&MainContext,"Error compiling UNTIL");
 	    return 0;
@@ -509,7 +543,7 @@ int32_t CompileUNTIL(ContextType *context,int32_t value)
 // BEGIN -- WHILE -- REPEAT/AGAIN -- LEAVE | ?LEAVE ------------------
 
 /*
- * WHILE : CODE "JZ"
+ * WHILE : CODE "JZ" (or a fused compare jump)
  *         RPUSH HERE|BHEAD_LEAVE
  *         allocate16u dummy
  *
@@ -525,7 +559,7 @@ int32_t CompileWHILE(ContextType *context,int32_t value)
  UNUSED(value); UNUSED(context);
 
  // Try to compile the JZ execute command
- if (baseCode("JZ"))
+ if (codeJZ())
         {
 	    consoleErrorMessage(&MainContext,"Error compiling WHILE");
 	    return 0;
@@ -793,8 +827,81 @@ int32_t JumpIfNotZero(ContextType *context,int32_t value)
  return 0;
  }
 
+// Fused compare and jump              [HIDDEN]
+// Compares the top of the stack, or the two top
+// elements, and jumps if the condition is true
+int32_t JumpCompare(ContextType *context,int32_t value)
+ {
+ int32_t addr,a,b=0,jump=0;
+
+ // Get address
+ addr=getAddrFromHere(context);
+
+ // Comparisons against zero use only one element
+ if (value<F_JCMP_0GE)
+      {
+	  if (PstackGetSize(context)<2)
+	       {
+		   runtimeErrorMessage(context,"Stack underflow in JMP");
+		   return 0;
+	       }
+	  PstackPop(context,&b);
+      }
+
+ if (PstackPop(context,&a))
+       {
+	   runtimeErrorMessage(context,"Stack underflow in JMP");
+	   return 0;
+       }
+
+ switch (value)
+   {
+   case F_JCMP_LT:  jump=(a<b);  break;
+   case F_JCMP_GT:  jump=(a>b);  break;
+   case F_JCMP_LE:  jump=(a<=b); break;
+   case F_JCMP_GE:  jump=(a>=b); break;
+   case F_JCMP_EQ:  jump=(a==b); break;
+   case F_JCMP_NE:  jump=(a!=b); break;
+   case F_JCMP_0GE: jump=(a>=0); break;
+   case F_JCMP_0LE: jump=(a<=0); break;
+   }
+
+ // Jump if needed
+ if (jump)  (context->Counter)=addr;
+
+ return 0;
+ }
+
+
+// Starts a loop
+// The enclosing loop is saved on the return stack
+// Returns 0 if ok
+int32_t loopStart(ContextType *context,int32_t limit,int32_t index)
+ {
+ RStackType *rs;
+
+ rs=&(context->rstack);
+
+ // Check space for the enclosing loop
+ if ((rs->Pointer)>=(RSTK_SIZE-2))
+      {
+	  runtimeErrorMessage(context,"Return stack overflow in DO");
+      return 1;
+      }
+
+ // Save enclosing loop on the return stack
+ rs->data[++(rs->Pointer)]=rs->LoopLimit;
+ rs->data[++(rs->Pointer)]=rs->LoopIndex;
+
+ // Set this loop
+ rs->LoopLimit=limit;
+ rs->LoopIndex=index;
+
+ return 0;
+ }
 
 // DO +DO -DO execute words    [HIDDEN]
+// The enclosing loop is saved on the return stack
 int32_t ExecuteDO(ContextType *context,int32_t value)
  {
  int32_t limit,index,addr;
@@ -811,19 +918,7 @@ int32_t ExecuteDO(ContextType *context,int32_t value)
  	  return 0;
       }
 
- // Push then on the return stack
- if (RstackPush(context,limit))
-      {
-	  runtimeErrorMessage(context,"Return stack overflow in DO");
-      return 0;
-      }
-
- // Push then on the return stack
- if (RstackPush(context,index))
-      {
-	  runtimeErrorMessage(context,"Return stack overflow in DO");
-      return 0;
-      }
+ if (loopStart(context,limit,index)) return 0;
 
  // In case of +DO
  if (value==F_DO_PLUS)
@@ -847,31 +942,21 @@ int32_t ExecuteDO(ContextType *context,int32_t value)
  }
 
 // LOOP execute word    [HIDDEN]
+// Increments, compares and jumps in one step
 int32_t ExecuteLOOP(ContextType *context,int32_t value)
  {
  UNUSED(value);
 
- int32_t limit,index,addr;
-
- // Get address
- addr=getAddrFromHere(context);
-
- // Get the loop limit
- if (loopGetLimit(context,&limit))
-      {
-	  runtimeErrorMessage(context,"Indexing error in LOOP");
-      return 0;
-      }
-
- // Add one to the top of the return stack
- RstackAddTop(context,1);
+ uint16_t *pointer;
 
- // Verify if we end the loop
- RstackGetTop(context,&index);
- if (index>=limit) return 0;
+ // Pointer to the loop start address
+ pointer=(uint16_t*)&(UDict.Mem[context->Counter]);
 
- // If we arrive here we need to go to previous loop
- context->Counter=addr;
+ // Go to loop start if we have not ended
+ if ((++(context->rstack.LoopIndex))<(context->rstack.LoopLimit))
+	 context->Counter=*pointer;
+    else
+	 (context->Counter)+=2;
 
  return 0;
  }
@@ -881,18 +966,11 @@ int32_t ExecuteNewLOOP(ContextType *context,int32_t value)
  {
  UNUSED(value);
 
- int32_t limit,index,addr,inc;
+ int32_t index,addr,inc;
 
  // Get address
  addr=getAddrFromHere(context);
 
- // Get the loop limit
- if (loopGetLimit(context,&limit))
-      {
-	  runtimeErrorMessage(context,"Indexing error in @LOOP");
-      return 0;
-      }
-
  // Get the increment to add
  if (PstackPop(context,&inc))
       {
@@ -900,16 +978,14 @@ int32_t ExecuteNewLOOP(ContextType *context,int32_t value)
       return 0;
       }
 
- // Add to the top of the return stack
- RstackAddTop(context,inc);
+ // Add to the loop index
+ index=(context->rstack.LoopIndex)+=inc;
 
  // Verify if we end the loop
- RstackGetTop(context,&index);
-
  if (inc>=0)
-     { if (index>=limit) return 0; }
+     { if (index>=context->rstack.LoopLimit) return 0; }
     else
-     { if (index<=limit) return 0; }
+     { if (index<=context->rstack.LoopLimit) return 0; }
 
  // If we arrive here we need to go to previous DO
  context->Counter=addr;
@@ -919,24 +995,52 @@ int32_t ExecuteNewLOOP(ContextType *context,int32_t value)
 
 // UNLOOP execute word
 // Normal word, not hidden
+// Recovers the enclosing loop from the return stack
 int32_t ExecuteUNLOOP(ContextType *context,int32_t value)
  {
  UNUSED(value);
 
- int32_t data;
+ RStackType *rs;
+
+ rs=&(context->rstack);
 
- if (RstackPop(context,&data))
+ if ((rs->Pointer)<1)
      {
 	 runtimeErrorMessage(context,"Return stack underflow in UNLOOP");
      return 0;
      }
 
- if (RstackPop(context,&data))
+ rs->LoopIndex=rs->data[(rs->Pointer)--];
+ rs->LoopLimit=rs->data[(rs->Pointer)--];
+
+ return 0;
+ }
+
+// I J K words
+// I is kept in the context, J and K are on the
+// return stack at fixed positions if no other
+// data has been pushed inside the loop
+int32_t ExecuteLoopIndex(ContextType *context,int32_t value)
+ {
+ RStackType *rs;
+
+ rs=&(context->rstack);
+
+ if (value==F_INDEX_I)
+     {
+	 PstackPush(context,rs->LoopIndex);
+	 return 0;
+     }
+
+ // J is at top and K two positions below
+ if ((rs->Pointer)<(2*value-1))
      {
-	 runtimeErrorMessage(context,"Return stack underflow in UNLOOP");
-     return 0;
+	 runtimeErrorMessage(context,"Not enough elements on return stack");
+	 return 0;
      }
 
+ PstackPush(context,rs->data[(rs->Pointer)-2*(value-1)]);
+
  return 0;
  }
 
@@ -79,11 +79,21 @@ int32_t CompileENDCASE(ContextType *context,int32_t value);
 
 // Execute public functions
 int32_t getAddrFromHere(ContextType *context);
+int32_t loopStart(ContextType *context,int32_t limit,int32_t index);
 
 // Execute command functions
 int32_t Jump(ContextType *context,int32_t value);
 int32_t JumpIfZero(ContextType *context,int32_t value);
 int32_t JumpIfNotZero(ContextType *context,int32_t value);
+int32_t JumpCompare(ContextType *context,int32_t value);
+#define F_JCMP_LT    0   // Jump if a<b
+#define F_JCMP_GT    1   // Jump if a>b
+#define F_JCMP_LE    2   // Jump if a<=b
+#define F_JCMP_GE    3   // Jump if a>=b
+#define F_JCMP_EQ    4   // Jump if a=b
+#define F_JCMP_NE    5   // Jump if a<>b
+#define F_JCMP_0GE   6   // Jump if a>=0
+#define F_JCMP_0LE   7   // Jump if a<=0
 
 int32_t ExecuteDO(ContextType *context,int32_t value);
 // Same options as CompileDO
@@ -93,6 +103,10 @@ int32_t ExecuteDO(ContextType *context,int32_t value);
 int32_t ExecuteLOOP(ContextType *context,int32_t value);
 int32_t ExecuteNewLOOP(ContextType *context,int32_t value);
 int32_t ExecuteUNLOOP(ContextType *context,int32_t value);
+int32_t ExecuteLoopIndex(ContextType *context,int32_t value);
+#define F_INDEX_I   0   // Innermost loop index
+#define F_INDEX_J   1   // Second loop index
+#define F_INDEX_K   2   // Third loop index
 int32_t ExecuteOF(ContextType *context,int32_t value);
 
 #endif // _FM_BRANCH_MODULE
@@ -184,7 +184,7 @@ int32_t DebugFunction(ContextType *context,int32_t value)
 
 	   if (length<=0) return 0;  // Check lenght
 
-	   debugDumpMemory((uint8_t*)(*upos),position,length);
+	   debugDumpMemory((uint8_t*)(uintptr_t)(*upos),position,length);
 	   break;
 
    case PF_F_FLAGS: // Show static flag information
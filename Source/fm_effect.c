@@ -0,0 +1,580 @@
+/*******************************************************************
+ *
+ *  f m _ e f f e c t . c
+ *
+ * Stack effect functions for the Forth project
+ *
+ * This module verifies the stack effect of compiled words
+ *
+ ******************************************************************/
+
+/*
+ When a word ends its compilation all its codes are explored
+ following every path from the start of the word.
+ The stack depth, relative to the word entry, is calculated for
+ each code. The word is verified if:
+
+     * All reached codes have a known stack effect
+     * All paths arrive to each code with the same depth
+
+ For a verified word we know the minimum depth the stack needs
+ at word entry so that no reached code finds the stack empty.
+ A CHKD code that checks this depth is inserted at the start of
+ the word and the common stack words are changed to unchecked
+ versions that don't test the number of elements on each call.
+
+ Words that use user words, strings, PICK or any other word
+ without a fixed stack effect are not verified and are kept
+ as they were coded.
+ */
+
+// Includes
+#include "fp_config.h"     // Main configuration file
+#include "fp_port.h"       // Include file for the port
+#include "fm_main.h"       // Main header file
+#include "fm_stack.h"      // Stack header file
+#include "fm_register.h"   // Register header file
+#include "fm_debug.h"      // Debug header file
+#include "fm_program.h"    // Program header file
+#include "fm_effect.h"     // This module header file
+
+// External variables
+extern uint16_t CodePosition;
+
+// Mark for effects that end the word
+#define EFFECT_END   -1
+
+// Stack effect of the Base Dictionary words that can be verified
+// Hidden codes are decoded in codeEffect
+static const struct
+      {
+	  char *name;   // Word name
+	  int8_t in;    // Elements taken from the stack
+	  int8_t out;   // Elements left on the stack
+      }
+ EffectTable[]=
+      {
+	  {"EXIT",EFFECT_END,0},
+	  {"ABORT",EFFECT_END,0},
+	  {"DROP",1,0},
+	  {"DUP",1,2},
+	  {"OVER",2,3},
+	  {"ROT",3,3},
+	  {"TRUE",0,1},
+	  {"FALSE",0,1},
+	  {"+",2,1},
+	  {"-",2,1},
+	  {"*",2,1},
+	  {"/",2,1},
+	  {"MOD",2,1},
+	  {"SWAP",2,2},
+	  {"NIP",2,1},
+	  {"MAX",2,1},
+	  {"MIN",2,1},
+	  {"TUCK",2,3},
+	  {"/MOD",2,2},
+	  {"<",2,1},
+	  {">",2,1},
+	  {"<=",2,1},
+	  {">=",2,1},
+	  {"=",2,1},
+	  {"<>",2,1},
+	  {"INVERT",1,1},
+	  {"AND",2,1},
+	  {"OR",2,1},
+	  {"XOR",2,1},
+	  {"LSHIFT",2,1},
+	  {"RSHIFT",2,1},
+	  {"NEGATE",1,1},
+	  {"NOT",1,1},
+	  {"ABS",1,1},
+	  {"1+",1,1},
+	  {"1-",1,1},
+	  {"2+",1,1},
+	  {"2-",1,1},
+	  {"2*",1,1},
+	  {"2/",1,1},
+	  {"0<",1,1},
+	  {"0>",1,1},
+	  {"0=",1,1},
+	  {"0<>",1,1},
+	  {"CELL+",1,1},
+	  {"CELLS",1,1},
+	  {"HCELL+",1,1},
+	  {"HCELLS",1,1},
+	  {"@",1,1},
+	  {"!",2,0},
+	  {"H@",1,1},
+	  {"H!",2,0},
+	  {"C@",1,1},
+	  {"C!",2,0},
+	  {"+!",2,0},
+	  {"H+!",2,0},
+	  {"C+!",2,0},
+	  {">R",1,0},
+	  {"R>",0,1},
+	  {"R@",0,1},
+	  {"I",0,1},
+	  {"J",0,1},
+	  {"K",0,1},
+	  {"UNLOOP",0,0},
+	  {NULL,0,0}
+      };
+
+#define EFFECT_WORDS  (sizeof(EffectTable)/sizeof(EffectTable[0]))
+
+// Words that have an unchecked version
+static const char *const UncheckedTable[][2]=
+      {
+	  {"DROP","UDROP"},
+	  {"DUP","UDUP"},
+	  {"OVER","UOVER"},
+	  {"SWAP","USWAP"},
+	  {"NIP","UNIP"},
+	  {"+","U+"},
+	  {"-","U-"},
+	  {"*","U*"},
+	  {"AND","UAND"},
+	  {"OR","UOR"},
+	  {"XOR","UXOR"},
+	  {NULL,NULL}
+      };
+
+#define UNCHECKED_WORDS  (sizeof(UncheckedTable)/sizeof(UncheckedTable[0]))
+
+// Base Dictionary codes of the above tables
+// They are searched only once
+static int16_t EffectCodes[EFFECT_WORDS];
+static int16_t UncheckedCodes[UNCHECKED_WORDS][2];
+static int32_t effectReady=0;
+
+// Decoded effect of one code
+typedef struct
+    {
+	int16_t need;      // Elements needed in the stack
+	int16_t fall;      // Stack change if execution continues
+	int16_t jump;      // Stack change if the jump is taken
+	uint16_t target;   // Jump target
+	uint8_t flags;     // Flags
+    }
+    EffectInfo;
+
+// Effect flags
+#define EF_FALL     1  // Execution can continue on next code
+#define EF_JUMP     2  // Execution can jump to target
+
+// Analysis data for the current word
+static uint16_t CodeStart[EFFECT_MAX_CODES+1];  // Position of each code
+static int16_t  CodeDepth[EFFECT_MAX_CODES];    // Depth at each code
+static int16_t  WorkList[EFFECT_MAX_CODES];     // Codes to explore
+static int32_t  nCodes,nWork;
+
+/***************** STATIC FUNCTIONS *****************/
+
+// Search the codes of the effect tables
+static void effectInit(void)
+ {
+ int32_t i;
+
+ for(i=0;EffectTable[i].name!=NULL;i++)
+	 EffectCodes[i]=searchRegister((DictionaryEntry*)BaseDictionary,EffectTable[i].name);
+
+ for(i=0;UncheckedTable[i][0]!=NULL;i++)
+     {
+	 UncheckedCodes[i][0]=searchRegister((DictionaryEntry*)BaseDictionary,(char*)UncheckedTable[i][0]);
+	 UncheckedCodes[i][1]=searchRegister((DictionaryEntry*)BaseDictionary,(char*)UncheckedTable[i][1]);
+     }
+
+ effectReady=1;
+ }
+
+// Gives the size in bytes of the code at a position
+static int32_t codeSize(uint16_t pos)
+ {
+ int32_t size,entry;
+
+ switch (UDict.Mem[pos])
+     {
+     case NUM1B_CODE: return 2;
+     case NUM2B_CODE: return 3;
+     case NUM4B_CODE: return 5;
+     case UWORD_CODE:
+     case TH_CODE:
+     case THP_CODE:   return 3;
+     case SS_CODE:    return 2+UDict.Mem[pos+1];
+
+     case PS_CODE:
+    	 size=1;
+    	 while (UDict.Mem[pos+size]) size++;
+    	 return size+1;
+
+     case EXT1_CODE:
+     case EXT2_CODE:
+     case EXT3_CODE:
+    	 size=2;
+    	 break;
+
+     default:
+    	 size=1;
+     }
+
+ // Operands
+ entry=effectEntry(pos);
+ if (BaseDictionary[entry].flags&DF_ADDR) size+=2;
+ if (BaseDictionary[entry].flags&DF_BYTE) size++;
+
+ return size;
+ }
+
+// Decodes the stack effect of the code at a position
+// Returns 0 if the effect is known
+static int32_t codeEffect(uint16_t pos,EffectInfo *info)
+ {
+ int32_t code,i;
+
+ code=UDict.Mem[pos];
+
+ // Default effect
+ info->need=0;
+ info->fall=0;
+ info->jump=0;
+ info->target=*(uint16_t*)(UDict.Mem+pos+1);
+ info->flags=EF_FALL;
+
+ switch (code)
+     {
+     case ENDWORD_CODE:
+    	 info->flags=0;
+    	 return 0;
+
+     case NUM1B_CODE:
+     case NUM2B_CODE:
+     case NUM4B_CODE:
+     case GETR_CODE:
+     case LADDR_CODE:
+    	 info->fall=1;
+    	 return 0;
+
+     case PS_CODE:
+     case LALLOT_CODE:
+     case CHKD_CODE:
+    	 return 0;
+
+     case TOVAL_CODE:
+     case TOHVAL_CODE:
+     case TOCVAL_CODE:
+     case ADDTOVAL_CODE:
+     case ADDTOHVAL_CODE:
+     case ADDTOCVAL_CODE:
+     case TODEFER_CODE:
+     case SETR_CODE:
+     case ADDR_CODE:
+    	 info->need=1;
+    	 info->fall=-1;
+    	 return 0;
+
+     case JMP_CODE:
+    	 info->flags=EF_JUMP;
+    	 return 0;
+
+     case JZ_CODE:
+     case JNZ_CODE:
+     case J0GE_CODE:
+     case J0LE_CODE:
+    	 info->need=1;
+    	 info->fall=-1;
+    	 info->jump=-1;
+    	 info->flags=EF_FALL|EF_JUMP;
+    	 return 0;
+
+     case JLT_CODE:
+     case JGT_CODE:
+     case JLE_CODE:
+     case JGE_CODE:
+     case JEQ_CODE:
+     case JNE_CODE:
+     case PLUS_DO_CODE:
+     case MINUS_DO_CODE:
+    	 info->need=2;
+    	 info->fall=-2;
+    	 info->jump=-2;
+    	 info->flags=EF_FALL|EF_JUMP;
+    	 return 0;
+
+     case DO_CODE:
+    	 info->need=2;
+    	 info->fall=-2;
+    	 return 0;
+
+     case LOOP_CODE:
+    	 info->flags=EF_FALL|EF_JUMP;
+    	 return 0;
+
+     case ALOOP_CODE:
+    	 info->need=1;
+    	 info->fall=-1;
+    	 info->jump=-1;
+    	 info->flags=EF_FALL|EF_JUMP;
+    	 return 0;
+
+     case OF_CODE:
+    	 info->need=2;
+    	 info->fall=-2;
+    	 info->jump=-1;
+    	 info->flags=EF_FALL|EF_JUMP;
+    	 return 0;
+     }
+
+ // Fast locals
+ if ((code>=GET0_CODE)&&(code<(GET0_CODE+FAST_LOCALS)))
+      {
+	  info->fall=1;
+	  return 0;
+      }
+ if ((code>=SET0_CODE)&&(code<(SET0_CODE+FAST_LOCALS)))
+      {
+	  info->need=1;
+	  info->fall=-1;
+	  return 0;
+      }
+
+ // Direct variable access goes in groups of @ ! +!
+ if ((code>=DV_FIRST_CODE)&&(code<=DV_LAST_CODE))
+      {
+	  if ((code-DV_FIRST_CODE)%3)
+	        {
+		    info->need=1;
+		    info->fall=-1;
+	        }
+	       else
+	        info->fall=1;
+	  return 0;
+      }
+
+ // Other words from the effect table
+ code=effectEntry(pos);
+ for(i=0;EffectTable[i].name!=NULL;i++)
+	 if (EffectCodes[i]==code)
+	      {
+		  if (EffectTable[i].in==EFFECT_END)
+		        {
+			    info->flags=0;
+			    return 0;
+		        }
+		  info->need=EffectTable[i].in;
+		  info->fall=EffectTable[i].out-EffectTable[i].in;
+		  return 0;
+	      }
+
+ return 1; // Unknown effect
+ }
+
+// Reach a code with a given depth
+// Returns 0 if it is consistent
+static int32_t effectReach(int32_t ncode,int32_t depth)
+ {
+ // Execution cannot go out of the word
+ // or to the middle of a code
+ if ((ncode<0)||(ncode>=nCodes)) return 1;
+
+ // Code already reached
+ if (CodeDepth[ncode]!=EFFECT_NO_DEPTH)
+	 return (CodeDepth[ncode]!=depth);
+
+ // New code to explore
+ CodeDepth[ncode]=depth;
+ WorkList[nWork++]=ncode;
+
+ return 0;
+ }
+
+// Gives the unchecked version of a code or -1 if there is none
+static int32_t uncheckedCode(uint16_t pos)
+ {
+ int32_t i;
+
+ for(i=0;UncheckedTable[i][0]!=NULL;i++)
+	 if (UncheckedCodes[i][0]==UDict.Mem[pos]) return UncheckedCodes[i][1];
+
+ return -1;
+ }
+
+/***************** PUBLIC FUNCTIONS *****************/
+
+// Gives the Base Dictionary entry of the code at a position
+// Unchecked codes give the entry of the checked word
+int32_t effectEntry(uint16_t pos)
+ {
+ int32_t i;
+
+ switch (UDict.Mem[pos])
+     {
+     case EXT1_CODE: return EXT1_START+UDict.Mem[pos+1];
+     case EXT2_CODE: return EXT2_START+UDict.Mem[pos+1];
+     case EXT3_CODE: return EXT3_START+UDict.Mem[pos+1];
+     }
+
+ if ((UDict.Mem[pos]>=UNC_FIRST_CODE)&&(UDict.Mem[pos]<=UNC_LAST_CODE))
+	 for(i=0;UncheckedTable[i][0]!=NULL;i++)
+		 if (UncheckedCodes[i][1]==UDict.Mem[pos]) return UncheckedCodes[i][0];
+
+ return UDict.Mem[pos];
+ }
+
+// Gives the stack effect of a Base Dictionary entry
+// Returns 0 if it is in the effect table
+int32_t effectInOut(int32_t entry,int32_t *in,int32_t *out)
+ {
+ int32_t i;
+
+ if (!effectReady) effectInit();
+
+ for(i=0;EffectTable[i].name!=NULL;i++)
+	 if (EffectCodes[i]==entry)
+	      {
+		  (*in)=EffectTable[i].in;
+		  (*out)=EffectTable[i].out;
+		  return 0;
+	      }
+
+ return 1;
+ }
+
+// Analyses the stack effect of the word that starts at a position
+// Returns the stack depth needed at word entry
+//         -1 if the word cannot be verified
+int32_t effectAnalyse(uint16_t start)
+ {
+ int32_t i,depth,need,code;
+ uint16_t pos;
+ EffectInfo info;
+
+ // Search the table codes
+ if (!effectReady) effectInit();
+
+ // Locate all codes in the word up to the end marker
+ nCodes=0;
+ pos=start;
+ do
+  {
+  if ((nCodes==EFFECT_MAX_CODES)||(pos>=UD_MEMSIZE)) return -1;
+  CodeStart[nCodes]=pos;
+  CodeDepth[nCodes]=EFFECT_NO_DEPTH;
+  code=UDict.Mem[pos];
+  pos+=codeSize(pos);
+  nCodes++;
+  }
+  while (code!=ENDWORD_CODE);
+ CodeStart[nCodes]=pos;
+
+ // Explore all paths from the word start
+ need=0;
+ nWork=0;
+ effectReach(0,0);
+ while (nWork)
+     {
+	 i=WorkList[--nWork];
+
+	 if (codeEffect(CodeStart[i],&info)) return -1;
+
+	 depth=CodeDepth[i];
+	 if ((info.need-depth)>need) need=info.need-depth;
+
+	 if (info.flags&EF_FALL)
+		 if (effectReach(i+1,depth+info.fall)) return -1;
+
+	 if (info.flags&EF_JUMP)
+		 if (effectReach(effectNumber(info.target),depth+info.jump)) return -1;
+     }
+
+ // Check that the word can run at all
+ if (need>STACK_SIZE) return -1;
+
+ return need;
+ }
+
+// Number of codes in the last analysed word
+int32_t effectCodes(void)
+ {
+ return nCodes;
+ }
+
+// Position of a code in the last analysed word
+uint16_t effectPosition(int32_t ncode)
+ {
+ return CodeStart[ncode];
+ }
+
+// Stack depth, relative to the word entry, at a code
+// of the last analysed word
+// Gives EFFECT_NO_DEPTH if the code is never reached
+int32_t effectDepth(int32_t ncode)
+ {
+ return CodeDepth[ncode];
+ }
+
+// Gives the code number at a position of the last analysed word
+// Returns -1 if it is not the start of a code
+int32_t effectNumber(uint16_t pos)
+ {
+ int32_t i;
+
+ for(i=0;i<nCodes;i++)
+	 if (CodeStart[i]==pos) return i;
+
+ return -1;
+ }
+
+// Verifies the stack effect of the word that has just been compiled
+// If it is verified the word is changed to use unchecked stack words
+// Returns 0 if the word has been verified
+int32_t effectVerifyWord(void)
+ {
+ int32_t i,need,used,shift;
+ uint16_t pos;
+ EffectInfo info;
+
+ // Analyse the word
+ need=effectAnalyse(EditWord);
+ if (need<0) return 1;
+ if (CodeStart[nCodes]!=CodePosition) return 1;
+
+ // Check if there are words to change
+ used=0;
+ for(i=0;i<nCodes;i++)
+	 if ((CodeDepth[i]!=EFFECT_NO_DEPTH)&&(uncheckedCode(CodeStart[i])>=0)) used++;
+ if (!used) return 1;
+
+ // Insert the entry check if needed
+ shift=0;
+ if (need)
+     {
+	 if ((CodePosition+2)>=UD_MEMSIZE) return 1;
+
+	 // Move the word code
+	 for(pos=CodePosition;pos>EditWord;pos--)
+		 UDict.Mem[pos+1]=UDict.Mem[pos-1];
+	 UDict.Mem[EditWord]=CHKD_CODE;
+	 UDict.Mem[EditWord+1]=need;
+	 CodePosition+=2;
+	 shift=2;
+
+	 // Relocate the jumps inside the word
+	 for(i=0;i<nCodes;i++)
+	     {
+		 CodeStart[i]+=shift;
+		 if ((!codeEffect(CodeStart[i],&info))&&(info.flags&EF_JUMP))
+			 (*(uint16_t*)(UDict.Mem+CodeStart[i]+1))+=shift;
+	     }
+     }
+
+ // Use the unchecked words
+ for(i=0;i<nCodes;i++)
+	 if (CodeDepth[i]!=EFFECT_NO_DEPTH)
+	     {
+		 used=uncheckedCode(CodeStart[i]);
+		 if (used>=0) UDict.Mem[CodeStart[i]]=used;
+	     }
+
+ return 0;
+ }
@@ -0,0 +1,27 @@
+/*******************************************************************
+ *
+ *  f m _ e f f e c t . h
+ *
+ * Stack effect header file for the Forth project
+ *
+ * This module verifies the stack effect of compiled words
+ *
+ ******************************************************************/
+
+#ifndef _FM_EFFECT_MODULE
+#define _FM_EFFECT_MODULE
+
+// Depth of codes that are never reached
+#define EFFECT_NO_DEPTH  0x7FFF
+
+// Public functions
+int32_t effectEntry(uint16_t pos);
+int32_t effectInOut(int32_t entry,int32_t *in,int32_t *out);
+int32_t effectAnalyse(uint16_t start);
+int32_t effectCodes(void);
+uint16_t effectPosition(int32_t ncode);
+int32_t effectDepth(int32_t ncode);
+int32_t effectNumber(uint16_t pos);
+int32_t effectVerifyWord(void);
+
+#endif // _FM_EFFECT_MODULE
@@ -302,6 +302,9 @@ static int32_t tokenCheckBaseDict(char *token)
    }
 
  // If we are in compile mode...
+ // ...try to fuse a variable access with the variable
+ if (!codeDirectAccess(pos)) return 0;
+
  if (baseCode(token)) //...code this token
 	   consoleErrorMessage(&MainContext,"Out of memory");
 
@@ -610,8 +613,8 @@ void clearInterruptContext(void)
  // Clear verbose level
  InterruptContext.VerboseLevel=0;
 
- // Clear all flags
- InterruptContext.Flags=0;
+ // Clear all flags and exceptions
+ clearContextAbort(&InterruptContext);
  }
 
 // Check length of token
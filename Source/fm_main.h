@@ -88,12 +88,18 @@ typedef struct // Return Stack typedef
     {
 	int16_t Frame;            // Frame at the start of a word
 	int16_t Pointer;          // Pointer to current position
+	int32_t LoopIndex;        // Index of the innermost DO loop
+	int32_t LoopLimit;        // Limit of the innermost DO loop
 	int32_t data[RSTK_SIZE];  // Stack data
     } RStackType;
 
 // The return stack frame is the value of the pointer upon
 // entering the execution of a word
 
+// The innermost DO loop is kept in LoopIndex and LoopLimit
+// DO pushes the enclosing loop limit and index on the
+// return stack and UNLOOP recovers them
+
 // Typedef for context data -------------------------------------------------
 // Define the environment context where a program runs
 typedef struct
@@ -105,15 +111,23 @@ typedef struct
    	int16_t  Process;                   // Process 0=Foreground
    	uint32_t Flags;                     // Context Flags
    	uint32_t VerboseLevel;              // Context Verbose Level
+   	int32_t  ThrowCode;                 // Exception code being thrown
+   	int16_t  CatchDepth;                // Number of active CATCH
   } ContextType;
 
 // Context Flags values
 #define CFLAG_EXIT    (BIT(0))       // Exit current word execution
 #define CFLAG_ABORT   (BIT(1))       // Abort all context execution
+#define CFLAG_KILL    (BIT(2))       // Abort that no CATCH can stop
 
 // Flags that end current word
 #define CFLAGS_ENDWORD  (CFLAG_EXIT|CFLAG_ABORT)
 
+// Exception codes
+// Errors inside a CATCH abort all words up to it
+#define THROW_ABORT     (-1)         // ABORT and runtime errors
+#define THROW_USER      (-28)        // User abort or thread kill (cannot be caught)
+
 #define FOREGROUND 0
 
 // Public variables
@@ -18,6 +18,7 @@
 #include "fm_screen.h"     // Screen header file
 #include "fm_branch.h"
 #include "fm_threads.h"
+#include "fm_effect.h"
 #include "fm_program.h"    // This module header file
 
 // User dictionary
@@ -26,6 +27,8 @@ UserDictionary  UDict __attribute__ ((aligned (4)));
 // Variables used during compilation ---------------------------------
 
 uint16_t CodePosition;      // Position where we will insert next code
+uint16_t LastCodeStart;     // Position of the last coded word
+uint16_t LastCodeEnd;       // Position after the last coded word
 uint32_t EditWord=NO_WORD;  // Current compiled word position
 int32_t  CompileLine;       // Compilation line for error messages
 
@@ -35,10 +38,16 @@ int32_t  CompileLine;       // Compilation line for error messages
 char LocalNames[MAX_LOCALS][MAX_TOKEN_SIZE+1];
 // Array to hold local indexes
 uint8_t LocalIndex[MAX_LOCALS];
+// Array to mark locals that are arrays
+uint8_t LocalArray[MAX_LOCALS];
 // Next local to process
 int16_t nextLocal;
 // First local in a variable local group
 int16_t firstLocalInGroup;
+// Return stack cells used by locals
+int16_t nextLocalCell;
+// First cell in a variable local group
+int16_t firstCellInGroup;
 // Local mode
 int16_t localMode;
 // Last verbose level before file mode start
@@ -158,6 +167,9 @@ static void backtracePosition(ContextType *context,int32_t position)
  {
  if (NO_ERROR(context)) return;
 
+ // No backtrace if it will be caught
+ if (context->CatchDepth) return;
+
  // Return if we have no console
  if (NO_CONSOLE) return;
 
@@ -244,16 +256,40 @@ static int32_t int32Code(int32_t value)
  return 0;
  }
 
+/***************** PUBLIC FUNCTIONS *************************/
+
+// Clears the abort and exception state of a context
+// Used before running a word in it
+void clearContextAbort(ContextType *context)
+ {
+ (context->Flags)&=(~(CFLAG_EXIT|CFLAG_ABORT|CFLAG_KILL));
+ context->ThrowCode=0;
+ context->CatchDepth=0;
+ }
+
+// Aborts a context so that no CATCH can stop it
+// Can be called from other threads
+void killExecution(ContextType *context)
+ {
+ LOCK_FLAGS
+ context->ThrowCode=THROW_USER;
+ context->CatchDepth=0;
+ (context->Flags)|=(CFLAG_ABORT|CFLAG_KILL);
+ UNLOCK_FLAGS
+ }
+
 // Aborts from port PORT_ABORT defined in fp_port.h
-static void portAbort(ContextType *context)
+void portAbort(ContextType *context)
  {
  // Give this message only one time
+ // No CATCH is active when the message is given
+ context->CatchDepth=0;
  if (!((context->Flags)&CFLAG_ABORT))
 	 runtimeErrorMessage(context,"User Abort");
- };
 
-
-/***************** PUBLIC FUNCTIONS *************************/
+ // User abort cannot be caught
+ killExecution(context);
+ };
 
 // Locates a user word and returns its position
 // Returns NO_WORD if it is not found
@@ -276,6 +312,26 @@ uint16_t locateUserWord(char *name)
  return NO_WORD;
  }
 
+// Check if a position is the start of a user word
+// Walks the links so the word search state is not used
+// Returns 1 if it is a word start
+int32_t userWordStart(uint16_t position)
+ {
+ uint16_t word;
+
+ if (position>=UDict.Base.nextPos) return 0;
+
+ // Words are linked from the last one to lower positions
+ word=UDict.Base.lastWord;
+ while ((word!=NO_WORD)&&(word>=position))
+     {
+	 if (word==position) return 1;
+	 word=*((uint16_t*)&(UDict.Mem[word-2]));
+     }
+
+ return 0;
+ }
+
 // Prints user dictionary word list
 // Don't check verbose level
 void userWordList(void)
@@ -469,11 +525,15 @@ int32_t baseCode(char *word)
      }
 
  // Code this word if it is not in an extended zone
+ LastCodeStart=CodePosition;
  UDict.Mem[CodePosition]=pos;
 
  // Increase counter
  CodePosition++;
 
+ // Remember it for the branch compilers
+ LastCodeEnd=CodePosition;
+
  return 0;
  }
 
@@ -534,9 +594,70 @@ int32_t codeUserPosition(uint16_t position)
  // Increase counter
  CodePosition+=2;
 
+ // The call is the last coded word
+ LastCodeEnd=CodePosition;
+
  return 0;
  }
 
+// Variable access words that have a direct version
+// The direct version has the UDict data position as argument
+static const struct
+      {
+	  cFunction function;  // Function of the access word
+	  char *direct;        // Direct access word
+      }
+ DirectAccess[]=
+      {
+	  {executeVariableRecall,"DV@"},
+	  {executeVariableStore,"DV!"},
+	  {executeVariableStoreAdd,"DV+!"},
+	  {executeHVariableRecall,"DVH@"},
+	  {executeHVariableStore,"DVH!"},
+	  {executeHVariableStoreAdd,"DVH+!"},
+	  {executeCVariableRecall,"DVC@"},
+	  {executeCVariableStore,"DVC!"},
+	  {executeCVariableStoreAdd,"DVC+!"},
+	  {NULL,NULL}
+      };
+
+// Codes a variable access word from the Base Dictionary
+// If the last coded word is a call to a variable or create word
+// both are replaced by a direct access word
+// Returns 0 if it has been coded
+//         1 if it is not a direct access
+int32_t codeDirectAccess(int32_t pos)
+ {
+ uint16_t word;
+ uint8_t code;
+ int32_t i;
+
+ // Last coded word must be a user word call that ends here
+ if (LastCodeEnd!=CodePosition) return 1;
+ if ((LastCodeStart+3)!=CodePosition) return 1;
+ if (UDict.Mem[LastCodeStart]!=UWORD_CODE) return 1;
+
+ // Called word must be a data word
+ word=*(uint16_t*)(UDict.Mem+LastCodeStart+1);
+ code=UDict.Mem[word];
+ if ((code!=VAR_CODE)&&(code!=VARH_CODE)&&(code!=VARC_CODE)&&(code!=CRT_CODE))
+	 return 1;
+
+ // Search the access word
+ for(i=0;DirectAccess[i].function!=NULL;i++)
+	 if (BaseDictionary[pos].function==DirectAccess[i].function)
+	      {
+		  // Overwrite the call
+		  CodePosition=LastCodeStart;
+		  if (baseCode(DirectAccess[i].direct)) return 1;
+		  allocate16u(word+1);
+		  LastCodeEnd=0;
+		  return 0;
+	      }
+
+ return 1;
+ }
+
 // Returns the available user memory
 // Uses different information in interactive and compile mode
 int32_t  getUserMemory(void)
@@ -606,9 +727,9 @@ void executePrologue(ContextType *context)
  // Erase return stack
  RstackInit(context);
 
- // Erase flags
+ // Erase flags and exceptions
  // They should be cleared anyway
- (context->Flags)&=(~(CFLAG_EXIT|CFLAG_ABORT));
+ clearContextAbort(context);
  }
 
 // Sets start word [INTERACTIVE DIRECTIVE WORD]
@@ -648,9 +769,10 @@ int32_t SetStartWord(ContextType *context,int32_t value)
 
 // Execution core used for programExecute and executeUserWord
 // Defined inline to optimize speed and minimize stack usage
-inline void wordExecutionCore(ContextType *context,uint16_t position)
+static inline void wordExecutionCore(ContextType *context,uint16_t position)
  {
  uint16_t oldCounter,oldFrame;
+ int32_t oldIndex,oldLimit;
  uint8_t byte;
 
  // Save old counter
@@ -659,8 +781,10 @@ inline void wordExecutionCore(ContextType *context,uint16_t position)
  // Set new counter
  (context->Counter)=position;
 
- // Save old frame
+ // Save old frame and loop
  oldFrame=context->rstack.Frame;
+ oldIndex=context->rstack.LoopIndex;
+ oldLimit=context->rstack.LoopLimit;
 
  // Set new frame
  context->rstack.Frame=context->rstack.Pointer;
@@ -677,8 +801,14 @@ inline void wordExecutionCore(ContextType *context,uint16_t position)
  // Check if we ended with PORT_ABORT
  if (PORT_ABORT) portAbort(context);
 
- // Restore Return stack frame
+ // Release locals and local arrays
+ // This also drops loops left with EXIT
+ context->rstack.Pointer=context->rstack.Frame;
+
+ // Restore Return stack frame and loop
  context->rstack.Frame=oldFrame;
+ context->rstack.LoopIndex=oldIndex;
+ context->rstack.LoopLimit=oldLimit;
 
  // Restore old counter
  (context->Counter)=oldCounter;
@@ -706,8 +836,116 @@ void programExecute(ContextType *context,uint16_t position,int32_t primary)
  wordExecutionCore(context,position);
 
  if (primary)
-     // Erase abort flag
-     (context->Flags)&=(~CFLAG_ABORT);
+     // Erase abort flags
+     clearContextAbort(context);
+ }
+
+// Number of entries in the Base Dictionary
+static int32_t baseDictionarySize(void)
+ {
+ static int32_t size=0;
+
+ if (!size)
+	 while (BaseDictionary[size].function!=NULL) size++;
+
+ return size;
+ }
+
+// Dictionary flags of base words without an execution token
+#define XT_BAD_FLAGS  (DF_NCOMPILE|DF_ADDR|DF_BYTE|DF_DIRECTIVE)
+
+// Quick check of an execution token taken from the stack
+// User tokens must point after a well formed word header
+// This does not walk the word list so it is not as strict
+// as xtValid that is used when tokens are created and set
+// Returns 1 if it looks valid
+static int32_t xtHeaderCheck(uint16_t xt)
+ {
+ int32_t pos,nsize;
+ uint16_t link;
+
+ if (xt&XT_BASE)
+     {
+	 pos=xt&(~XT_BASE);
+	 if (pos>=baseDictionarySize()) return 0;
+	 if (BaseDictionary[pos].flags&XT_BAD_FLAGS) return 0;
+	 return 1;
+     }
+
+ if ((xt<4)||(xt>=UDict.Base.nextPos)) return 0;
+
+ // Name size and start of the header
+ nsize=UDict.Mem[xt-3];
+ if ((nsize<1)||(nsize>MAX_TOKEN_SIZE)) return 0;
+ pos=xt-3-nsize;
+ if (pos<0) return 0;
+ if (UDict.Mem[pos]<=' ') return 0;
+
+ // Link to a previous word or to no word
+ link=*((uint16_t*)&(UDict.Mem[xt-2]));
+ if ((link!=NO_WORD)&&(link>=pos)) return 0;
+
+ return 1;
+ }
+
+// Check if an execution token is valid
+// User tokens are searched in the word list
+// Returns 1 if it is valid
+int32_t xtValid(uint16_t xt)
+ {
+ if (!xtHeaderCheck(xt)) return 0;
+ if (xt&XT_BASE) return 1;
+
+ return userWordStart(xt);
+ }
+
+// Gives the execution token of a word
+// User words are searched first as the interpreter does
+// Returns NO_WORD if not found
+uint16_t xtLocate(char *name)
+ {
+ uint16_t pos;
+ int32_t base;
+
+ // User dictionary
+ pos=locateUserWord(name);
+ if (pos!=NO_WORD) return pos;
+
+ // Base dictionary
+ base=searchRegister((DictionaryEntry*)BaseDictionary,name);
+ if (base<0) return NO_WORD;
+ if (!xtValid(XT_BASE|base)) return NO_WORD;
+
+ return XT_BASE|base;
+ }
+
+// Executes a token that is known to be valid
+static void xtDispatch(ContextType *context,uint16_t xt)
+ {
+ int32_t pos;
+
+ if (xt&XT_BASE)
+     {
+	 pos=xt&(~XT_BASE);
+	 (BaseDictionary[pos].function)(context,BaseDictionary[pos].argument);
+	 return;
+     }
+
+ wordExecutionCore(context,xt);
+ }
+
+// Executes an execution token from inside a word
+// Base words are a direct call and user words run
+// the execution core without the interactive prologue
+void xtExecute(ContextType *context,uint16_t xt)
+ {
+ if (!xtHeaderCheck(xt))
+     {
+	 runtimeErrorMessage(context,"Invalid execution token");
+	 return;
+     }
+
+ xtDispatch(context,xt);
  }
 
 
@@ -724,8 +962,8 @@ int32_t findUserWord(ContextType *context,int32_t value)
  // Get word to dump
  name=tokenGet();
 
- // Locate this user word
- pos=locateUserWord(name);
+ // Locate this word
+ pos=xtLocate(name);
 
  // Error if not found
  if (pos==NO_WORD)
@@ -734,7 +972,7 @@ int32_t findUserWord(ContextType *context,int32_t value)
 	 return 0;
      }
 
- // Put word position on the stack
+ // Put the execution token on the stack
  PstackPush(context,pos);
 
  return 0;
@@ -862,6 +1100,9 @@ static int32_t newWordKernel(ContextType *context)
  // Start of coding area
  CodePosition+=2;
 
+ // There is no previous code to fuse
+ LastCodeEnd=0;
+
  // Set this as the edit word
  EditWord=CodePosition;
 
@@ -884,6 +1125,7 @@ int32_t GenNewWord(ContextType *context,int32_t value)
 
  // Init local var count
  nextLocal=0;
+ nextLocalCell=0;
  // Init local mode
  localMode=NO_LOCAL;
 
@@ -927,6 +1169,9 @@ int32_t EndNewWord(ContextType *context,int32_t value)
 	     return 0;
          }
 
+ // Use unchecked stack words if the stack effect can be verified
+ effectVerifyWord();
+
  // End the word by making the changes to UDict
  UDict.Base.lastWord=EditWord;
  UDict.Base.nextPos=CodePosition;
@@ -1227,7 +1472,7 @@ int32_t UserWordForget(ContextType *context,int32_t value)
  UNUSED(value);
 
  char *name;
- uint16_t pos,nsize,start,i;
+ uint16_t pos,nsize,start,i,word,*xt;
 
  if (anythingBackground())
        {
@@ -1268,6 +1513,18 @@ int32_t UserWordForget(ContextType *context,int32_t value)
  // Set first free position
  UDict.Base.nextPos=start;
 
+ // Deferred words left must not run a forgotten word
+ word=UDict.Base.lastWord;
+ while (word!=NO_WORD)
+     {
+	 if (UDict.Mem[word]==DEFER_CODE)
+	     {
+		 xt=(uint16_t*)(UDict.Mem+word+1);
+		 if ((!((*xt)&XT_BASE))&&((*xt)>=start)) (*xt)=NO_WORD;
+	     }
+	 word=*((uint16_t*)&(UDict.Mem[word-2]));
+     }
+
  // Erase start word if needed
  if (UDict.Base.startWord!=NO_WORD)  // If there is a start word...
 	 if (UDict.Base.startWord>=pos)
@@ -1362,6 +1619,118 @@ int32_t executeUserWord(ContextType *context,int32_t value)
  return 0;
  }
 
+// Execute the token on the stack from inside a word
+int32_t executeXT(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ int32_t xt;
+
+ if (PstackPop(context,&xt)) return 0;
+
+ xtExecute(context,(uint16_t)xt);
+
+ return 0;
+ }
+
+// Executes an execution token catching exceptions
+// ( xt -- 0 ) if there is no exception
+// ( xt -- n ) with the stack depth restored if n is thrown
+int32_t executeCatch(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ int32_t xt,code;
+ int16_t depth,sPointer,sSize,rPointer,rFrame;
+ int32_t loopIndex,loopLimit;
+
+ if (PstackPop(context,&xt)) return 0;
+
+ // Save the state to restore
+ sPointer=context->stack.Pointer;
+ sSize=context->stack.Size;
+ rPointer=context->rstack.Pointer;
+ rFrame=context->rstack.Frame;
+ loopIndex=context->rstack.LoopIndex;
+ loopLimit=context->rstack.LoopLimit;
+ depth=context->CatchDepth;
+
+ // Execute with a new catch level
+ context->ThrowCode=0;
+ context->CatchDepth=depth+1;
+ xtExecute(context,(uint16_t)xt);
+
+ // Take the exception in one locked step
+ // so a kill from other thread is never lost
+ LOCK_FLAGS
+
+ // User abort and thread kill go on
+ // with no CATCH level left active
+ if ((context->Flags)&CFLAG_KILL)
+     {
+	 context->CatchDepth=0;
+	 UNLOCK_FLAGS
+	 return 0;
+     }
+ context->CatchDepth=depth;
+
+ // Normal end
+ if (!((context->Flags)&CFLAG_ABORT))
+     {
+	 UNLOCK_FLAGS
+	 PstackPush(context,0);
+	 return 0;
+     }
+
+ // Clear the exception
+ (context->Flags)&=(~(CFLAG_EXIT|CFLAG_ABORT));
+ code=(context->ThrowCode)?(context->ThrowCode):THROW_ABORT;
+ context->ThrowCode=0;
+ UNLOCK_FLAGS
+
+ // Restore the state
+ context->stack.Pointer=sPointer;
+ context->stack.Size=sSize;
+ context->rstack.Pointer=rPointer;
+ context->rstack.Frame=rFrame;
+ context->rstack.LoopIndex=loopIndex;
+ context->rstack.LoopLimit=loopLimit;
+
+ // Give the exception code
+ PstackPush(context,code);
+
+ return 0;
+ }
+
+// Throws an exception if the top of the stack is not zero
+// ( n -- )
+int32_t executeThrow(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ int32_t code;
+
+ if (PstackPop(context,&code)) return 0;
+
+ // Zero is not an exception
+ if (!code) return 0;
+
+ // Without CATCH it is a runtime error
+ if (!(context->CatchDepth))
+     {
+	 if (SHOW_ERROR(context))
+	        consolePrintf("Exception %d not caught%s",code,BREAK);
+	 runtimeErrorMessage(context,"THROW executed");
+	 return 0;
+     }
+
+ // Set the code and abort up to the CATCH
+ context->ThrowCode=code;
+ AbortExecution(context);
+
+ return 0;
+ }
+
 /*
 // Execute a user function from address in current run position
 // Called from another word
@@ -1427,7 +1796,7 @@ int32_t executeVariable(ContextType *context,int32_t value)
  int32_t *ipos;
 
  // Take current run position as variable location
- position=(uint32_t)(UDict.Mem+context->Counter);
+ position=(uint32_t)(uintptr_t)(UDict.Mem+context->Counter);
 
  // Set pointer
  ipos=(int32_t*)&position;
@@ -1441,6 +1810,78 @@ int32_t executeVariable(ContextType *context,int32_t value)
  return 0;
  }
 
+// Direct variable access functions -------------------------------
+// The UDict data position follows the code
+// Value is the variable size in bytes
+
+// Direct variable recall
+int32_t executeDirectRecall(ContextType *context,int32_t value)
+ {
+ uint8_t *pointer;
+
+ pointer=UDict.Mem+getAddrFromHere(context);
+
+ if (value==4)
+	 PstackPush(context,*(int32_t*)pointer);
+    else
+     {
+     if (value==2)
+    	 PstackPush(context,*(int16_t*)pointer);
+        else
+    	 PstackPush(context,*(int8_t*)pointer);
+     }
+
+ return 0;
+ }
+
+// Direct variable store
+int32_t executeDirectStore(ContextType *context,int32_t value)
+ {
+ uint8_t *pointer;
+ int32_t val;
+
+ pointer=UDict.Mem+getAddrFromHere(context);
+
+ // Get val from stack
+ if (PstackPop(context,&val)) return 0;
+
+ if (value==4)
+	 *(int32_t*)pointer=val;
+    else
+     {
+     if (value==2)
+    	 *(int16_t*)pointer=(int16_t)val;
+        else
+    	 *(int8_t*)pointer=(int8_t)val;
+     }
+
+ return 0;
+ }
+
+// Direct variable store and add
+int32_t executeDirectStoreAdd(ContextType *context,int32_t value)
+ {
+ uint8_t *pointer;
+ int32_t val;
+
+ pointer=UDict.Mem+getAddrFromHere(context);
+
+ // Get val from stack
+ if (PstackPop(context,&val)) return 0;
+
+ if (value==4)
+	 *(int32_t*)pointer+=val;
+    else
+     {
+     if (value==2)
+    	 *(int16_t*)pointer+=(int16_t)val;
+        else
+    	 *(int8_t*)pointer+=(int8_t)val;
+     }
+
+ return 0;
+ }
+
 // Value execution functions ---------------------------------------
 
 // Return the 32bit value
@@ -1514,7 +1955,7 @@ int32_t executeVariableRecall(ContextType *context,int32_t value)
  if (PstackPop(context,(int32_t*)&pos)) return 0;
 
  // Set pointer
- pointer=(int32_t*)pos;
+ pointer=(int32_t*)(uintptr_t)pos;
 
  // Recall data
  PstackPush(context,*pointer);
@@ -1534,7 +1975,7 @@ int32_t executeHVariableRecall(ContextType *context,int32_t value)
  if (PstackPop(context,(int32_t*)&pos)) return 0;
 
  // Set pointer
- pointer=(int16_t*)pos;
+ pointer=(int16_t*)(uintptr_t)pos;
 
  // Recall data
  PstackPush(context,(int32_t)*pointer);
@@ -1556,7 +1997,7 @@ int32_t executeCVariableRecall(ContextType *context,int32_t value)
  if (PstackPop(context,(int32_t*)&pos)) return 0;
 
  // Set pointer
- pointer=(int8_t*)pos;
+ pointer=(int8_t*)(uintptr_t)pos;
 
  // Recall data
  PstackPush(context,(int32_t)*pointer);
@@ -1580,9 +2021,9 @@ int32_t executeIntelligentVariableRecall(ContextType *context,int32_t value)
  if (PstackPop(context,(int32_t*)&pos)) return 0;
 
  // Set pointers
- pointer32=(int32_t*)pos;
- pointer16=(int16_t*)pos;
- pointer8=(int8_t*)pos;
+ pointer32=(int32_t*)(uintptr_t)pos;
+ pointer16=(int16_t*)(uintptr_t)pos;
+ pointer8=(int8_t*)(uintptr_t)pos;
 
  // Set pointer to kind of variable
  p8=(uint8_t*)pointer32;
@@ -1619,7 +2060,7 @@ int32_t executeVariableStore(ContextType *context,int32_t value)
  if (PstackPop(context,&val)) return 0;
 
  // Set pointer
- pointer=(int32_t*)pos;
+ pointer=(int32_t*)(uintptr_t)pos;
 
  // Store data
  (*pointer)=val;
@@ -1647,7 +2088,7 @@ int32_t executeHVariableStore(ContextType *context,int32_t value)
  //if (val>MAX_2B_INT) val=MAX_2B_INT;
 
  // Set pointer
- pointer=(int16_t*)pos;
+ pointer=(int16_t*)(uintptr_t)pos;
 
  // Store data
  (*pointer)=(int16_t)val;
@@ -1675,7 +2116,7 @@ int32_t executeCVariableStore(ContextType *context,int32_t value)
  //if (val>MAX_1B_INT) val=MAX_1B_INT;
 
  // Set pointer
- pointer=(int8_t*)pos;
+ pointer=(int8_t*)(uintptr_t)pos;
 
  // Store data
  (*pointer)=(int8_t)val;
@@ -1700,9 +2141,9 @@ int32_t executeIntelligentVariableStore(ContextType *context,int32_t value)
  if (PstackPop(context,(int32_t*)&pos)) return 0;
 
  // Set pointers
- pointer32=(int32_t*)pos;
- pointer16=(int16_t*)pos;
- pointer8=(int8_t*)pos;
+ pointer32=(int32_t*)(uintptr_t)pos;
+ pointer16=(int16_t*)(uintptr_t)pos;
+ pointer8=(int8_t*)(uintptr_t)pos;
 
  // Set pointer to kind of variable
  p8=(uint8_t*)pointer32;
@@ -1752,7 +2193,7 @@ int32_t executeVariableStoreAdd(ContextType *context,int32_t value)
  if (PstackPop(context,&val)) return 0;
 
  // Set pointer
- pointer=(int32_t*)pos;
+ pointer=(int32_t*)(uintptr_t)pos;
 
  // Store and add data
  (*pointer)+=val;
@@ -1776,7 +2217,7 @@ int32_t executeHVariableStoreAdd(ContextType *context,int32_t value)
  if (PstackPop(context,&val)) return 0;
 
  // Set pointer
- pointer=(int16_t*)pos;
+ pointer=(int16_t*)(uintptr_t)pos;
 
  // Store data
  (*pointer)+=(int16_t)val;
@@ -1800,7 +2241,7 @@ int32_t executeCVariableStoreAdd(ContextType *context,int32_t value)
  if (PstackPop(context,&val)) return 0;
 
  // Set pointer
- pointer=(int8_t*)pos;
+ pointer=(int8_t*)(uintptr_t)pos;
 
  // Store data
  (*pointer)+=(int8_t)val;
@@ -1825,9 +2266,9 @@ int32_t executeIntelligentVariableStoreAdd(ContextType *context,int32_t value)
  if (PstackPop(context,(int32_t*)&pos)) return 0;
 
  // Set pointers
- pointer32=(int32_t*)pos;
- pointer16=(int16_t*)pos;
- pointer8=(int8_t*)pos;
+ pointer32=(int32_t*)(uintptr_t)pos;
+ pointer16=(int16_t*)(uintptr_t)pos;
+ pointer8=(int8_t*)(uintptr_t)pos;
 
  // Set pointer to kind of variable
  p8=(uint8_t*)pointer32;
@@ -1970,12 +2411,21 @@ int32_t inmediateTO(ContextType *context,int32_t value)
 			 if (!strCaseCmp(name,LocalNames[i]))
 			     {
 				 // Found
+				 if (LocalArray[i])
+				     {
+					 consoleErrorMessage(context,"Illegal TO/+TO destination");
+					 return 0;
+				     }
+
 				 if (value==IT_NORMAL)
-				         // Code the Set RStack Hidden Word
-				         baseCode("SETR");
-				       else
-				    	 // Code the Add to RStack Hidden Word
-				    	 baseCode("ADDR");
+				     {
+					 // Code the Set Local
+					 codeSetLocal(LocalIndex[i]);
+					 return 0;
+				     }
+
+				 // Code the Add to RStack Hidden Word
+				 baseCode("ADDR");
 
 				 //DEBUG_STRING("Code Set Local: ",name);
 
@@ -2186,6 +2636,146 @@ int32_t executeADDTOCVAL(ContextType *context,int32_t value)
  return 0;
  }
 
+// Deferred words ---------------------------------------------------
+
+// Code a deferred word
+// It holds the execution token to run
+int32_t CodeDefer(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ // Get word name and compile
+ if (GenNewWord(context,0)) return 0;
+
+ // Check if there is enough space
+ if (getUserMemory()<3)
+      {
+      consoleErrorMessage(context,"Out of memory");
+      abortCompile();  // Abort the compilation on error
+      return 0;
+      }
+
+ // Code the hidden deferred code without token
+ baseCode("DEFERRED");
+ allocate16u(NO_WORD);
+
+ // End the compilation
+ EndNewWordWithoutEnd();
+
+ return 0;
+ }
+
+// IS word is used both in compile and interactive mode
+int32_t inmediateIS(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ char *name;
+ int32_t pos,data;
+
+ // Get deferred word
+ name=tokenGet();
+
+ // Locate this user word
+ pos=locateUserWord(name);
+
+ // Error if not found
+ if (pos==NO_WORD)
+     {
+	 consolePrintf("ERROR: Deferred [%s] word not found",name);
+	 errorEpilogue();
+	 if (STATUS) abortCompile();  // Abort the compilation on error
+	 return 0;
+     }
+
+ // Check if the word is deferred
+ if (UDict.Mem[pos++]!=DEFER_CODE)
+       {
+	   consoleErrorMessage(context,"Illegal IS destination");
+	   if (STATUS) abortCompile();  // Abort the compilation on error
+	   return 0;
+       }
+
+ // If we are in interactive mode
+ if (!STATUS)
+    {
+	// Pop token from the stack
+	if (PstackPop(context,&data)) return 0;
+
+	if (!xtValid((uint16_t)data))
+	    {
+		consoleErrorMessage(context,"Invalid execution token");
+		return 0;
+	    }
+
+	*((uint16_t*)(UDict.Mem+pos))=(uint16_t)data;
+	return 0;
+    }
+
+ // If we arrive here we should be in compile mode
+
+ // Check if there is enough space
+ if (getUserMemory()<4)
+      {
+      consoleErrorMessage(context,"Out of memory");
+      abortCompile();  // Abort the compilation on error
+      return 0;
+      }
+
+ // Compile the set word and the token position
+ baseCode("TODEFER");
+ allocate16u((uint16_t)pos);
+
+ return 0;
+ }
+
+// Executes the token of a deferred word
+// The token was checked when it was set
+int32_t executeDefer(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ uint16_t xt;
+
+ // Token follows the code
+ xt=*(uint16_t*)(UDict.Mem+context->Counter);
+
+ if (xt==NO_WORD)
+	 runtimeErrorMessage(context,"Deferred word not set");
+    else
+     xtDispatch(context,xt);
+
+ // Set exit flag
+ (context->Flags)|=CFLAG_EXIT;
+
+ return 0;
+ }
+
+// Sets the token of a deferred word
+int32_t executeIS(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+ uint16_t *pointer;
+ int32_t data;
+
+ // Get pointer
+ pointer=(uint16_t*)(UDict.Mem+getAddrFromHere(context));
+
+ // Get token from stack
+ if (PstackPop(context,&data)) return 0;
+
+ if (!xtValid((uint16_t)data))
+     {
+	 runtimeErrorMessage(context,"Invalid execution token");
+	 return 0;
+     }
+
+ // Set token
+ *pointer=(uint16_t)data;
+
+ return 0;
+ }
+
 
 //--------------------------------------------------------
 
@@ -2229,27 +2819,24 @@ int32_t ProgramFunction(ContextType *context,int32_t value)
 	   // Cast to int16
 	   addr=(uint16_t)pos;
 
-	   // Check range
-	   if (addr>=UDict.Base.nextPos) return 0;
+	   // Check token
+	   if (!xtValid(addr))
+	         {
+		     consoleErrorMessage(context,"Invalid execution token");
+		     return 0;
+	         }
+
+	   // Base words are called directly
+	   if (addr&XT_BASE)
+	         {
+		     xtExecute(context,addr);
+		     return 0;
+	         }
 
 	   // Execute in primary mode
 	   programExecute(context,addr,1);
 	   break;
 
-   case PF_F_EXECUTE_WORD: // EXECUTE from another word
-	   // Try to pop one value
-	   if (PstackPop(context,&pos)) return 0;
-
-	   // Cast to int16
-	   addr=(uint16_t)pos;
-
-	   // Check range
-	   if (addr>=UDict.Base.nextPos) return 0;
-
-	   // Execute in secondary mode
-	   programExecute(context,addr,0);
-	   break;
-
    case PF_F_FORGETALL: // Erases all program memory data [INTERACTIVE]
        if (anythingBackground())
 	         {
@@ -2335,7 +2922,7 @@ int32_t ProgramFunction(ContextType *context,int32_t value)
 
    case PF_F_S_STRING: // String
 	   // Push address of string
-	   PstackPush(context,(int32_t)(UDict.Mem+(context->Counter)+1));
+	   PstackPush(context,(int32_t)(uintptr_t)(UDict.Mem+(context->Counter)+1));
 	   // Push count of string
 	   PstackPush(context,(int32_t)UDict.Mem[context->Counter]);
 	   // Increment counter to end of string
@@ -2381,6 +2968,17 @@ int32_t GeneratorFunction(ContextType *context,int32_t value)
 	   MainFlags|=MFLAG_ASSERT_ZONE;  // Start of assert zone
 	   break;
 
+   case GF_F_BRACKET_TICK: // Codes the token of next word
+	   data=xtLocate(tokenGet());
+	   if (data==NO_WORD)
+	         {
+		     consoleErrorMessage(context,"Word not found");
+		     abortCompile();
+		     return 0;
+	         }
+	   programCodeNumber(data);
+	   break;
+
    case GF_F_DEBUG_START: // Codes "debug("
 	   if (MainFlags&(MFLAG_DEBUG_ZONE|MFLAG_ASSERT_ZONE))
 	         {
@@ -2600,6 +3198,8 @@ int32_t See(ContextType *context,int32_t value)
      { consolePrintf("This is a 8 bit value%s",BREAK); return 0; }
  if (data==CRT_CODE)
      { consolePrintf("This is a create field%s",BREAK); return 0; }
+ if (data==DEFER_CODE)
+     { consolePrintf("This is a deferred word%s",BREAK); return 0; }
 
  consolePrintf("Decoding of word %s%s%s",name,BREAK,BREAK);
 
@@ -2728,8 +3328,24 @@ int32_t See(ContextType *context,int32_t value)
     	  CBK;
     	  break;
 
+      case TODEFER_CODE:
+    	  number=uint16get()-1;
+    	  consolePrintf("IS ");
+    	  showWordName(number);
+    	  CBK;
+    	  break;
+
 
       default:
+    	  // Direct variable access is shown as the variable and the access
+    	  if ((data>=DV_FIRST_CODE)&&(data<=DV_LAST_CODE))
+    	        {
+    		    number=uint16get()-1;
+    		    showWordName(number);
+    		    consolePrintf(" %s",BaseDictionary[data].name+2);
+    		    CBK;
+    		    break;
+    	        }
     	  showCommand(data);
       }
 
@@ -2824,6 +3440,9 @@ int32_t userList(ContextType *context,int32_t value)
      case CRT_CODE:
     	 consolePrintf(" : Create word of %d bytes",wsize-1);
     	 break;
+     case DEFER_CODE:
+    	 consolePrintf(" : Deferred word");
+    	 break;
 
      default:
     	 consolePrintf(" : Program word of %d bytes",wsize);
@@ -2862,15 +3481,78 @@ int32_t userList(ContextType *context,int32_t value)
      GETR Byte   : Gets identified RStack cell and pushes on parameter stack
      SETR Byte   : Pops from stack and sets identified RStack cell
 
+ The first FAST_LOCALS positions have their own codes without byte:
+     GET0..GET3  : Same as GETR 0..3
+     SET0..SET3  : Same as SETR 0..3
+
+ Local arrays use the definition [ n ] LARRAY name
+ They take n cells of the return stack
+     LALLOT Byte : Allocates Byte zeroed cells on the return stack
+     LADDR Byte  : Pushes the address of ReturnStackFrame+Byte
+
  Compilation:
     For each new local a ">R" is compiled
     At the end of the program the ReturnStackFrame is restored so
     there is no need to drop from return stack
  */
 
+// --- LOCAL STATIC FUNCTIONS ------------------------------------
+
+// Names for the fast local codes
+static const char *const GetLocalNames[FAST_LOCALS]={"GET0","GET1","GET2","GET3"};
+static const char *const SetLocalNames[FAST_LOCALS]={"SET0","SET1","SET2","SET3"};
+
+// Code a get local from its return stack index
+// Returns 0 if OK
+static int32_t codeGetLocal(int32_t index)
+ {
+ // Check if there is space
+ if ((CodePosition+2)>=UD_MEMSIZE)
+     {
+	 consoleErrorMessage(&MainContext,"Out of memory getting local value");
+	 return 2;
+     }
+
+ // Use the fast code if possible
+ if (index<FAST_LOCALS)
+	 return baseCode((char*)GetLocalNames[index]);
+
+ // Code the Get from RStack Hidden Word
+ baseCode("GETR");
+
+ // Set the RStack position relative to current fame
+ UDict.Mem[CodePosition++]=index;
+
+ return 0;
+ }
+
 
 // --- LOCAL PUBLIC FUNCTIONS ------------------------------------
 
+// Code a set local from its return stack index
+// Returns 0 if OK
+int32_t codeSetLocal(int32_t index)
+ {
+ // Check if there is space
+ if ((CodePosition+2)>=UD_MEMSIZE)
+     {
+	 consoleErrorMessage(&MainContext,"Out of memory setting local value");
+	 return 2;
+     }
+
+ // Use the fast code if possible
+ if (index<FAST_LOCALS)
+	 return baseCode((char*)SetLocalNames[index]);
+
+ // Code the Set RStack Hidden Word
+ baseCode("SETR");
+
+ // Set the RStack position relative to current fame
+ UDict.Mem[CodePosition++]=index;
+
+ return 0;
+ }
+
 // Code a local in a {    -- } zone
 void codeLocalDefinition(char *token)
  {
@@ -2882,14 +3564,16 @@ void codeLocalDefinition(char *token)
      }
 
  // Check if we are out of local space
- if (nextLocal==MAX_LOCALS)
+ if ((nextLocal==MAX_LOCALS)||(nextLocalCell>=MAX_LOCAL_CELLS))
      {
 	 consoleErrorMessage(&MainContext,"No space for more locals");
 	 return;
      }
 
  // Add local to the list
+ LocalArray[nextLocal]=0;
  strCaseCpy(token,LocalNames[nextLocal++]);
+ nextLocalCell++;
 
  // Code the ">R" word
  if (baseCode(">R"))
@@ -2913,20 +3597,22 @@ int32_t tokenCheckLocal(char *token)
 	    {
 		// Found
 
-		// Check if there is space
-		if ((CodePosition+2)>=UD_MEMSIZE)
+		// Arrays give their address
+		if (LocalArray[i])
 		    {
-			consoleErrorMessage(&MainContext,"Out of memory getting local value");
-			return 2;
+			if ((CodePosition+2)>=UD_MEMSIZE)
+			    {
+				consoleErrorMessage(&MainContext,"Out of memory getting local array");
+				return 2;
+			    }
+			baseCode("LADDR");
+			UDict.Mem[CodePosition++]=LocalIndex[i];
+			return 0;
 		    }
 
-		// Code the Get from RStack Hidden Word
-		baseCode("GETR");
-
 		//DEBUG_STRING("Code Get Local: ",token);
 
-		// Set the RStack position relative to current fame
-		UDict.Mem[CodePosition++]=LocalIndex[i];
+		codeGetLocal(LocalIndex[i]);
 
 		return 0; // Found
 	    }
@@ -2955,6 +3641,7 @@ int32_t CodeLocalsDelimiters(ContextType *context,int32_t value)
 
 	   // Set start of group
 	   firstLocalInGroup=nextLocal;
+	   firstCellInGroup=nextLocalCell;
 
 	   //DEBUG_MESSAGE("Locals {");
 	   break;
@@ -2989,13 +3676,75 @@ int32_t CodeLocalsDelimiters(ContextType *context,int32_t value)
 
 	   // Set index for each local
 	   for(i=firstLocalInGroup;i<nextLocal;i++)
-		   LocalIndex[i]=nextLocal+firstLocalInGroup-i-1;
+		   LocalIndex[i]=nextLocal+firstCellInGroup-i-1;
 	   break;
    }
 
  return 0;
  }
 
+// Implements the LARRAY word
+// The size is taken from the stack at compile time: [ n ] LARRAY name
+int32_t CodeLocalArray(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+ int32_t size;
+ char *name;
+
+ // Get array name
+ name=tokenGet();
+
+ // Not inside a local definition
+ if (localMode!=NO_LOCAL)
+      {
+	  consoleErrorMessage(context,"Improper location of LARRAY");
+	  return 0;
+      }
+
+ // Get size
+ if (PstackPop(context,&size)) return 0;
+
+ // Check that we are not inside a loop
+ if (PstackGetSize(&MainContext))
+     {
+	 consoleErrorMessage(context,"Cannot define locals inside a loop");
+	 return 0;
+     }
+
+ // Check size
+ if ((size<1)||((nextLocalCell+size)>MAX_LOCAL_CELLS))
+      {
+	  consoleErrorMessage(context,"Invalid local array size");
+	  return 0;
+      }
+
+ // Check if we are out of local space
+ if (nextLocal==MAX_LOCALS)
+     {
+	 consoleErrorMessage(context,"No space for more locals");
+	 return 0;
+     }
+
+ // Check if there is space
+ if ((CodePosition+2)>=UD_MEMSIZE)
+     {
+	 consoleErrorMessage(context,"Out of memory coding a local array");
+	 return 0;
+     }
+
+ // Code the allocation
+ baseCode("LALLOT");
+ UDict.Mem[CodePosition++]=(uint8_t)size;
+
+ // Add local to the list
+ LocalArray[nextLocal]=1;
+ LocalIndex[nextLocal]=nextLocalCell;
+ strCaseCpy(name,LocalNames[nextLocal++]);
+ nextLocalCell+=size;
+
+ return 0;
+ }
+
 // Executes the SETR hidden word
 // Gets following byte and calculates a return stack position:
 //    pos=ReturnStackFrame+Byte+1
@@ -3063,6 +3812,72 @@ int32_t executeADDR(ContextType *context,int32_t value)
  return 0;
  }
 
+// Executes the GET0..GET3 hidden words
+// Value is the position after the frame
+int32_t executeGETL(ContextType *context,int32_t value)
+ {
+ PstackPush(context,context->rstack.data[(context->rstack.Frame)+value+1]);
+
+ return 0;
+ }
+
+// Executes the SET0..SET3 hidden words
+// Value is the position after the frame
+int32_t executeSETL(ContextType *context,int32_t value)
+ {
+ int32_t data;
+
+ // Pops one value
+ if (PstackPop(context,&data)) return 0;
+
+ context->rstack.data[(context->rstack.Frame)+value+1]=data;
+
+ return 0;
+ }
+
+// Executes the LALLOT hidden word
+// Gets following byte and allocates this number
+// of cells, set to zero, on the return stack
+int32_t executeLALLOT(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+ int32_t n;
+
+ // Get size
+ n=UDict.Mem[(context->Counter)++];
+
+ // Check space
+ if (((context->rstack.Pointer)+n)>=RSTK_SIZE)
+       {
+	   runtimeErrorMessage(context,"Rstack overflow in local array");
+	   return 0;
+       }
+
+ // Allocate it
+ while (n--)
+	 context->rstack.data[++(context->rstack.Pointer)]=0;
+
+ return 0;
+ }
+
+// Executes the LADDR hidden word
+// Gets following byte and calculates a return stack position:
+//    pos=ReturnStackFrame+Byte+1
+// Pushes the address of RS[pos] on the Parameter Stack
+int32_t executeLADDR(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+ int32_t pos;
+
+ // Calculates position in stack
+ pos=(int32_t)(context->rstack.Frame)
+              +UDict.Mem[(context->Counter)++]+1;
+
+ PstackPush(context,(int32_t)(uintptr_t)&(context->rstack.data[pos]));
+
+ return 0;
+ }
+
 // CREATE ------------------------------------------------------
 
 // Executes the CREATE interactive word
@@ -3202,8 +4017,53 @@ static void locateWord(int32_t pos)
 
  }
 
+// Decompiles the token set in a deferred word as ' y IS x
+// Nothing is shown if the token is not set
+static void DecompileIS(int32_t pos)
+ {
+ uint16_t xt;
+
+ xt=*(uint16_t*)(UDict.Mem+pos+1);
+ if (xt==NO_WORD) return;
+
+ if (xt&XT_BASE)
+     {
+	 consolePrintf(" ' %s IS ",BaseDictionary[xt&(~XT_BASE)].name);
+     }
+    else
+     {
+	 consolePrintf(" ' ");
+	 showWordName(xt);
+	 consolePrintf(" IS ");
+     }
+ showWordName(pos);
+ }
+
+// Gives the position of the first word after the given one
+// Returns NO_WORD if there are no more words
+static uint16_t nextWordAfter(uint16_t last)
+ {
+ uint16_t pos,prev;
+ char *pchar;
+
+ // Start word search
+ startWordSearch();
+
+ // Words are found from the last one to the first one
+ pos=NO_WORD;
+ do
+  {
+  prev=pos;
+  pchar=nextWordSearch(&pos);
+  }
+  while ((pos>last)&&(pchar!=NULL));
+
+ return prev;
+ }
+
 // Decompile a word from its position
-int32_t Decompile(int32_t pos)
+// If deferSet is false the token of deferred words is not shown
+int32_t Decompile(int32_t pos,int32_t deferSet)
  {
  int32_t wsize;
  uint8_t data;
@@ -3324,6 +4184,17 @@ int32_t Decompile(int32_t pos)
 	 return 0;
      }
 
+ if (data==DEFER_CODE)
+     {
+	 consolePrintf("DEFER ");
+	 showWordName(pos);
+	 if (deferSet) DecompileIS(pos);
+	 if (wsize>3)
+	 		 DecompileExtra(pos+3,wsize-3);
+	 CBK; CBK;
+	 return 0;
+     }
+
  // Program header
  consolePrintf(": ");
  showWordName(pos);
@@ -3424,6 +4295,12 @@ int32_t Decompile(int32_t pos)
     	  showWordName(number);
     	  CBK;
     	  break;
+      case TODEFER_CODE:
+    	  number=uint16get()-1;
+    	  consolePrintf("IS ");
+    	  showWordName(number);
+    	  CBK;
+    	  break;
 
       case ENDWORD_CODE:
     	  consolePrintf(";%s",BREAK);
@@ -3444,6 +4321,18 @@ int32_t Decompile(int32_t pos)
     	  number=calculateRelative(number);
     	  consolePrintf("[ %d ] JNZ%s",number,BREAK);
           break;
+      case JLT_CODE:
+      case JGT_CODE:
+      case JLE_CODE:
+      case JGE_CODE:
+      case JEQ_CODE:
+      case JNE_CODE:
+      case J0GE_CODE:
+      case J0LE_CODE:
+    	  number=uint16get();
+    	  number=calculateRelative(number);
+    	  consolePrintf("[ %d ] %s%s",number,BaseDictionary[data].name,BREAK);
+          break;
       case DO_CODE:
     	  consolePrintf("_DO%s",BREAK);
           break;
@@ -3484,7 +4373,47 @@ int32_t Decompile(int32_t pos)
      	  number=uint8get();
      	  consolePrintf("[ %d ] ADDR%s",number,BREAK);
           break;
+      case LALLOT_CODE:
+     	  number=uint8get();
+     	  consolePrintf("[ %d ] LALLOT%s",number,BREAK);
+          break;
+      case LADDR_CODE:
+     	  number=uint8get();
+     	  consolePrintf("[ %d ] LADDR%s",number,BREAK);
+          break;
       default:
+    	  // Direct variable access is shown as the variable and the access
+    	  if ((data>=DV_FIRST_CODE)&&(data<=DV_LAST_CODE))
+    	        {
+    		    number=uint16get()-1;
+    		    showWordName(number);
+    		    consolePrintf(" %s",BaseDictionary[data].name+2);
+    		    CBK;
+    		    break;
+    	        }
+    	  // Entry check is generated again when the word is compiled
+    	  if (data==CHKD_CODE)
+    	        {
+    		    decodePosition++;
+    		    break;
+    	        }
+    	  // Unchecked words are decompiled as the checked ones
+    	  if ((data>=UNC_FIRST_CODE)&&(data<=UNC_LAST_CODE))
+    	        {
+    		    consolePrintf("%s%s",BaseDictionary[data].name+1,BREAK);
+    		    break;
+    	        }
+    	  // Fast locals are decompiled as GETR and SETR
+    	  if ((data>=GET0_CODE)&&(data<(GET0_CODE+FAST_LOCALS)))
+    	        {
+    		    consolePrintf("[ %d ] GETR%s",data-GET0_CODE,BREAK);
+    		    break;
+    	        }
+    	  if ((data>=SET0_CODE)&&(data<(SET0_CODE+FAST_LOCALS)))
+    	        {
+    		    consolePrintf("[ %d ] SETR%s",data-SET0_CODE,BREAK);
+    		    break;
+    	        }
     	  showCommand(data);
       }
 
@@ -3528,7 +4457,7 @@ int32_t DecompileWord(ContextType *context,int32_t value)
      }
 
  // Decompile the word
- Decompile(pos);
+ Decompile(pos,1);
 
  return 0;
  }
@@ -3539,9 +4468,7 @@ int32_t DecompileAll(ContextType *context,int32_t value)
  {
  UNUSED(value);
 
- uint16_t last=0,prev;
  uint16_t pos;
- char  *pchar;
 
  // Check if info is enabled
  if (NO_RESPONSE(context)) return 0;
@@ -3556,27 +4483,20 @@ int32_t DecompileAll(ContextType *context,int32_t value)
  // Header
  consolePrintf("%sFSTART \\Start of full decompilation%s%s",BREAK,BREAK,BREAK);
 
- do
-  {
-  // Start word search
-  startWordSearch();
+ // All words from the first one
+ pos=0;
+ while ((pos=nextWordAfter(pos))!=NO_WORD)
+	 Decompile(pos,0);
 
-  // Locate next word to display
-  pos=NO_WORD;
-  do
-   {
-   prev=pos;
-   pchar=nextWordSearch(&pos);
-   }
-   while ((pos>last)&&(pchar!=NULL));
-
-  last=prev;
-
-  // Check if there is a previous word
-  if (prev!=NO_WORD)
-	         Decompile(last);
-  }
-  while(prev!=NO_WORD);
+ // Deferred words are set after all words are defined
+ // as the token can be a word defined after them
+ pos=0;
+ while ((pos=nextWordAfter(pos))!=NO_WORD)
+	 if ((UDict.Mem[pos]==DEFER_CODE)&&(*(uint16_t*)(UDict.Mem+pos+1)!=NO_WORD))
+	     {
+		 DecompileIS(pos);
+		 CBK; CBK;
+	     }
 
  //Footer
  consolePrintf("FEND \\End of full decompilation%s%s",BREAK,BREAK);
@@ -3600,7 +4520,16 @@ int32_t CompileDecompiled(ContextType *context,int32_t value)
  	 }
 
  // Code the word
- UDict.Mem[CodePosition]=JMP_CODE+value;
+ // Fused compare jumps start at 12 and local arrays at 20
+ if (value<12)
+	 UDict.Mem[CodePosition]=JMP_CODE+value;
+    else
+     {
+     if (value<20)
+         UDict.Mem[CodePosition]=JLT_CODE+value-12;
+        else
+         UDict.Mem[CodePosition]=LALLOT_CODE+value-20;
+     }
 
  // Return in _DO word because it has no jump address
  if (value==3) { CodePosition++; return 0; }
@@ -3608,10 +4537,21 @@ int32_t CompileDecompiled(ContextType *context,int32_t value)
  // Pop from stack
  if (PstackPop(context,&data)) return 0;
 
- if (value<=8)
+ // SETR and GETR to the first locals use the fast codes
+ if (((value==9)||(value==10))&&(data>=0)&&(data<FAST_LOCALS))
+      {
+	  if (value==9)
+		  UDict.Mem[CodePosition++]=SET0_CODE+data;
+	     else
+	      UDict.Mem[CodePosition++]=GET0_CODE+data;
+	  return 0;
+      }
+
+ if ((value<=8)||((value>=12)&&(value<20)))
       {
 	  // We code a 16 bit relative address
 	  // JMP JZ JNZ P_DO N_DO _LOOP _@LOOP _OF
+	  // and the fused compare jumps
 
       // Code the address converting to absolute positions
       pointer=(uint16_t*)(UDict.Mem+CodePosition+1);
@@ -3623,7 +4563,7 @@ int32_t CompileDecompiled(ContextType *context,int32_t value)
      else
       {
       // We code a 8 bit absolute address
-      // SETR GETR ADDR
+      // SETR GETR ADDR LALLOT LADDR
 
       // Code the address
       pointer8=(uint8_t*)(UDict.Mem+CodePosition+1);
@@ -3649,7 +4589,7 @@ int32_t StringFunction(ContextType *context,int32_t value)
 	   // Pop the address from the stack
 	   if (PstackPop(context,&addr)) return 0;
 	   // Convert to pointer to count and increase addr
-	   p8=(uint8_t*)addr++;
+	   p8=(uint8_t*)(uintptr_t)addr++;
 	   // Push new addr
 	   PstackPush(context,addr);
 	   // Push count
@@ -3671,7 +4611,7 @@ int32_t StringFunction(ContextType *context,int32_t value)
 	   if (NO_RESPONSE(context)) return 0;
 	   while (number)
 	       {
-		   consolePutChar((int32_t)*((int8_t*)addr++));
+		   consolePutChar((int32_t)*((int8_t*)(uintptr_t)addr++));
 		   number--;
 	       }
 	   break;
@@ -3680,7 +4620,7 @@ int32_t StringFunction(ContextType *context,int32_t value)
 	   // Pop addr from the stack
 	   if (PstackPop(context,&addr)) return 1;
        // Obtain count and increase address
-	   number=(int32_t)(*(uint8_t*)addr++);
+	   number=(int32_t)(*(uint8_t*)(uintptr_t)addr++);
 	   // Check count
 	   if (number<0)
 	  	   {
@@ -3691,7 +4631,7 @@ int32_t StringFunction(ContextType *context,int32_t value)
 	   if (NO_RESPONSE(context)) return 0;
 	   while (number)
 	  	   {
-	  	   consolePutChar((int32_t)*((int8_t*)addr++));
+	  	   consolePutChar((int32_t)*((int8_t*)(uintptr_t)addr++));
 	  	   number--;
 	  	   }
 	   break;
@@ -3702,7 +4642,7 @@ int32_t StringFunction(ContextType *context,int32_t value)
 	   // Check verbose
 	   if (NO_RESPONSE(context)) return 0;
 	   // Print it
-	   consolePrintf((char *)addr);
+	   consolePrintf((char *)(uintptr_t)addr);
 	   break;
    }
 
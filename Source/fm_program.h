@@ -62,16 +62,21 @@ void programErase(void);
 void programInit(void);
 void userWordList(void);
 uint16_t locateUserWord(char *name);
+int32_t userWordStart(uint16_t position);
 int32_t  getUserMemory(void);
 void codePrintString(char *pointer);
 void codeString(char *pointer);
 void showWordName(int32_t addr);
+void portAbort(ContextType *context);
+void clearContextAbort(ContextType *context);
+void killExecution(ContextType *context);
 
 // User Coding Functions
 void abortCompile(void);
 int32_t baseCode(char *word);
 void programCodeNumber(int32_t value);
 int32_t codeUserPosition(uint16_t position);
+int32_t codeDirectAccess(int32_t pos);
 
 // Datatype coding
 int32_t CodeConstant(ContextType *context,int32_t value);
@@ -94,12 +99,18 @@ int32_t CodeLocalsDelimiters(ContextType *context,int32_t value);
 #define LOCAL_D_START   0  // Codes "{"
 #define LOCAL_D_COMMENT 1  // Codes "--"
 #define LOCAL_D_END     2  // Codes "}"
+int32_t CodeLocalArray(ContextType *context,int32_t value);
 void codeLocalDefinition(char *token);
 int32_t tokenCheckLocal(char *token);
+int32_t codeSetLocal(int32_t index);
 // Local variable execution
 int32_t executeSETR(ContextType *context,int32_t value);
 int32_t executeGETR(ContextType *context,int32_t value);
 int32_t executeADDR(ContextType *context,int32_t value);
+int32_t executeGETL(ContextType *context,int32_t value);
+int32_t executeSETL(ContextType *context,int32_t value);
+int32_t executeLALLOT(ContextType *context,int32_t value);
+int32_t executeLADDR(ContextType *context,int32_t value);
 
 // User execute and interactive functions
 int32_t SetStartWord(ContextType *context,int32_t value);
@@ -120,11 +131,31 @@ int32_t executeIntelligentVariableStore(ContextType *context,int32_t value);
 int32_t executeVariableStoreAdd(ContextType *context,int32_t value);
 int32_t executeHVariableStoreAdd(ContextType *context,int32_t value);
 int32_t executeCVariableStoreAdd(ContextType *context,int32_t value);
+int32_t executeDirectRecall(ContextType *context,int32_t value);
+int32_t executeDirectStore(ContextType *context,int32_t value);
+int32_t executeDirectStoreAdd(ContextType *context,int32_t value);
 int32_t executeIntelligentVariableStoreAdd(ContextType *context,int32_t value);
 int32_t executeValue(ContextType *context,int32_t value);
 int32_t executeHValue(ContextType *context,int32_t value);
 int32_t executeCValue(ContextType *context,int32_t value);
 
+// Execution tokens
+// User words use their UDict position and base words
+// their Base Dictionary position with XT_BASE set
+#define XT_BASE      0x8000
+int32_t xtValid(uint16_t xt);
+uint16_t xtLocate(char *name);
+void xtExecute(ContextType *context,uint16_t xt);
+int32_t executeXT(ContextType *context,int32_t value);
+int32_t executeCatch(ContextType *context,int32_t value);
+int32_t executeThrow(ContextType *context,int32_t value);
+
+// Deferred words
+int32_t CodeDefer(ContextType *context,int32_t value);
+int32_t inmediateIS(ContextType *context,int32_t value);
+int32_t executeDefer(ContextType *context,int32_t value);
+int32_t executeIS(ContextType *context,int32_t value);
+
 int32_t wordHelpCommand(ContextType *context,int32_t value);
 int32_t baseWords(ContextType *context,int32_t value);
 
@@ -152,7 +183,6 @@ int32_t ProgramFunction(ContextType *context,int32_t value);
 #define PF_F_EXIT            10
 #define PF_F_ABORT           11
 #define PF_F_EXECUTE_INT     12
-#define PF_F_EXECUTE_WORD    13
 #define PF_F_FORGETALL       14
 #define PF_F_SAVE            15
 #define PF_F_LOAD            16
@@ -178,6 +208,7 @@ int32_t GeneratorFunction(ContextType *context,int32_t value);
 #define GF_F_LITERAL          2  // Pops stack and codes it
 #define GF_F_ASRT_START       3  // Start of assert zone
 #define GF_F_DEBUG_START      4  // Start of debug zone
+#define GF_F_BRACKET_TICK     5  // Codes an execution token
 
 int32_t findUserWord(ContextType *context,int32_t value);
 int32_t UserWordDump(ContextType *context,int32_t value);
@@ -35,6 +35,7 @@
 #include "fm_test.h"        // Test header file
 #include "fm_branch.h"      // Branch header file
 #include "fm_threads.h"     // Threads header file
+#include "fm_translate.h"   // Translation header file
 #include "fm_register.h"    // This module header file
 #include "fp_modules.h"     // Port modules for external Words
 
@@ -126,6 +127,63 @@ const DictionaryEntry BaseDictionary[]=
 		{"GETR","Get RStack value",executeGETR,0,DF_NCOMPILE|DF_BYTE},
 		{"ADDR","Add to RStack value",executeADDR,0,DF_NCOMPILE|DF_BYTE},
 
+		// Deferred words
+		// They have the codes 37 and 38
+		{"DEFERRED","Deferred word marker",executeDefer,0,DF_NCOMPILE|DF_ADDR},
+		{"TODEFER","Set deferred word",executeIS,0,DF_NCOMPILE|DF_ADDR},
+
+		// Fused compare and branch words
+		// They have the codes 39 to 46
+		{"JLT","Jump if less than",JumpCompare,F_JCMP_LT,DF_NCOMPILE|DF_ADDR},
+		{"JGT","Jump if greater than",JumpCompare,F_JCMP_GT,DF_NCOMPILE|DF_ADDR},
+		{"JLE","Jump if less or equal",JumpCompare,F_JCMP_LE,DF_NCOMPILE|DF_ADDR},
+		{"JGE","Jump if greater or equal",JumpCompare,F_JCMP_GE,DF_NCOMPILE|DF_ADDR},
+		{"JEQ","Jump if equal",JumpCompare,F_JCMP_EQ,DF_NCOMPILE|DF_ADDR},
+		{"JNE","Jump if not equal",JumpCompare,F_JCMP_NE,DF_NCOMPILE|DF_ADDR},
+		{"J0GE","Jump if not negative",JumpCompare,F_JCMP_0GE,DF_NCOMPILE|DF_ADDR},
+		{"J0LE","Jump if not positive",JumpCompare,F_JCMP_0LE,DF_NCOMPILE|DF_ADDR},
+
+		// Fast locals and local arrays
+		// They have the codes 47 to 56
+		{"GET0","Get local 0",executeGETL,0,DF_NCOMPILE},
+		{"GET1","Get local 1",executeGETL,1,DF_NCOMPILE},
+		{"GET2","Get local 2",executeGETL,2,DF_NCOMPILE},
+		{"GET3","Get local 3",executeGETL,3,DF_NCOMPILE},
+		{"SET0","Set local 0",executeSETL,0,DF_NCOMPILE},
+		{"SET1","Set local 1",executeSETL,1,DF_NCOMPILE},
+		{"SET2","Set local 2",executeSETL,2,DF_NCOMPILE},
+		{"SET3","Set local 3",executeSETL,3,DF_NCOMPILE},
+		{"LALLOT","Allocate local array",executeLALLOT,0,DF_NCOMPILE|DF_BYTE},
+		{"LADDR","Local array address",executeLADDR,0,DF_NCOMPILE|DF_BYTE},
+
+		// Direct variable access
+		// They have the codes 57 to 65
+		{"DV@","Direct 32 bit variable recall",executeDirectRecall,4,DF_NCOMPILE|DF_ADDR},
+		{"DV!","Direct 32 bit variable store",executeDirectStore,4,DF_NCOMPILE|DF_ADDR},
+		{"DV+!","Direct 32 bit variable store and add",executeDirectStoreAdd,4,DF_NCOMPILE|DF_ADDR},
+		{"DVH@","Direct 16 bit variable recall",executeDirectRecall,2,DF_NCOMPILE|DF_ADDR},
+		{"DVH!","Direct 16 bit variable store",executeDirectStore,2,DF_NCOMPILE|DF_ADDR},
+		{"DVH+!","Direct 16 bit variable store and add",executeDirectStoreAdd,2,DF_NCOMPILE|DF_ADDR},
+		{"DVC@","Direct 8 bit variable recall",executeDirectRecall,1,DF_NCOMPILE|DF_ADDR},
+		{"DVC!","Direct 8 bit variable store",executeDirectStore,1,DF_NCOMPILE|DF_ADDR},
+		{"DVC+!","Direct 8 bit variable store and add",executeDirectStoreAdd,1,DF_NCOMPILE|DF_ADDR},
+
+		// Verified stack effect words
+		// Entry check has the code 66
+		// Unchecked stack words have the codes 67 to 77
+		{"CHKD","Check stack depth at word entry",PstackCheckDepth,0,DF_NCOMPILE|DF_BYTE},
+		{"UDROP","Unchecked DROP",PstackUncheckedFunction,UNC_F_DROP,DF_NCOMPILE},
+		{"UDUP","Unchecked DUP",PstackUncheckedFunction,UNC_F_DUP,DF_NCOMPILE},
+		{"UOVER","Unchecked OVER",PstackUncheckedFunction,UNC_F_OVER,DF_NCOMPILE},
+		{"USWAP","Unchecked SWAP",PstackUncheckedFunction,UNC_F_SWAP,DF_NCOMPILE},
+		{"UNIP","Unchecked NIP",PstackUncheckedFunction,UNC_F_NIP,DF_NCOMPILE},
+		{"U+","Unchecked +",PstackUncheckedFunction,UNC_F_ADD,DF_NCOMPILE},
+		{"U-","Unchecked -",PstackUncheckedFunction,UNC_F_SUB,DF_NCOMPILE},
+		{"U*","Unchecked *",PstackUncheckedFunction,UNC_F_MULT,DF_NCOMPILE},
+		{"UAND","Unchecked AND",PstackUncheckedFunction,UNC_F_AND,DF_NCOMPILE},
+		{"UOR","Unchecked OR",PstackUncheckedFunction,UNC_F_OR,DF_NCOMPILE},
+		{"UXOR","Unchecked XOR",PstackUncheckedFunction,UNC_F_XOR,DF_NCOMPILE},
+
 		// Words from now can be directly compiled ---------------------------
 
 		// Assert check
@@ -137,7 +195,11 @@ const DictionaryEntry BaseDictionary[]=
 		{"ABORT","Abort to interactive mode",ProgramFunction,PF_F_ABORT,DF_NI},
 
 		// Execute User Dictionary from UDict address
-	    {"EXECUTE","Execute from address#(uaddr)$",ProgramFunction,PF_F_EXECUTE_WORD,0},
+	    {"EXECUTE","Execute an execution token#(xt)$",executeXT,0,0},
+
+		// Exceptions
+		{"CATCH","Execute a token catching exceptions#(xt)$(0|n)",executeCatch,0,0},
+		{"THROW","Throw exception if not zero#(n)$",executeThrow,0,0},
 
 		// Stack commands implemented in PstackFunction
 		{"DROP","Drop stack top#(n)->",PstackFunction,STACK_F_DROP,0},
@@ -267,19 +329,18 @@ const DictionaryEntry BaseDictionary[]=
 
 
 	    // Return stack commands
-	    // Use alias "I" -> "R@"
 	    {"RDUMP","Return stack dump",RstackList,0,0},
 	    {">R","RS to PS#(n)$ R:$(n)",RstackFunction,RSTACK_F_TO_R,0},
 	    {"R>","PS to RS#$(n) R:(n)$",RstackFunction,RSTACK_R_TO_F,0},
-	    {"R@","Get RS top without popping#$(n) R:(n)$(n)",RstackFunction,RSTACK_RTOP,0},
-	    {"I","Get first do index#$(n) R:(n)$(n)",RstackFunction,RSTACK_GET_I,0},
-	    {"J","Get second do index#$(n3) R:(n3)(n2)(n1)$(n3)(n2)(n1)",RstackFunction,RSTACK_GET_J,0},
-	    {"K","Get third do index#$(n5) R:(n5)..(n1)$(n5)..(n1)",RstackFunction,RSTACK_GET_K,0},
+	    {"R@","Get RS top without popping (not the DO index, use I)#$(n) R:(n)$(n)",RstackFunction,RSTACK_RTOP,0},
+	    {"I","Get first do index#$(n)",ExecuteLoopIndex,F_INDEX_I,0},
+	    {"J","Get second do index#$(n)",ExecuteLoopIndex,F_INDEX_J,0},
+	    {"K","Get third do index#$(n)",ExecuteLoopIndex,F_INDEX_K,0},
 	    {"RCLEAR","Clear return stack",RstackFunction,RSTACK_CLEAR,0},
 	    {"RDROP","Drop top of return stack",RstackFunction,RSTACK_DROP,0},
 
 	    // Branch public words
-	    {"UNLOOP","Undo loop effect on return stack#R (n)(n)$",ExecuteUNLOOP,0,0},
+	    {"UNLOOP","Undo loop effect on return stack",ExecuteUNLOOP,0,0},
 
 	    // Thread words
         #ifdef USE_THREADS
@@ -296,7 +357,7 @@ const DictionaryEntry BaseDictionary[]=
 	    {"C,","Allocate and set one Char#(data)$",comma,COMMA_8,0},
 
 	    // ' <word>
-	    {"'","Obtains an user word address#$(Uaddr)",findUserWord,0,DF_DIRECTIVE},
+	    {"'","Obtains an execution token#$(xt)",findUserWord,0,DF_DIRECTIVE},
 
 	    // We could need [ ] from inside a word definition
 	    {"HERE","Push next code position#$(Uaddr)",ProgramFunction,PF_F_HERE,0},
@@ -348,10 +409,12 @@ const DictionaryEntry InteractiveDictionary[]=
        {"VALUE","Create a 32 bit value#(value)$",CodeValue,0,DF_DIRECTIVE},
        {"HVALUE","Create a 16 bit value#(value)$",CodeHValue,0,DF_DIRECTIVE},
        {"CVALUE","Create a 8 bit value#(value)$",CodeCValue,0,DF_DIRECTIVE},
-       {"EXECUTE","Execute from address#(uaddr)$",ProgramFunction,PF_F_EXECUTE_INT,0},
+       {"EXECUTE","Execute an execution token#(xt)$",ProgramFunction,PF_F_EXECUTE_INT,0},
+       {"DEFER","Create a deferred word",CodeDefer,0,DF_DIRECTIVE},
 
        {"TO","Set a value#(value)$",inmediateTO,IT_NORMAL,DF_DIRECTIVE},
        {"+TO","Add to a value#(value)$",inmediateTO,IT_ADD,DF_DIRECTIVE},
+       {"IS","Set a deferred word#(xt)$",inmediateIS,0,DF_DIRECTIVE},
 
        // These are interactive because we cannot erase the running program
        {"FORGET","Forget a user word#Usage: FORGET <word>",UserWordForget,0,0},
@@ -386,6 +449,7 @@ const DictionaryEntry InteractiveDictionary[]=
 
        {"DECOMPILE","Decompile a user word code",DecompileWord,0,DF_DIRECTIVE},
        {"DECOMPILEALL","Decompile the full User Dictionary",DecompileAll,0,0},
+       {"CGEN","Translate a user word to a C function",TranslateWord,0,DF_DIRECTIVE},
 
        // No more functions indicated with NULL pointer
        {"","",NULL,0,0}
@@ -449,14 +513,18 @@ const DictionaryEntry GeneratorDictionary[]=
 
        {"TO","Set a value#(value)$",inmediateTO,IT_NORMAL,DF_DIRECTIVE},
        {"+TO","Add to a value#(value)$",inmediateTO,IT_ADD,DF_DIRECTIVE},
+       {"IS","Set a deferred word#(xt)$",inmediateIS,0,DF_DIRECTIVE},
+       {"[']","Codes an execution token#$(xt)",GeneratorFunction,GF_F_BRACKET_TICK,DF_DIRECTIVE},
 
        // Local variables
        {"{","Start of local variables definition",CodeLocalsDelimiters,LOCAL_D_START,0},
        {"--","Start of local variables comment",CodeLocalsDelimiters,LOCAL_D_COMMENT,0},
        {"}","Start of local variables definition",CodeLocalsDelimiters,LOCAL_D_END,0},
+       {"LARRAY","Local array of n cells#(n)$",CodeLocalArray,0,DF_DIRECTIVE},
 
        // Compilation of decompiled words
        // JMP JZ JNZ _DO P_DO N_DO _LOOP _@LOOP _OF
+       // SETR GETR ADDR and the fused compare jumps
        {"JMP","Decompiled JMP#(raddr)$",CompileDecompiled,0,0},
        {"JZ","Decompiled JZ#(raddr)$",CompileDecompiled,1,0},
        {"JNZ","Decompiled JNZ#(raddr)$",CompileDecompiled,2,0},
@@ -469,6 +537,16 @@ const DictionaryEntry GeneratorDictionary[]=
        {"SETR","Decompiled SETR#(raddr)$",CompileDecompiled,9,0},
        {"GETR","Decompiled GETR#(raddr)$",CompileDecompiled,10,0},
        {"ADDR","Decompiled ADDR#(raddr)$",CompileDecompiled,11,0},
+       {"JLT","Decompiled JLT#(raddr)$",CompileDecompiled,12,0},
+       {"JGT","Decompiled JGT#(raddr)$",CompileDecompiled,13,0},
+       {"JLE","Decompiled JLE#(raddr)$",CompileDecompiled,14,0},
+       {"JGE","Decompiled JGE#(raddr)$",CompileDecompiled,15,0},
+       {"JEQ","Decompiled JEQ#(raddr)$",CompileDecompiled,16,0},
+       {"JNE","Decompiled JNE#(raddr)$",CompileDecompiled,17,0},
+       {"J0GE","Decompiled J0GE#(raddr)$",CompileDecompiled,18,0},
+       {"J0LE","Decompiled J0LE#(raddr)$",CompileDecompiled,19,0},
+       {"LALLOT","Decompiled LALLOT#(n)$",CompileDecompiled,20,0},
+       {"LADDR","Decompiled LADDR#(raddr)$",CompileDecompiled,21,0},
 
        // No more functions indicated with NULL pointer
        {"","",NULL,0,0}
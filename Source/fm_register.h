@@ -76,6 +76,25 @@ typedef struct
 #define SETR_CODE        34
 #define GETR_CODE        35
 #define ADDR_CODE        36
+#define DEFER_CODE       37
+#define TODEFER_CODE     38
+#define JLT_CODE         39
+#define JGT_CODE         40
+#define JLE_CODE         41
+#define JGE_CODE         42
+#define JEQ_CODE         43
+#define JNE_CODE         44
+#define J0GE_CODE        45
+#define J0LE_CODE        46
+#define GET0_CODE        47
+#define SET0_CODE        51
+#define LALLOT_CODE      55
+#define LADDR_CODE       56
+#define DV_FIRST_CODE    57
+#define DV_LAST_CODE     65
+#define CHKD_CODE        66
+#define UNC_FIRST_CODE   67
+#define UNC_LAST_CODE    77
 
 // Public variables
 extern const DictionaryEntry BaseDictionary[];
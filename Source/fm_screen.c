@@ -131,6 +131,14 @@ void consoleWarnMessage(ContextType *context,char *cad)
 // It also aborts execution
 void runtimeErrorMessage(ContextType *context,char *cad)
  {
+ // Inside a CATCH the error is given to it
+ if (context->CatchDepth)
+     {
+	 if (!(context->ThrowCode)) context->ThrowCode=THROW_ABORT;
+	 AbortExecution(context);
+	 return;
+     }
+
  // Abort execution
  AbortExecution(context);
 
@@ -756,11 +756,11 @@ int32_t PstackUnaryFunction(ContextType *context,int32_t value)
 	  break;
 
    case UN_F_USER2MEM:   // User addr to CPU addr
-	  (*udata)=(uint32_t)(UDict.Mem+(*data));
+	  (*udata)=(uint32_t)(uintptr_t)(UDict.Mem+(*data));
 	  break;
 
    case UN_F_MEM2USER:   // CPU addr to User addr
-	  (*data)=(int32_t)((*udata)-(uint32_t)UDict.Mem);
+	  (*data)=(int32_t)((*udata)-(uint32_t)(uintptr_t)UDict.Mem);
 	  break;
 
    case UN_F_HCELL_PLUS:
@@ -776,12 +776,122 @@ int32_t PstackUnaryFunction(ContextType *context,int32_t value)
  return 0;
  }
 
+/******************** VERIFIED STACK EFFECT FUNCTIONS *************************/
+/*
+ When the stack effect of a word can be verified at compile time
+ the word starts with a CHKD code that checks once the stack depth
+ it needs. Then the common stack words inside the word are coded
+ as unchecked versions that don't verify the number of elements.
+ */
+
+// Stack positions after and before a given one
+#define STK_NEXT(p) (((p)==(STACK_SIZE-1))?0:((p)+1))
+#define STK_PREV(p) (((p)==0)?(STACK_SIZE-1):((p)-1))
+
+// Checks the stack depth needed by a verified word
+// The depth follows the code as one byte
+int32_t PstackCheckDepth(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ int32_t depth;
+
+ // Get the depth
+ depth=UDict.Mem[(context->Counter)++];
+
+ // Check it
+ if ((context->stack.Size)<depth)
+      runtimeErrorMessage(context,"Not enough elements");
+
+ return 0;
+ }
+
+// Unchecked stack words
+// They are only used after a CHKD check so there are always
+// enough elements in the stack
+int32_t PstackUncheckedFunction(ContextType *context,int32_t value)
+ {
+ StackType *stk;      // Stack for this process
+ int32_t *stkData;    // Stack data for this process
+ int32_t first,second,data;
+
+ // Obtain our stack pointers
+ stk=&(context->stack);
+ stkData=(stk->data);
+
+ // Calculate stack elements
+ first=(stk->Pointer);
+ second=STK_PREV(first);
+
+ switch (value)
+     {
+     case UNC_F_DROP:
+    	 if (--(stk->Size))
+    		 (stk->Pointer)=second;
+    	    else
+    	     (stk->Pointer)=-1;
+    	 return 0;
+
+     case UNC_F_DUP:
+     case UNC_F_OVER:
+    	 data=stkData[(value==UNC_F_DUP)?first:second];
+    	 first=STK_NEXT(first);
+    	 stkData[first]=data;
+    	 (stk->Pointer)=first;
+    	 if ((stk->Size)<STACK_SIZE) (stk->Size)++;
+    	 return 0;
+
+     case UNC_F_SWAP:
+    	 data=stkData[first];
+    	 stkData[first]=stkData[second];
+    	 stkData[second]=data;
+    	 return 0;
+
+     case UNC_F_NIP:
+    	 stkData[second]=stkData[first];
+    	 break;
+
+     case UNC_F_ADD:
+    	 stkData[second]+=stkData[first];
+    	 break;
+
+     case UNC_F_SUB:
+    	 stkData[second]-=stkData[first];
+    	 break;
+
+     case UNC_F_MULT:
+    	 stkData[second]*=stkData[first];
+    	 break;
+
+     case UNC_F_AND:
+    	 stkData[second]&=stkData[first];
+    	 break;
+
+     case UNC_F_OR:
+    	 stkData[second]|=stkData[first];
+    	 break;
+
+     case UNC_F_XOR:
+    	 stkData[second]^=stkData[first];
+    	 break;
+     }
+
+ // Binary words drop the top
+ // There are two elements so the stack is never emptied
+ (stk->Pointer)=second;
+ (stk->Size)--;
+
+ return 0;
+ }
+
 /******************** RETURN STACK PUBLIC FUNCTIONS *************************/
 
 // Initializes the return stack for the context
 void RstackInit(ContextType *context)
  {
  context->rstack.Pointer=-1;  // Next element will be 0
+ context->rstack.LoopIndex=0;
+ context->rstack.LoopLimit=0;
  }
 
 // Introduces a number on one the return stack
@@ -961,7 +1071,7 @@ int32_t RstackList(ContextType *context,int32_t value)
 // Generic return stack function
 int32_t RstackFunction(ContextType *context,int32_t value)
  {
- int32_t data,size;
+ int32_t data;
 
  switch (value)
      {
@@ -976,33 +1086,10 @@ int32_t RstackFunction(ContextType *context,int32_t value)
     	 break;
 
      case RSTACK_RTOP:     // Get R top without popping
-     case RSTACK_GET_I:
     	 if (RstackGetTop(context,&data)) return 0;
     	 PstackPush(context,data);
     	 break;
 
-     case RSTACK_GET_J: // Gets position -2
-    	 size=RstackGetSize(context);
-    	 if (size<3)
-    	     {
-    		 runtimeErrorMessage(context,"Not enough elements on return stack");
-    		 return 0;
-    	     }
-    	 data=(context->rstack.data)[(context->rstack.Pointer)-2];
-    	 PstackPush(context,data);
-    	 break;
-
-     case RSTACK_GET_K: // Gets position -4
-    	 size=RstackGetSize(context);
-    	 if (size<5)
-    	     {
-    		 runtimeErrorMessage(context,"Not enough elements on return stack");
-    		 return 0;
-    	     }
-    	 data=(context->rstack.data)[(context->rstack.Pointer)-4];
-    	 PstackPush(context,data);
-    	 break;
-
      case RSTACK_CLEAR:     // Clear return stack
     	 RstackInit(context);
     	 break;
@@ -105,6 +105,22 @@ int32_t PstackUnaryFunction(ContextType *context,int32_t value);
 
 int32_t PstackList(ContextType *context,int32_t value);
 
+// Words with a verified stack effect
+int32_t PstackCheckDepth(ContextType *context,int32_t value);
+
+int32_t PstackUncheckedFunction(ContextType *context,int32_t value);
+#define UNC_F_DROP        1
+#define UNC_F_DUP         2
+#define UNC_F_OVER        3
+#define UNC_F_SWAP        4
+#define UNC_F_NIP         5
+#define UNC_F_ADD         6
+#define UNC_F_SUB         7
+#define UNC_F_MULT        8
+#define UNC_F_AND         9
+#define UNC_F_OR         10
+#define UNC_F_XOR        11
+
 // Return stack function prototypes ----------------------
 void RstackInit(ContextType *context);
 int32_t RstackPush(ContextType *context,int32_t value);
@@ -120,11 +136,8 @@ int32_t RstackFunction(ContextType *context,int32_t value);
 #define RSTACK_F_TO_R  0
 #define RSTACK_R_TO_F  1
 #define RSTACK_RTOP    2
-#define RSTACK_GET_I   3
-#define RSTACK_GET_J   4
 #define RSTACK_CLEAR   5
 #define RSTACK_DROP    6
-#define RSTACK_GET_K   7
 
 #endif //_FM_STACK_MODULE
 
@@ -336,8 +336,8 @@ int32_t threadKill(ContextType *context,int32_t value)
 	   return 0;
        }
 
- // Set abort bit
- (FThreads[nth-1].context.Flags)|=CFLAG_ABORT;
+ // Abort it so that no CATCH can stop it
+ killExecution(&(FThreads[nth-1].context));
 
  // Show info if enabled
  if (SHOW_INFO(context))
@@ -357,8 +357,8 @@ int32_t threadKillAll(ContextType *context,int32_t value)
  for(i=0;i<MAX_THREADS;i++)
 	 if (FThreads[i].status==FTS_RUNNNING)
 	    {
-		// Set abort bit
-		(FThreads[i].context.Flags)|=CFLAG_ABORT;
+		// Abort it so that no CATCH can stop it
+		killExecution(&(FThreads[i].context));
 
 		// Show info if enabled
 		if (SHOW_INFO(context))
@@ -0,0 +1,728 @@
+/*******************************************************************
+ *
+ *  f m _ t r a n s l a t e . c
+ *
+ * Translation functions for the Forth project
+ *
+ * This module translates user words to C functions
+ *
+ ******************************************************************/
+
+/*
+ The CGEN word writes on the console a C function that does the
+ same as a user word. The function can be added to a port module
+ and registered in fp_portDictionary.h as a new built-in word.
+
+ Only words whose stack effect can be verified are translated
+ so the stack depth at each code is known:
+
+     * Each stack position is a C local variable s0, s1...
+       The inputs are popped to them at entry and the outputs
+       are pushed at exit
+     * Jumps are translated to gotos
+     * Simple Base Dictionary words are translated to C code
+     * Other Base Dictionary words are called through aotCall
+       with their inputs and outputs on the parameter stack
+
+ Translated words use Base Dictionary codes and user dictionary
+ positions for values and variables so they should be translated
+ again after a change on any of them.
+ */
+
+// Includes
+#include "fp_config.h"     // Main configuration file
+#include "fp_port.h"       // Include file for the port
+#include "fm_main.h"       // Main header file
+#include "fm_stack.h"      // Stack header file
+#include "fm_register.h"   // Register header file
+#include "fm_debug.h"      // Debug header file
+#include "fm_screen.h"     // Screen header file
+#include "fm_program.h"    // Program header file
+#include "fm_branch.h"     // Branch header file
+#include "fm_effect.h"     // Stack effect header file
+#include "fm_translate.h"  // This module header file
+
+// Kinds of inline translations
+#define TK_DROP      0   // Nothing to do
+#define TK_DUP       1   // Copy top
+#define TK_OVER      2   // Copy second
+#define TK_SWAP      3   // Swap top two
+#define TK_ROT       4   // Rotate top three
+#define TK_NIP       5   // Move top to second
+#define TK_TUCK      6   // Copy top below second
+#define TK_CONST     7   // Push op
+#define TK_BINARY    8   // a op= b
+#define TK_SHIFT     9   // Unsigned a op b
+#define TK_COMPARE  10   // Flag of a op b
+#define TK_ZCOMPARE 11   // Flag of a op 0
+#define TK_UNARY    12   // a = op a
+#define TK_SELF     13   // a op
+#define TK_MAXMIN   14   // if (a op b) a = b
+#define TK_ABS      15   // Absolute value
+#define TK_INDEX    16   // Innermost loop index
+
+// Base Dictionary words translated inline
+static const struct
+      {
+	  char *name;     // Word name
+	  uint8_t kind;   // Kind of translation
+	  char *op;       // C operator
+      }
+ InlineTable[]=
+      {
+	  {"DROP",TK_DROP,""},
+	  {"DUP",TK_DUP,""},
+	  {"OVER",TK_OVER,""},
+	  {"SWAP",TK_SWAP,""},
+	  {"ROT",TK_ROT,""},
+	  {"NIP",TK_NIP,""},
+	  {"TUCK",TK_TUCK,""},
+	  {"TRUE",TK_CONST,"FTRUE"},
+	  {"FALSE",TK_CONST,"FFALSE"},
+	  {"+",TK_BINARY,"+"},
+	  {"-",TK_BINARY,"-"},
+	  {"*",TK_BINARY,"*"},
+	  {"AND",TK_BINARY,"&"},
+	  {"OR",TK_BINARY,"|"},
+	  {"XOR",TK_BINARY,"^"},
+	  {"LSHIFT",TK_SHIFT,"<<"},
+	  {"RSHIFT",TK_SHIFT,">>"},
+	  {"<",TK_COMPARE,"<"},
+	  {">",TK_COMPARE,">"},
+	  {"<=",TK_COMPARE,"<="},
+	  {">=",TK_COMPARE,">="},
+	  {"=",TK_COMPARE,"=="},
+	  {"<>",TK_COMPARE,"!="},
+	  {"0<",TK_ZCOMPARE,"<"},
+	  {"0>",TK_ZCOMPARE,">"},
+	  {"0=",TK_ZCOMPARE,"=="},
+	  {"NOT",TK_ZCOMPARE,"=="},
+	  {"0<>",TK_ZCOMPARE,"!="},
+	  {"NEGATE",TK_UNARY,"-"},
+	  {"INVERT",TK_UNARY,"~"},
+	  {"1+",TK_SELF,"+=1"},
+	  {"1-",TK_SELF,"-=1"},
+	  {"2+",TK_SELF,"+=2"},
+	  {"2-",TK_SELF,"-=2"},
+	  {"2*",TK_SELF,"*=2"},
+	  {"2/",TK_SELF,"/=2"},
+	  {"CELL+",TK_SELF,"+=4"},
+	  {"CELLS",TK_SELF,"*=4"},
+	  {"HCELL+",TK_SELF,"+=2"},
+	  {"HCELLS",TK_SELF,"*=2"},
+	  {"MAX",TK_MAXMIN,"<"},
+	  {"MIN",TK_MAXMIN,">"},
+	  {"ABS",TK_ABS,""},
+	  {"I",TK_INDEX,""},
+	  {NULL,0,NULL}
+      };
+
+#define INLINE_WORDS  (sizeof(InlineTable)/sizeof(InlineTable[0]))
+
+// Base Dictionary codes of the inline words
+// They are searched only once
+static int16_t InlineCodes[INLINE_WORDS];
+static int16_t ExitCode;
+static int32_t translateReady=0;
+
+// Operators of the fused compare and branch codes
+static const char *const JumpOps[]={"<",">","<=",">=","==","!="};
+
+// Types of 32, 16 and 8 bit values and variables
+static const char *const DataTypes[]={"int32_t","int16_t","int8_t"};
+
+// Codes that are jump targets
+static uint8_t LabelMark[EFFECT_MAX_CODES];
+
+/***************** STATIC FUNCTIONS *****************/
+
+// Search the codes of the inline table
+static void translateInit(void)
+ {
+ int32_t i;
+
+ for(i=0;InlineTable[i].name!=NULL;i++)
+	 InlineCodes[i]=searchRegister((DictionaryEntry*)BaseDictionary,InlineTable[i].name);
+
+ ExitCode=searchRegister((DictionaryEntry*)BaseDictionary,"EXIT");
+
+ translateReady=1;
+ }
+
+// Gives the inline table entry of a Base Dictionary entry
+// Returns -1 if it is not inline
+static int32_t inlineWord(int32_t entry)
+ {
+ int32_t i;
+
+ for(i=0;InlineTable[i].name!=NULL;i++)
+	 if (InlineCodes[i]==entry) return i;
+
+ return -1;
+ }
+
+// Gives the target code number of a jump code
+// Returns -1 if it is not a jump
+static int32_t jumpTarget(uint16_t pos)
+ {
+ int32_t code;
+
+ code=UDict.Mem[pos];
+
+ switch (code)
+     {
+     case JMP_CODE:
+     case JZ_CODE:
+     case JNZ_CODE:
+     case PLUS_DO_CODE:
+     case MINUS_DO_CODE:
+     case LOOP_CODE:
+     case ALOOP_CODE:
+     case OF_CODE:
+    	 break;
+
+     default:
+    	 if ((code<JLT_CODE)||(code>J0LE_CODE)) return -1;
+     }
+
+ return effectNumber(*(uint16_t*)(UDict.Mem+pos+1));
+ }
+
+// Prints a C identifier from a word name
+static void printIdentifier(char *name)
+ {
+ while (*name)
+     {
+	 if (((*name)>='A')&&((*name)<='Z')) consolePutChar(*name);
+	 else if (((*name)>='0')&&((*name)<='9')) consolePutChar(*name);
+	 else { consolePrintf("_%02X",(uint8_t)(*name)); }
+	 name++;
+     }
+ }
+
+// Prints a print string code as a C string
+static void printString(uint16_t pos)
+ {
+ uint8_t data;
+
+ consolePutChar('"');
+ while ((data=UDict.Mem[pos++])!=0)
+     {
+	 if ((data=='"')||(data=='\\'))
+	      {
+		  consolePutChar('\\');
+		  consolePutChar(data);
+	      }
+	 else if ((data<32)||(data>126))
+	      { consolePrintf("\\%03o",data); }
+	 else
+		  consolePutChar(data);
+     }
+ consolePutChar('"');
+ }
+
+// Prints a goto to a code
+// Backward jumps check the user abort
+static void printGoto(int32_t from,int32_t to)
+ {
+ if (to<=from)
+     { consolePrintf("{ if (aotPoll(context,&frame)) return 0; goto L%d; }%s",to,BREAK); }
+    else
+     { consolePrintf("goto L%d;%s",to,BREAK); }
+ }
+
+// Prints the return from the word
+// Elements from s0 to s(k-1) are pushed on the stack
+static void printReturn(int32_t k)
+ {
+ int32_t i;
+
+ for(i=0;i<k;i++)
+	 consolePrintf(" PstackPush(context,s%d);%s",i,BREAK);
+
+ consolePrintf(" aotExit(context,&frame);%s",BREAK);
+ consolePrintf(" return 0;%s",BREAK);
+ }
+
+// Prints an inline word
+// k is the number of stack positions in use
+static void printInline(int32_t n,int32_t k)
+ {
+ int32_t a,b;
+ char *op;
+
+ // Top and second positions
+ a=k-2;
+ b=k-1;
+ op=InlineTable[n].op;
+
+ switch (InlineTable[n].kind)
+     {
+     case TK_DROP:
+    	 break;
+     case TK_DUP:
+    	 consolePrintf(" s%d=s%d;%s",k,b,BREAK);
+    	 break;
+     case TK_OVER:
+    	 consolePrintf(" s%d=s%d;%s",k,a,BREAK);
+    	 break;
+     case TK_SWAP:
+    	 consolePrintf(" t=s%d; s%d=s%d; s%d=t;%s",b,b,a,a,BREAK);
+    	 break;
+     case TK_ROT:
+    	 consolePrintf(" t=s%d; s%d=s%d; s%d=s%d; s%d=t;%s",k-3,k-3,a,a,b,b,BREAK);
+    	 break;
+     case TK_NIP:
+    	 consolePrintf(" s%d=s%d;%s",a,b,BREAK);
+    	 break;
+     case TK_TUCK:
+    	 consolePrintf(" s%d=s%d; s%d=s%d; s%d=s%d;%s",k,b,b,a,a,k,BREAK);
+    	 break;
+     case TK_CONST:
+    	 consolePrintf(" s%d=%s;%s",k,op,BREAK);
+    	 break;
+     case TK_BINARY:
+    	 consolePrintf(" s%d%s=s%d;%s",a,op,b,BREAK);
+    	 break;
+     case TK_SHIFT:
+    	 consolePrintf(" s%d=(int32_t)(((uint32_t)s%d)%s((uint32_t)s%d));%s",a,a,op,b,BREAK);
+    	 break;
+     case TK_COMPARE:
+    	 consolePrintf(" s%d=(s%d%ss%d)?FTRUE:FFALSE;%s",a,a,op,b,BREAK);
+    	 break;
+     case TK_ZCOMPARE:
+    	 consolePrintf(" s%d=(s%d%s0)?FTRUE:FFALSE;%s",b,b,op,BREAK);
+    	 break;
+     case TK_UNARY:
+    	 consolePrintf(" s%d=%ss%d;%s",b,op,b,BREAK);
+    	 break;
+     case TK_SELF:
+    	 consolePrintf(" s%d%s;%s",b,op,BREAK);
+    	 break;
+     case TK_MAXMIN:
+    	 consolePrintf(" if (s%d%ss%d) s%d=s%d;%s",a,op,b,a,b,BREAK);
+    	 break;
+     case TK_ABS:
+    	 consolePrintf(" if (s%d<0) s%d=-s%d;%s",b,b,b,BREAK);
+    	 break;
+     case TK_INDEX:
+    	 consolePrintf(" s%d=context->rstack.LoopIndex;%s",k,BREAK);
+    	 break;
+     }
+ }
+
+// Prints a call to a Base Dictionary word
+// k is the number of stack positions in use
+static void printCall(int32_t entry,int32_t k)
+ {
+ int32_t in,out,i;
+
+ effectInOut(entry,&in,&out);
+
+ // End of word
+ if (in<0)
+     {
+	 consolePrintf(" aotCall(context,&frame,%d);  // %s%s",entry,BaseDictionary[entry].name,BREAK);
+	 consolePrintf(" return 0;%s",BREAK);
+	 return;
+     }
+
+ for(i=k-in;i<k;i++)
+	 consolePrintf(" PstackPush(context,s%d);%s",i,BREAK);
+
+ consolePrintf(" if (aotCall(context,&frame,%d)) return 0;  // %s%s",entry,BaseDictionary[entry].name,BREAK);
+
+ for(i=k-in+out-1;i>=(k-in);i--)
+	 consolePrintf(" PstackPop(context,&s%d);%s",i,BREAK);
+ }
+
+// Prints one code
+// k is the number of stack positions in use
+static void printCode(int32_t ncode,int32_t k)
+ {
+ uint16_t pos,addr;
+ int32_t code,entry,a,b,n,to;
+
+ pos=effectPosition(ncode);
+ code=UDict.Mem[pos];
+ addr=*(uint16_t*)(UDict.Mem+pos+1);
+ to=jumpTarget(pos);
+
+ // Top and second positions
+ a=k-2;
+ b=k-1;
+
+ switch (code)
+     {
+     case ENDWORD_CODE:
+    	 printReturn(k);
+    	 return;
+
+     case CHKD_CODE:
+    	 return;
+
+     case NUM1B_CODE:
+    	 consolePrintf(" s%d=%d;%s",k,*(int8_t*)(UDict.Mem+pos+1),BREAK);
+    	 return;
+     case NUM2B_CODE:
+    	 consolePrintf(" s%d=%d;%s",k,*(int16_t*)(UDict.Mem+pos+1),BREAK);
+    	 return;
+     case NUM4B_CODE:
+    	 consolePrintf(" s%d=%d;%s",k,*(int32_t*)(UDict.Mem+pos+1),BREAK);
+    	 return;
+
+     case PS_CODE:
+    	 consolePrintf(" if (SHOW_RESPONSE(context)) { consolePrintf(\"%%s\",");
+    	 printString(pos+1);
+    	 consolePrintf("); }%s",BREAK);
+    	 return;
+
+     case TOVAL_CODE:
+     case TOHVAL_CODE:
+     case TOCVAL_CODE:
+    	 n=code-TOVAL_CODE;
+    	 consolePrintf(" *(%s*)(UDict.Mem+%d)=(%s)s%d;%s",DataTypes[n],addr,DataTypes[n],b,BREAK);
+    	 return;
+     case ADDTOVAL_CODE:
+     case ADDTOHVAL_CODE:
+     case ADDTOCVAL_CODE:
+    	 n=code-ADDTOVAL_CODE;
+    	 consolePrintf(" *(%s*)(UDict.Mem+%d)+=(%s)s%d;%s",DataTypes[n],addr,DataTypes[n],b,BREAK);
+    	 return;
+
+     case GETR_CODE:
+    	 consolePrintf(" s%d=AOT_LOCAL(%d);%s",k,UDict.Mem[pos+1],BREAK);
+    	 return;
+     case SETR_CODE:
+    	 consolePrintf(" AOT_LOCAL(%d)=s%d;%s",UDict.Mem[pos+1],b,BREAK);
+    	 return;
+     case ADDR_CODE:
+    	 consolePrintf(" AOT_LOCAL(%d)+=s%d;%s",UDict.Mem[pos+1],b,BREAK);
+    	 return;
+     case LADDR_CODE:
+    	 consolePrintf(" s%d=(int32_t)&AOT_LOCAL(%d);%s",k,UDict.Mem[pos+1],BREAK);
+    	 return;
+     case LALLOT_CODE:
+    	 consolePrintf(" if (aotLallot(context,&frame,%d)) return 0;%s",UDict.Mem[pos+1],BREAK);
+    	 return;
+
+     case JMP_CODE:
+    	 consolePrintf(" ");
+    	 printGoto(ncode,to);
+    	 return;
+     case JZ_CODE:
+    	 consolePrintf(" if (!s%d) ",b);
+    	 printGoto(ncode,to);
+    	 return;
+     case JNZ_CODE:
+    	 consolePrintf(" if (s%d) ",b);
+    	 printGoto(ncode,to);
+    	 return;
+     case J0GE_CODE:
+    	 consolePrintf(" if (s%d>=0) ",b);
+    	 printGoto(ncode,to);
+    	 return;
+     case J0LE_CODE:
+    	 consolePrintf(" if (s%d<=0) ",b);
+    	 printGoto(ncode,to);
+    	 return;
+
+     case DO_CODE:
+    	 consolePrintf(" if (aotDo(context,&frame,s%d,s%d)) return 0;%s",a,b,BREAK);
+    	 return;
+     case PLUS_DO_CODE:
+    	 consolePrintf(" if (aotDo(context,&frame,s%d,s%d)) return 0;%s",a,b,BREAK);
+    	 consolePrintf(" if (s%d>=s%d) ",b,a);
+    	 printGoto(ncode,to);
+    	 return;
+     case MINUS_DO_CODE:
+    	 consolePrintf(" if (aotDo(context,&frame,s%d,s%d)) return 0;%s",a,b,BREAK);
+    	 consolePrintf(" if (s%d<=s%d) ",b,a);
+    	 printGoto(ncode,to);
+    	 return;
+     case LOOP_CODE:
+    	 consolePrintf(" if ((++(context->rstack.LoopIndex))<(context->rstack.LoopLimit)) ");
+    	 printGoto(ncode,to);
+    	 return;
+     case ALOOP_CODE:
+    	 consolePrintf(" if (aotAddLoop(context,s%d)) ",b);
+    	 printGoto(ncode,to);
+    	 return;
+     case OF_CODE:
+    	 consolePrintf(" if (s%d!=s%d) ",a,b);
+    	 printGoto(ncode,to);
+    	 return;
+     }
+
+ // Fused compare and branch
+ if ((code>=JLT_CODE)&&(code<=JNE_CODE))
+      {
+	  consolePrintf(" if (s%d%ss%d) ",a,JumpOps[code-JLT_CODE],b);
+	  printGoto(ncode,to);
+	  return;
+      }
+
+ // Fast locals
+ if ((code>=GET0_CODE)&&(code<(GET0_CODE+FAST_LOCALS)))
+      {
+	  consolePrintf(" s%d=AOT_LOCAL(%d);%s",k,code-GET0_CODE,BREAK);
+	  return;
+      }
+ if ((code>=SET0_CODE)&&(code<(SET0_CODE+FAST_LOCALS)))
+      {
+	  consolePrintf(" AOT_LOCAL(%d)=s%d;%s",code-SET0_CODE,b,BREAK);
+	  return;
+      }
+
+ // Direct variable access goes in groups of @ ! +!
+ if ((code>=DV_FIRST_CODE)&&(code<=DV_LAST_CODE))
+      {
+	  n=(code-DV_FIRST_CODE)/3;
+	  switch ((code-DV_FIRST_CODE)%3)
+	     {
+	     case 0:
+	    	 consolePrintf(" s%d=*(%s*)(UDict.Mem+%d);%s",k,DataTypes[n],addr,BREAK);
+	    	 break;
+	     case 1:
+	    	 consolePrintf(" *(%s*)(UDict.Mem+%d)=(%s)s%d;%s",DataTypes[n],addr,DataTypes[n],b,BREAK);
+	    	 break;
+	     case 2:
+	    	 consolePrintf(" *(%s*)(UDict.Mem+%d)+=(%s)s%d;%s",DataTypes[n],addr,DataTypes[n],b,BREAK);
+	    	 break;
+	     }
+	  return;
+      }
+
+ // Words of the Base Dictionary
+ entry=effectEntry(pos);
+
+ // Exit
+ if (entry==ExitCode)
+      {
+	  printReturn(k);
+	  return;
+      }
+
+ n=inlineWord(entry);
+ if (n>=0)
+	 printInline(n,k);
+    else
+     printCall(entry,k);
+ }
+
+/***************** RUNTIME FUNCTIONS FOR TRANSLATED WORDS *****************/
+
+// Starts a translated word
+// Checks that the stack has the depth the word needs
+// and sets a new return stack frame like a user word call
+// Returns 0 if ok
+int32_t aotEnter(ContextType *context,AotFrame *frame,int32_t depth)
+ {
+ if ((context->stack.Size)<depth)
+     {
+	 runtimeErrorMessage(context,"Not enough elements");
+	 return 1;
+     }
+
+ // Save caller frame and loop
+ frame->Frame=context->rstack.Frame;
+ frame->LoopIndex=context->rstack.LoopIndex;
+ frame->LoopLimit=context->rstack.LoopLimit;
+
+ // Set new frame
+ context->rstack.Frame=context->rstack.Pointer;
+
+ return 0;
+ }
+
+// Ends a translated word
+// Releases locals and loops and restores the caller state
+void aotExit(ContextType *context,AotFrame *frame)
+ {
+ context->rstack.Pointer=context->rstack.Frame;
+ context->rstack.Frame=frame->Frame;
+ context->rstack.LoopIndex=frame->LoopIndex;
+ context->rstack.LoopLimit=frame->LoopLimit;
+ }
+
+// Calls a Base Dictionary word from a translated word
+// Returns 1 if the word has aborted so the translated word
+// should return at once
+int32_t aotCall(ContextType *context,AotFrame *frame,int32_t entry)
+ {
+ (BaseDictionary[entry].function)(context,BaseDictionary[entry].argument);
+
+ if ((context->Flags)&CFLAG_ABORT)
+     {
+	 aotExit(context,frame);
+	 return 1;
+     }
+
+ return 0;
+ }
+
+// Checks the user abort on backward jumps
+// Returns 1 if the translated word should return at once
+int32_t aotPoll(ContextType *context,AotFrame *frame)
+ {
+ if (!PORT_ABORT) return 0;
+
+ portAbort(context);
+ aotExit(context,frame);
+
+ return 1;
+ }
+
+// Starts a DO loop from a translated word
+// Returns 1 if the translated word should return at once
+int32_t aotDo(ContextType *context,AotFrame *frame,int32_t limit,int32_t index)
+ {
+ if (loopStart(context,limit,index))
+     {
+	 aotExit(context,frame);
+	 return 1;
+     }
+
+ return 0;
+ }
+
+// Adds to the loop index for @LOOP
+// Returns 1 if the loop continues
+int32_t aotAddLoop(ContextType *context,int32_t inc)
+ {
+ int32_t index;
+
+ index=(context->rstack.LoopIndex)+=inc;
+
+ if (inc>=0)
+	 return (index<context->rstack.LoopLimit);
+
+ return (index>context->rstack.LoopLimit);
+ }
+
+// Allocates a local array from a translated word
+// Returns 1 if the translated word should return at once
+int32_t aotLallot(ContextType *context,AotFrame *frame,int32_t n)
+ {
+ if (((context->rstack.Pointer)+n)>=RSTK_SIZE)
+       {
+	   runtimeErrorMessage(context,"Rstack overflow in local array");
+	   aotExit(context,frame);
+	   return 1;
+       }
+
+ while (n--)
+	 context->rstack.data[++(context->rstack.Pointer)]=0;
+
+ return 0;
+ }
+
+/***************** COMMAND FUNCTIONS *****************/
+
+// Translates a user word to C       [INTERACTIVE]
+int32_t TranslateWord(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ char *name;
+ char uname[MAX_TOKEN_SIZE+1];
+ int32_t pos,need,ncodes,i,k,slots,temp,to,n;
+
+ // Check if info is enabled
+ if (NO_RESPONSE(context)) return 0;
+
+ // Search the inline codes
+ if (!translateReady) translateInit();
+
+ // Get word to translate
+ name=tokenGet();
+ if (checkTokenLength(name)) return 0;
+ strCaseCpy(name,uname);
+
+ // Locate this user word
+ pos=locateUserWord(uname);
+ if (pos==NO_WORD)
+     {
+	 consoleErrorMessage(context,"Word not found");
+	 return 0;
+     }
+
+ // Analyse it
+ need=effectAnalyse(pos);
+ if (need<0)
+     {
+	 consoleErrorMessage(context,"Word stack effect cannot be verified");
+	 return 0;
+     }
+
+ // Check the codes and locate the jump targets
+ ncodes=effectCodes();
+ slots=need;
+ temp=0;
+ for(i=0;i<ncodes;i++)
+	 LabelMark[i]=0;
+ for(i=0;i<ncodes;i++)
+     {
+	 if (effectDepth(i)==EFFECT_NO_DEPTH) continue;
+
+	 if (UDict.Mem[effectPosition(i)]==TODEFER_CODE)
+	      {
+		  consoleErrorMessage(context,"Cannot translate IS");
+		  return 0;
+	      }
+
+	 k=effectDepth(i)+need;
+	 if (k>slots) slots=k;
+
+	 to=jumpTarget(effectPosition(i));
+	 if (to>=0) LabelMark[to]=1;
+
+	 n=inlineWord(effectEntry(effectPosition(i)));
+	 if ((n>=0)&&((InlineTable[n].kind==TK_SWAP)||(InlineTable[n].kind==TK_ROT)))
+		 temp=1;
+     }
+
+ // Function header
+ consolePrintf("// Translated from user word %s%s",uname,BREAK);
+ consolePrintf("// Register with: {\"%s\",\"Translated word\",aot",uname);
+ printIdentifier(uname);
+ consolePrintf(",0,0},%s",BREAK);
+ consolePrintf("#if FVERSION_INT!=%d%s",FVERSION_INT,BREAK);
+ consolePrintf("#error \"Base codes have changed, translate %s again\"%s",uname,BREAK);
+ consolePrintf("#endif%s",BREAK);
+ consolePrintf("int32_t aot");
+ printIdentifier(uname);
+ consolePrintf("(ContextType *context,int32_t value)%s",BREAK);
+ consolePrintf(" {%s UNUSED(value);%s%s",BREAK,BREAK,BREAK);
+
+ // Variables
+ consolePrintf(" AotFrame frame;%s",BREAK);
+ if (slots||temp)
+     {
+	 consolePrintf(" int32_t ");
+	 for(i=0;i<slots;i++)
+		 consolePrintf("%ss%d",(i)?",":"",i);
+	 if (temp) { consolePrintf("%st",(slots)?",":""); }
+	 consolePrintf(";%s",BREAK);
+     }
+ CBK;
+
+ // Entry
+ consolePrintf(" if (aotEnter(context,&frame,%d)) return 0;%s",need,BREAK);
+ for(i=need-1;i>=0;i--)
+	 consolePrintf(" PstackPop(context,&s%d);%s",i,BREAK);
+ CBK;
+
+ // Codes
+ for(i=0;i<ncodes;i++)
+     {
+	 if (effectDepth(i)==EFFECT_NO_DEPTH) continue;
+	 if (LabelMark[i]) { consolePrintf("L%d:%s",i,BREAK); }
+	 printCode(i,effectDepth(i)+need);
+     }
+
+ consolePrintf(" }%s",BREAK);
+ CBK;
+
+ return 0;
+ }
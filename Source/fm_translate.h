@@ -0,0 +1,38 @@
+/*******************************************************************
+ *
+ *  f m _ t r a n s l a t e . h
+ *
+ * Translation header file for the Forth project
+ *
+ * This module translates user words to C functions
+ *
+ ******************************************************************/
+
+#ifndef _FM_TRANSLATE_MODULE
+#define _FM_TRANSLATE_MODULE
+
+// Caller state saved by a translated word
+typedef struct
+    {
+	int16_t Frame;        // Return stack frame
+	int32_t LoopIndex;    // Innermost DO loop
+	int32_t LoopLimit;
+    }
+    AotFrame;
+
+// Local variable access from a translated word
+#define AOT_LOCAL(n)  (context->rstack.data[(context->rstack.Frame)+(n)+1])
+
+// Runtime functions used by translated words
+int32_t aotEnter(ContextType *context,AotFrame *frame,int32_t depth);
+void aotExit(ContextType *context,AotFrame *frame);
+int32_t aotCall(ContextType *context,AotFrame *frame,int32_t entry);
+int32_t aotPoll(ContextType *context,AotFrame *frame);
+int32_t aotDo(ContextType *context,AotFrame *frame,int32_t limit,int32_t index);
+int32_t aotAddLoop(ContextType *context,int32_t inc);
+int32_t aotLallot(ContextType *context,AotFrame *frame,int32_t n);
+
+// Command functions
+int32_t TranslateWord(ContextType *context,int32_t value);
+
+#endif // _FM_TRANSLATE_MODULE
@@ -17,10 +17,10 @@
 // MForth version information -----------------------------------------
 
 // Version in text mode
-#define FVERSION       "1.0"
+#define FVERSION       "1.07"
 
 // Version in integer mode (100*version)
-#define FVERSION_INT    100
+#define FVERSION_INT    107
 
 // Release definition
 // Activate for final release version that disables test words
@@ -49,6 +49,15 @@
 // Max number of local values in a word
 #define MAX_LOCALS        10
 
+// Max number of return stack cells for locals and local arrays in a word
+#define MAX_LOCAL_CELLS   32
+
+// Number of locals with their own get and set codes
+#define FAST_LOCALS       4
+
+// Max number of codes in a word for the stack effect analysis
+#define EFFECT_MAX_CODES  96
+
 // Size and limits definitions specific for the STM32F3Gizmo port ------
 
 // Max number of user semaphores 0..
@@ -18,6 +18,20 @@
 #include "buses.h"
 #include "thservices.h"
 #include "pwmModule.h"
+#include "acqModule.h"
+#include "bufferModule.h"
+#include "waveModule.h"
+#include "patternModule.h"
+#include "imuModule.h"
+#include "fusionModule.h"
+#include "edgeModule.h"
+#include "captureModule.h"
+#include "encoderModule.h"
+#include "uartModule.h"
+#include "usbDataModule.h"
+#include "telemetryModule.h"
+#include "rpcModule.h"
+#include "aotModule.h"
 
 #endif // _FP_MODULES
 
@@ -21,6 +21,11 @@
 #include "fm_debug.h"
 #include "timeModule.h"
 #include "analog.h"
+#include "acqModule.h"
+#include "waveModule.h"
+#include "patternModule.h"
+#include "edgeModule.h"
+#include "uartModule.h"
 
 // Mutex to protect the thread list
 Mutex treadListMutex;
@@ -372,6 +377,54 @@ void portShowLimits(void)
  consolePrintf("  Timer max freq: %d%s",TIM_MAX_FREQ,BREAK);
  consolePrintf("  Timer max interval: %d%s",TIM_MAX_INTERVAL,BREAK);
  CBK;
+ consolePrintf("  Capture max freq: %d%s",ACQ_MAX_FREQ,BREAK);
+ consolePrintf("  Capture max samples: %d%s",ACQ_MAX_SAMPLES,BREAK);
+ consolePrintf("  Waveform max freq: %d%s",WAVE_MAX_FREQ,BREAK);
+ consolePrintf("  Pattern max freq: %d%s",PAT_MAX_FREQ,BREAK);
+ consolePrintf("  UART max baud: %d%s",UART_MAX_BAUD,BREAK);
+ CBK;
+ }
+
+// DMA buffer check -----------------------------------------------------------
+
+// Check that a CPU memory zone can be used by the DMA
+// Only the user dictionary is allowed as the PAD
+// is in CCM RAM that is not connected to the DMA
+// Returns 1 if OK
+//         0 if not
+int32_t portDmaBuffer(uint32_t addr,int32_t size)
+ {
+ uint32_t start,end;
+
+ // Size must be positive
+ if (size<1) return 0;
+
+ // User dictionary limits
+ start=(uint32_t)UDict.Mem;
+ end=start+UD_MEMSIZE;
+
+ // Check zone
+ if ((addr<start)||(addr>=end)) return 0;
+ if ((uint32_t)size>(end-addr)) return 0;
+
+ return 1;
+ }
+
+// Check that a CPU memory zone is user memory
+// That includes the user dictionary and the PAD
+// Returns 1 if OK
+//         0 if not
+int32_t portUserBuffer(uint32_t addr,int32_t size)
+ {
+ // Size must be positive
+ if (size<1) return 0;
+
+ // Check the PAD
+ if ((addr>=PAD_ADDRESS)&&(addr<(PAD_ADDRESS+PAD_SIZE)))
+	 return ((uint32_t)size<=((PAD_ADDRESS+PAD_SIZE)-addr));
+
+ // Check the user dictionary
+ return portDmaBuffer(addr,size);
  }
 
 // Thread functions -----------------------------------------------------------
@@ -409,6 +462,9 @@ int32_t isAnyCallback(void)
  // Check if there is any callback in the timers
  if (isAnyTimerCallback()) any=1;
 
+ // Check if there is any callback in the edge events
+ if (isAnyEdgeCallback()) any=1;
+
  return any;
  }
 
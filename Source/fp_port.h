@@ -82,6 +82,12 @@ extern Mutex treadListMutex;
 #define LOCK_TLIST	 chMtxLock(&treadListMutex);
 #define UNLOCK_TLIST chMtxUnlock();
 
+// Context abort flags protection
+// Timer callbacks run words so it must also be
+// valid in an interrupt that is not locked
+#define LOCK_FLAGS    port_lock();
+#define UNLOCK_FLAGS  port_unlock();
+
 // PAD Definitions ---------------------------------------
 
 // Address of the PAD (CCM Ram)
@@ -136,5 +142,9 @@ void portShowLimits(void);
 // Check of callbacks
 int32_t isAnyCallback(void);
 
+// Check of DMA and user buffers
+int32_t portDmaBuffer(uint32_t addr,int32_t size);
+int32_t portUserBuffer(uint32_t addr,int32_t size);
+
 #endif //_FP_PORT_INCLUDE
 
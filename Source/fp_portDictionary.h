@@ -56,6 +56,18 @@
 {"DigitalBinWrite","Digital binary write#(ub)$",gpioBfunction,GPIO_F_BWRITE,0},
 {"DigitalBinReadOutput","Digital binary read output#$(ub)",gpioBreadOut,0,0},
 
+// GPIO edge events in edgeModule.c/h
+// umode 0 none, 1 rising, 2 falling, 3 both. Times are in us
+{"EdgeSet","Set edge interrupts on digital u#(u)(umode)$",edgeFunction,EDGE_F_SET,0},
+{"EdgeWait","Wait edge on u, ums<0 no timeout#(u)(ums)$(time)(f)",edgeFunction,EDGE_F_WAIT,0},
+{"EdgeAvail","Queued edge events on u#(u)$(n)",edgeFunction,EDGE_F_AVAIL,0},
+{"EdgeCount","Edges counted on u#(u)$(n)",edgeFunction,EDGE_F_COUNT,0},
+{"EdgePeriod","Time between last two edges on u#(u)$(us)",edgeFunction,EDGE_F_PERIOD,0},
+{"EdgeLost","Edge events lost on u#(u)$(n)",edgeFunction,EDGE_F_LOST,0},
+{"EdgeClear","Clear edge queue and counters of u#(u)$",edgeFunction,EDGE_F_CLEAR,0},
+{"EdgeWord","Set word callback (time --) of u#(u)$",edgeFunction,EDGE_F_WORD,DF_DIRECTIVE},
+{"EdgeRESET","Disables all edge lines and callbacks",edgeFunction,EDGE_F_RESET,0},
+
 // Analog module in analog.c/h
 // Analog commands
 {"AnalogSingle","Analog channel u to single mode#(u)$",analogFunction,ANALOG_F_SINGLE,0},
@@ -75,6 +87,53 @@
 {"AnalogVdd","Analog give measured Vdd [updates calibration]#(Vdd[mV])$(Vref[mV])",analogFunction,ANALOG_F_USE_VDDMEAS,0},
 {"AnalogVref","Analog give known Vref [updates calibration]#(Vref[mV])$(Vdd[mV])",analogFunction,ANALOG_F_USE_VREF,0},
 
+// Analog capture in acqModule.c/h
+{"AcqFreq","Set capture sample frequency#(uf)$(uf real)",acqFunction,ACQ_F_FREQ,0},
+{"AcqStart","Capture n samples of channel uch#(addr)(n)(uch)$",acqFunction,ACQ_F_SINGLE,0},
+{"AcqStartDouble","Continuous capture in two halves#(addr)(n)(uch)$",acqFunction,ACQ_F_DOUBLE,0},
+{"AcqWait","Wait for next captured block#$(addr)",acqFunction,ACQ_F_WAIT,0},
+{"AcqReady?","Check if a captured block is ready#$(f)",acqFunction,ACQ_F_READY,0},
+{"AcqOverruns","Number of lost capture blocks#$(n)",acqFunction,ACQ_F_OVERRUNS,0},
+{"AcqStop","Stop the capture",acqFunction,ACQ_F_STOP,0},
+
+// Buffer math in bufferModule.c/h
+// usize is 1,2,4 for unsigned elements and -1,-2 for signed ones
+{"BufSum","Sum of buffer elements#(addr)(n)(usize)$(sum)",bufferFunction,BUF_F_SUM,0},
+{"BufMean","Mean of buffer elements#(addr)(n)(usize)$(mean)",bufferFunction,BUF_F_MEAN,0},
+{"BufMax","Maximum of buffer and its index#(addr)(n)(usize)$(max)(index)",bufferFunction,BUF_F_MAX,0},
+{"BufMin","Minimum of buffer and its index#(addr)(n)(usize)$(min)(index)",bufferFunction,BUF_F_MIN,0},
+{"BufRMS","Root mean square of buffer#(addr)(n)(usize)$(rms)",bufferFunction,BUF_F_RMS,0},
+{"BufOffset","Add offset to buffer elements#(addr)(n)(usize)(off)$",bufferFunction,BUF_F_OFFSET,0},
+{"BufScale","Scale buffer elements by mul/div#(addr)(n)(usize)(mul)(div)$",bufferFunction,BUF_F_SCALE,0},
+{"BufSingle2mV","Single readings half buffer to mV#(addr)(n)$",bufferConvertFunction,BUF_F_SINGLE2MV,0},
+{"BufDiff2mV","Differential readings half buffer to mV#(addr)(n)$",bufferConvertFunction,BUF_F_DIFF2MV,0},
+
+// DAC waveform generator in waveModule.c/h
+// Tables are n half words with 12 bit DAC values
+{"WaveFreq","Set waveform sample frequency#(uf)$(uf real)",waveFunction,WAVE_F_FREQ,0},
+{"WaveTable","Set table, swaps at period end if running#(addr)(n)$",waveFunction,WAVE_F_TABLE,0},
+{"WaveStart","Start table waveform output",waveFunction,WAVE_F_START,0},
+{"WaveStop","Stop waveform generation",waveFunction,WAVE_F_STOP,0},
+{"WaveWait","Wait until a pending table swap is done",waveFunction,WAVE_F_WAIT,0},
+{"WaveNoise","DAC noise generation#(ubase)(uamp 0..11)$",waveFunction,WAVE_F_NOISE,0},
+{"WaveTriangle","DAC triangle generation#(ubase)(uamp 0..11)$",waveFunction,WAVE_F_TRIANGLE,0},
+
+// GPIO pattern output in patternModule.c/h
+// uformat 0: half words to the port ODR  1: words to BSRR (set low, clear high)
+{"PatFreq","Set pattern word frequency#(uf)$(uf real)",patternFunction,PAT_F_FREQ,0},
+{"PatOnce","Output a pattern buffer once#(addr)(n)(uformat)$",patternFunction,PAT_F_ONCE,0},
+{"PatLoop","Output a pattern buffer in a loop#(addr)(n)(uformat)$",patternFunction,PAT_F_LOOP,0},
+{"PatStop","Stop pattern output",patternFunction,PAT_F_STOP,0},
+{"PatWait","Wait end of a one shot pattern",patternFunction,PAT_F_WAIT,0},
+{"PatMap","Map buffer from GPIO lines to port bits#(addr)(n)(uformat)$",patternFunction,PAT_F_MAP,0},
+
+// GPIO logic capture in patternModule.c/h
+// Sample rate is set with PatFreq. Masks use GPIO line bits
+{"LogicTrigger","Set capture trigger (umask 0 = none)#(umask)(uvalue)$",patternFunction,PAT_F_TRIGGER,0},
+{"LogicCapture","Wait trigger and capture n port samples#(addr)(n)$",patternFunction,PAT_F_CAPTURE,0},
+{"LogicWait","Wait end of capture",patternFunction,PAT_F_WAIT,0},
+{"LogicDump","Binary RLE dump of a capture#(addr)(n)$",patternFunction,PAT_F_DUMP,0},
+
 
 // Gyroscope commands in buses.c/h
 {"GyroRead","Gyroscope read 3D (8.75 mdps/count)#$(nz)(ny)(nx)",busesFunction,BUSES_GYR_READ,0},
@@ -96,11 +155,34 @@
 {"MagReadReg","Magnetometer read register#(ureg)$(uval)",internalRegistersFunction,INTREG_F_MRR,0},
 {"MagWriteReg","Magnetometer write register#(ureg)(uval)$",internalRegistersFunction,INTREG_F_MWR,0},
 
+// Inertial sensors background sampling in imuModule.c/h
+// usensor is 0 Gyroscope, 1 Accelerometer, 2 Magnetometer
+// While running, sensor read words give the latest sample
+{"ImuStart","Start sensors background sampling",imuFunction,IMU_F_START,0},
+{"ImuStop","Stop sensors background sampling",imuFunction,IMU_F_STOP,0},
+{"ImuLast","Latest raw sample of sensor#(usensor)$(z)(y)(x)",imuFunction,IMU_F_LAST,0},
+{"ImuCopy","Copy last samples as (time x y z) cells#(addr)(n)(usensor)$(ncopied)",imuFunction,IMU_F_COPY,0},
+{"ImuCount","Number of samples taken from sensor#(usensor)$(u)",imuFunction,IMU_F_COUNT,0},
+{"ImuOverruns","Number of sensor FIFO overruns#(usensor)$(u)",imuFunction,IMU_F_OVERRUNS,0},
+
+// Attitude fusion engine in fusionModule.c/h
+// Angles are in 1/100 degree and quaternion in 1/10000
+{"FusionRate","Set fusion update rate#(uhz)$(uhz real)",fusionFunction,FUSION_F_RATE,0},
+{"FusionGain","Set fusion 2Kp gain in thousandths#(ugain)$",fusionFunction,FUSION_F_GAIN,0},
+{"FusionStart","Start fusion engine (starts ImuStart)",fusionFunction,FUSION_F_START,0},
+{"FusionStop","Stop fusion engine",fusionFunction,FUSION_F_STOP,0},
+{"FusionAngles","Attitude angles#$(roll)(pitch)(yaw)",fusionFunction,FUSION_F_ANGLES,0},
+{"FusionQuat","Attitude quaternion#$(q0)(q1)(q2)(q3)",fusionFunction,FUSION_F_QUAT,0},
+{"FusionReset","Reset attitude to identity",fusionFunction,FUSION_F_RESET,0},
+
 // SPI commands in buses.c/h
 {"SPIStart","SPI Start on slave u (0..3)#(u)$",busesFunction,SPI_F_START,0},
 {"SPIEnd","SPI End transmission",busesFunction,SPI_F_END,0},
 {"SPIByte","SPI exchange one Byte#(tx)$(rx)",busesFunction,SPI_F_EX8,0},
 {"SPITransfer","SPI exchange n Bytes#(tx1)..(txn)(n)$(rx1)..(rxn)",spiNexangeFunction,0,0},
+{"SPIBuffer","SPI exchange n Bytes between buffers#(txaddr)(rxaddr)(n)$",spiBufferFunction,SPI_F_BUF_SYNC,0},
+{"SPIBufferAsync","Start SPIBuffer and signal sem at end#(txaddr)(rxaddr)(n)(usem)$",spiBufferFunction,SPI_F_BUF_ASYNC,0},
+{"SPIBusy?","Check if an async SPI transfer is running#$(f)",spiBufferFunction,SPI_F_BUF_BUSY,0},
 {"SPIFreq","SPI frequency#(kHz)$(kHz)",spiSetSpeed,0,0},
 {"SPIMode","SPI mode 0..3#(mode)$",busesFunction,SPI_F_MODE,0},
 
@@ -110,6 +192,13 @@
 {"I2CWriteReg","I2C Register Write#(addr)(nreg)(value)$",busesFunction,BUSES_I_WR,0},
 {"ISCAN","I2C Address scan#$(add1)..(addn)(n)",busesFunction,BUSES_I_SCAN,0},
 {"I2CTransfer","I2C Transfer#(addr)(d1w)..(duw)(uw)(ur) $ (dur)...(d1r)",i2cTransfer,0,0},
+{"I2CWriteBuf","I2C write n Bytes from buffer#(addr)(buf)(n)$",i2cBufferFunction,I2C_F_BUF_WRITE,0},
+{"I2CReadBuf","I2C read n Bytes to buffer#(addr)(buf)(n)$",i2cBufferFunction,I2C_F_BUF_READ,0},
+{"I2CReadRegs","I2C burst read of n registers#(addr)(reg)(buf)(n)$",i2cBufferFunction,I2C_F_BUF_REGS,0},
+{"I2CTransferBuf","I2C write and read buffers#(addr)(txbuf)(nt)(rxbuf)(nr)$",i2cBufferFunction,I2C_F_BUF_TRANS,0},
+{"I2CTransferAsync","Start I2CTransferBuf and signal sem at end#(addr)(txbuf)(nt)(rxbuf)(nr)(usem)$",i2cBufferFunction,I2C_F_BUF_ASYNC,0},
+{"I2CBusy?","Check if an async I2C transfer is running#$(f)",i2cBufferFunction,I2C_F_BUF_BUSY,0},
+{"I2CResult","Result of last async I2C transfer#$(n)",i2cBufferFunction,I2C_F_BUF_RESULT,0},
 
 // Thread services
 {"SIGNAL","Signal semaphore u#(u)$",semaphoreFunction,SEM_F_SIGNAL,0},
@@ -131,6 +220,7 @@
 {"TimerPause","Pause timer ut#(ut)$",timeFunction,TIME_F_PAUSE,0},
 {"TimerOneShot","Start timer ut in one shot mode interval ui#(ui)(ut)$",timeFunction,TIME_F_ONE,0},
 {"TimerRESET","Pauses all timers and removes callback words$",timeFunction,TIME_F_RESET,0},
+{"Micros","Microseconds since start (wraps at 2^32)#$(us)",timeFunction,TIME_F_MICROS,0},
 
 // PWM Module
 {"PWMSet","Set PWM Channel uch to ui interval#(ui)(uch)$",pwmFunction,PWM_F_CHON,0},
@@ -138,5 +228,72 @@
 {"PWMFreq","Set PWM clock frequency#(uf)$",pwmFunction,PWM_F_FREQ,0},
 {"PWMPeriod","Set PWM period in clock cycles#(up)$",pwmFunction,PWM_F_PERIOD,0},
 {"PWMSTOP","Stop all PWM operations",pwmFunction,PWM_F_STOP,0},
+// PWM duty streaming: frames of nch CCR values from channel uch1
+{"PWMStreamOnce","Play duty table once#(addr)(nframes)(uch1)(nch)$",pwmFunction,PWM_F_SONCE,0},
+{"PWMStreamLoop","Play duty table in a loop#(addr)(nframes)(uch1)(nch)$",pwmFunction,PWM_F_SLOOP,0},
+{"PWMStreamTable","Swap looped table at pass end#(addr)(nframes)$",pwmFunction,PWM_F_STABLE,0},
+{"PWMStreamStop","Stop duty streaming",pwmFunction,PWM_F_SSTOP,0},
+{"PWMStreamWait","Wait end of once stream or table swap",pwmFunction,PWM_F_SWAIT,0},
+
+// Input capture on digital line 1 in captureModule.c/h
+// Values are zero until the first complete capture
+{"CapStart","Start input capture on digital 1",captureFunction,CAP_F_START,0},
+{"CapStop","Stop input capture",captureFunction,CAP_F_STOP,0},
+{"CapTicks","Last period in 72MHz counts#$(n)",captureFunction,CAP_F_TICKS,0},
+{"CapPeriod","Last period in us#$(us)",captureFunction,CAP_F_PERIOD,0},
+{"CapFreq","Last frequency in mHz#$(mHz)",captureFunction,CAP_F_FREQ,0},
+{"CapDuty","Last duty cycle in 1/10000#$(n)",captureFunction,CAP_F_DUTY,0},
+{"CapHigh","Last high time in us#$(us)",captureFunction,CAP_F_HIGH,0},
+{"CapCount","Number of captures#$(n)",captureFunction,CAP_F_COUNT,0},
+
+// Quadrature encoder on digital 6 (A), 7 (B) and 8 (index) in encoderModule.c/h
+// umode 1 A edges, 2 B edges, 3 A and B edges
+// Index umode 0 none, 1 next index zeroes, 2 all indexes zero
+{"EncStart","Start encoder, umode 1:A edges 2:B edges 3:A and B#(umode)$",encoderFunction,ENC_F_START,0},
+{"EncStop","Stop encoder interface",encoderFunction,ENC_F_STOP,0},
+{"EncPos","Encoder 32 bit position#$(n)",encoderFunction,ENC_F_POS,0},
+{"EncSet","Set encoder position#(n)$",encoderFunction,ENC_F_SET,0},
+{"EncVel","Encoder velocity in counts/s#$(n)",encoderFunction,ENC_F_VEL,0},
+{"EncWindow","Set velocity window in ms#(ums)$",encoderFunction,ENC_F_WINDOW,0},
+{"EncIndex","Set index mode#(umode)$",encoderFunction,ENC_F_INDEX,0},
+{"EncIndexCount","Number of index pulses#$(n)",encoderFunction,ENC_F_ICOUNT,0},
+
+// UART data port on PC4 (TX) and PC5 (RX) in uartModule.c/h
+// udelim is the line delimiter or -1 for none. ums -1 waits forever
+// Uses the I2C2 DMA channels so I2C2 is not available while open
+{"UartOpen","Open UART data port#(ubaud udelim)$",uartFunction,UART_F_OPEN,0},
+{"UartClose","Close UART data port",uartFunction,UART_F_CLOSE,0},
+{"UartWrite","Send a buffer#(addr n)$",uartFunction,UART_F_WRITE,0},
+{"UartRead","Read available bytes#(addr n)$(nread)",uartFunction,UART_F_READ,0},
+{"UartAvail","Bytes available to read#$(n)",uartFunction,UART_F_AVAIL,0},
+{"UartLine","Wait for a delimited line#(addr n ums)$(nread)",uartFunction,UART_F_LINE,0},
+{"UartFrame","Wait for an idle ended frame#(addr n ums)$(nread)",uartFunction,UART_F_FRAME,0},
+{"UartLost","Number of RX bytes lost#$(n)",uartFunction,UART_F_LOST,0},
+{"UartFlush","Wait end of transmission",uartFunction,UART_F_FLUSH,0},
+
+// USB binary data channel (second CDC interface) in usbDataModule.c/h
+// ums -1 waits forever
+{"UsbWrite","Send a buffer on USB data channel#(addr n)$",usbDataFunction,USBDATA_F_WRITE,0},
+{"UsbRead","Read from USB data channel#(addr n ums)$(nread)",usbDataFunction,USBDATA_F_READ,0},
+{"UsbAvail","Bytes available on USB data channel#$(n)",usbDataFunction,USBDATA_F_AVAIL,0},
+{"UsbWait","Wait end of USB data transmission",usbDataFunction,USBDATA_F_WAIT,0},
+{"UsbReady?","USB data channel configured#$(flag)",usbDataFunction,USBDATA_F_READY,0},
+
+// Binary telemetry in telemetryModule.c/h
+// udest 0 console, 1 USB data channel, 2 UART port
+// Frames are COBS encoded with CRC-16 (see telemetryModule.h)
+{"TelStart","Start telemetry#(udest)$",telemetryFunction,TEL_F_START,0},
+{"TelStop","Stop telemetry",telemetryFunction,TEL_F_STOP,0},
+{"TelSend","Send telemetry record#(x1..xn n uid)$",telemetryFunction,TEL_F_SEND,0},
+{"TelWait","Wait until records are sent",telemetryFunction,TEL_F_WAIT,0},
+{"TelLost","Records lost with ring full#$(n)",telemetryFunction,TEL_F_LOST,0},
+{"TelCount","Records sent#$(n)",telemetryFunction,TEL_F_COUNT,0},
+
+// Binary RPC mode on the console in rpcModule.c/h
+// Frame format in rpcModule.h. Exit with an exit frame or the button
+{"RpcMode","Enter binary RPC mode",rpcFunction,RPC_F_MODE,0},
+{"RpcToken","RPC token of a word#$(token)",rpcFunction,RPC_F_TOKEN,DF_DIRECTIVE},
 
+// Words translated to C with CGEN in aotModule.c/h
+// Add here the register line given by CGEN for each word
 
@@ -0,0 +1,371 @@
+/*
+ fusionModule.c
+ Attitude fusion engine source file
+
+ A thread integrates the gyroscope rates on a quaternion at
+ a fixed rate and corrects the drift towards the measured
+ gravity and magnetic field directions (Mahony filter).
+ Zero values set with GyroZero and the like are applied.
+
+ The FPU is not enabled in this port so all the filter uses
+ Q30 fixed point. Angles are obtained with CORDIC.
+
+ Gyroscope and accelerometer/magnetometer axes are taken
+ as aligned as they are on the STM32F3 Discovery board.
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "buses.h"         // Sensor zero values
+#include "imuModule.h"     // Sensor samples
+#include "bufferModule.h"  // Square root
+#include "fusionModule.h"  // This module header
+
+// Q30 fixed point constants
+#define Q30_ONE   (1<<30)
+#define Q30_HALF  (1<<29)
+
+// CORDIC angles atan(2^-i) in 1/10000 degree
+static const int32_t FusionAtanTable[FUSION_CORDIC_N]={
+		450000,265651,140362,71250,35763,17899,8952,4476,
+		2238,1119,560,280,140,70,35,17};
+
+// Attitude quaternion in Q30
+static int32_t FusionQ[4]={Q30_ONE,0,0,0};
+
+// Engine configuration
+static int32_t FusionRate=FUSION_DEF_RATE;           // Real rate
+static systime_t FusionPeriod=CH_FREQUENCY/FUSION_DEF_RATE;
+static int32_t FusionGain=FUSION_DEF_GAIN;
+
+// Running flag and wake up semaphore
+static volatile int32_t FusionRunning=0;
+static BinarySemaphore FusionSemaphore;
+
+// Thread working area
+static WORKING_AREA(waFusionThread,FUSION_THREAD_WA);
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Q30 product
+static int32_t qmul(int32_t a,int32_t b)
+ {
+ return (int32_t)((((int64_t)a)*b)>>30);
+ }
+
+// Normalizes a vector to Q30 length
+// Returns 0 if it is null
+static int32_t fusionNormalize(int32_t *v,int32_t n)
+ {
+ int64_t sum=0;
+ int32_t i,norm;
+
+ for(i=0;i<n;i++)
+	 sum+=((int64_t)v[i])*v[i];
+
+ norm=bufferSqrt64(sum);
+ if (!norm) return 0;
+
+ for(i=0;i<n;i++)
+	 v[i]=(int32_t)((((int64_t)v[i])<<30)/norm);
+
+ return 1;
+ }
+
+// Gets the latest sample of a sensor without zero values
+static void fusionSensor(int32_t sensor,int32_t *v)
+ {
+ int16_t raw[3];
+ int32_t zero[3],i;
+
+ imuLatest(sensor,raw);
+ busesZero(sensor,zero);
+
+ for(i=0;i<3;i++)
+	 v[i]=((int32_t)raw[i])-zero[i];
+ }
+
+// One filter update
+static void fusionUpdate(void)
+ {
+ int32_t g[3],a[3],m[3],q[4];
+ int32_t q0q0,q0q1,q0q2,q0q3,q1q1,q1q2,q1q3,q2q2,q2q3,q3q3;
+ int32_t hx,hy,bx,bz,vx,vy,vz,wx,wy,wz,ex,ey,ez;
+ int32_t i;
+
+ // Gyroscope in rad/s Q24
+ fusionSensor(IMU_GYR,g);
+ for(i=0;i<3;i++) g[i]*=FUSION_GYR_Q24;
+
+ // Accelerometer and magnetometer
+ fusionSensor(IMU_ACC,a);
+ fusionSensor(IMU_MAG,m);
+ m[2]=(m[2]*FUSION_MAG_XY_GAIN)/FUSION_MAG_Z_GAIN;
+
+ // Products of the current quaternion
+ for(i=0;i<4;i++) q[i]=FusionQ[i];
+ q0q0=qmul(q[0],q[0]); q0q1=qmul(q[0],q[1]);
+ q0q2=qmul(q[0],q[2]); q0q3=qmul(q[0],q[3]);
+ q1q1=qmul(q[1],q[1]); q1q2=qmul(q[1],q[2]);
+ q1q3=qmul(q[1],q[3]); q2q2=qmul(q[2],q[2]);
+ q2q3=qmul(q[2],q[3]); q3q3=qmul(q[3],q[3]);
+
+ // Half error between measured and estimated directions
+ ex=ey=ez=0;
+ if (fusionNormalize(a,3))
+     {
+	 // Half estimated gravity direction
+	 vx=q1q3-q0q2;
+	 vy=q0q1+q2q3;
+	 vz=q0q0-Q30_HALF+q3q3;
+
+	 ex=qmul(a[1],vz)-qmul(a[2],vy);
+	 ey=qmul(a[2],vx)-qmul(a[0],vz);
+	 ez=qmul(a[0],vy)-qmul(a[1],vx);
+
+	 if (fusionNormalize(m,3))
+	     {
+		 // Earth magnetic field with no east component
+		 hx=2*(qmul(m[0],Q30_HALF-q2q2-q3q3)+qmul(m[1],q1q2-q0q3)+qmul(m[2],q1q3+q0q2));
+		 hy=2*(qmul(m[0],q1q2+q0q3)+qmul(m[1],Q30_HALF-q1q1-q3q3)+qmul(m[2],q2q3-q0q1));
+		 bx=bufferSqrt64(((int64_t)hx)*hx+((int64_t)hy)*hy);
+		 bz=2*(qmul(m[0],q1q3-q0q2)+qmul(m[1],q2q3+q0q1)+qmul(m[2],Q30_HALF-q1q1-q2q2));
+
+		 // Half estimated magnetic field direction
+		 wx=qmul(bx,Q30_HALF-q2q2-q3q3)+qmul(bz,q1q3-q0q2);
+		 wy=qmul(bx,q1q2-q0q3)+qmul(bz,q0q1+q2q3);
+		 wz=qmul(bx,q0q2+q1q3)+qmul(bz,Q30_HALF-q1q1-q2q2);
+
+		 ex+=qmul(m[1],wz)-qmul(m[2],wy);
+		 ey+=qmul(m[2],wx)-qmul(m[0],wz);
+		 ez+=qmul(m[0],wy)-qmul(m[1],wx);
+	     }
+     }
+
+ // Proportional feedback from Q30 to Q24 rad/s
+ g[0]+=(int32_t)((((int64_t)ex)*FusionGain)/(1000<<6));
+ g[1]+=(int32_t)((((int64_t)ey)*FusionGain)/(1000<<6));
+ g[2]+=(int32_t)((((int64_t)ez)*FusionGain)/(1000<<6));
+
+ // Half rotation in this period in Q30
+ for(i=0;i<3;i++)
+	 g[i]=(int32_t)((((int64_t)g[i])<<5)/FusionRate);
+
+ // Integrate q = q + q x (0,g)
+ a[0]=q[0]; a[1]=q[1]; a[2]=q[2];
+ q[0]+=-qmul(a[1],g[0])-qmul(a[2],g[1])-qmul(q[3],g[2]);
+ q[1]+= qmul(a[0],g[0])+qmul(a[2],g[2])-qmul(q[3],g[1]);
+ q[2]+= qmul(a[0],g[1])-qmul(a[1],g[2])+qmul(q[3],g[0]);
+ q[3]+= qmul(a[0],g[2])+qmul(a[1],g[1])-qmul(a[2],g[0]);
+
+ if (!fusionNormalize(q,4)) return;
+
+ // Publish the new attitude
+ chSysLock();
+ for(i=0;i<4;i++) FusionQ[i]=q[i];
+ chSysUnlock();
+ }
+
+// Fusion thread
+static msg_t fusionThread(void *arg)
+ {
+ systime_t next,delta;
+
+ UNUSED(arg);
+
+ next=chTimeNow();
+ while (TRUE)
+     {
+	 // Wait to be started
+	 if (!FusionRunning)
+	     {
+		 chBSemWait(&FusionSemaphore);
+		 next=chTimeNow();
+		 continue;
+	     }
+
+	 // Wait for the next period
+	 // Restart the timing if we are late
+	 next+=FusionPeriod;
+	 delta=next-chTimeNow();
+	 if ((delta==0)||(delta>FusionPeriod))
+		 next=chTimeNow();
+	    else
+	     chThdSleep(delta);
+
+	 fusionUpdate();
+     }
+
+ return 0;
+ }
+
+// Angle of a vector using CORDIC
+// Returns 1/10000 degrees in the -180..180 range
+// Coordinates must be below 2^29
+static int32_t fusionAtan2(int32_t y,int32_t x)
+ {
+ int32_t angle=0,xn,i;
+
+ // Move to the right half plane
+ if (x<0)
+     {
+	 angle=(y>=0)?1800000:-1800000;
+	 x=-x;
+	 y=-y;
+     }
+
+ // Rotate to the X axis
+ for(i=0;i<FUSION_CORDIC_N;i++)
+     {
+	 xn=x;
+	 if (y>0)
+	     {
+		 x+=y>>i;
+		 y-=xn>>i;
+		 angle+=FusionAtanTable[i];
+	     }
+	    else
+	     {
+		 x-=y>>i;
+		 y+=xn>>i;
+		 angle-=FusionAtanTable[i];
+	     }
+     }
+
+ // Keep in the -180..180 range
+ if (angle>1800000) angle-=3600000;
+ if (angle<=-1800000) angle+=3600000;
+
+ return angle;
+ }
+
+// Roll, pitch and yaw in 1/100 degrees
+static void fusionAngles(int32_t *angles)
+ {
+ int32_t q[4],s,c,i;
+
+ chSysLock();
+ for(i=0;i<4;i++) q[i]=FusionQ[i];
+ chSysUnlock();
+
+ // All terms are halved to keep them below 2^29
+
+ // Roll
+ s=qmul(q[0],q[1])+qmul(q[2],q[3]);
+ c=Q30_HALF-qmul(q[1],q[1])-qmul(q[2],q[2]);
+ angles[0]=fusionAtan2(s,c)/FUSION_ANGLE_DIV;
+
+ // Pitch
+ s=qmul(q[0],q[2])-qmul(q[1],q[3]);
+ if (s>Q30_HALF) s=Q30_HALF;
+ if (s<-Q30_HALF) s=-Q30_HALF;
+ c=bufferSqrt64(((int64_t)Q30_HALF)*Q30_HALF-((int64_t)s)*s);
+ angles[1]=fusionAtan2(s,c)/FUSION_ANGLE_DIV;
+
+ // Yaw
+ s=qmul(q[0],q[3])+qmul(q[1],q[2]);
+ c=Q30_HALF-qmul(q[2],q[2])-qmul(q[3],q[3]);
+ angles[2]=fusionAtan2(s,c)/FUSION_ANGLE_DIV;
+ }
+
+// Sets the attitude to the identity quaternion
+static void fusionReset(void)
+ {
+ chSysLock();
+ FusionQ[0]=Q30_ONE;
+ FusionQ[1]=FusionQ[2]=FusionQ[3]=0;
+ chSysUnlock();
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void fusionModuleInit(void)
+ {
+ chBSemInit(&FusionSemaphore,TRUE);
+
+ // The thread waits until the engine is started
+ chThdCreateStatic(waFusionThread,sizeof(waFusionThread),FUSION_THREAD_PRIO,fusionThread,NULL);
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic fusion function
+int32_t fusionFunction(ContextType *context,int32_t value)
+ {
+ int32_t data,i,angles[4];
+
+ switch (value)
+     {
+     case FUSION_F_RATE: // Set update rate ( uhz -- uhz )
+    	 if (PstackPop(context,&data)) return 0;
+    	 if ((data<FUSION_MIN_RATE)||(data>FUSION_MAX_RATE))
+    	       {
+    		   consoleErrorMessage(context,"Invalid rate");
+    		   return 0;
+    	       }
+    	 // Integer number of ticks
+    	 chSysLock();
+    	 FusionPeriod=CH_FREQUENCY/data;
+    	 FusionRate=CH_FREQUENCY/FusionPeriod;
+    	 chSysUnlock();
+    	 PstackPush(context,FusionRate);
+    	 break;
+
+     case FUSION_F_GAIN: // Set 2Kp gain ( ugain -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 if ((data<0)||(data>FUSION_MAX_GAIN))
+    	       {
+    		   consoleErrorMessage(context,"Invalid gain");
+    		   return 0;
+    	       }
+    	 FusionGain=data;
+    	 break;
+
+     case FUSION_F_START: // Start the engine
+    	 // The engine needs the sensors sampling service
+    	 if (!imuStart(context)) return 0;
+    	 if (!FusionRunning)
+    	      {
+    		  FusionRunning=1;
+    		  chBSemSignal(&FusionSemaphore);
+    	      }
+    	 break;
+
+     case FUSION_F_STOP: // Stop the engine
+    	 FusionRunning=0;
+    	 break;
+
+     case FUSION_F_ANGLES: // Roll, pitch, yaw ( -- roll pitch yaw )
+    	 fusionAngles(angles);
+    	 for(i=0;i<3;i++)
+    		 PstackPush(context,angles[i]);
+    	 break;
+
+     case FUSION_F_QUAT: // Quaternion ( -- q0 q1 q2 q3 )
+    	 chSysLock();
+    	 for(i=0;i<4;i++) angles[i]=FusionQ[i];
+    	 chSysUnlock();
+    	 for(i=0;i<4;i++)
+    		 PstackPush(context,(int32_t)((((int64_t)angles[i])*FUSION_QUAT_SCALE)>>30));
+    	 break;
+
+     case FUSION_F_RESET: // Reset attitude
+    	 fusionReset();
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in fusionFunction");
+     }
+
+ return 0;
+ }
+
@@ -0,0 +1,51 @@
+/*
+ fusionModule.h
+ Attitude fusion engine header file
+
+ Fixed point Mahony filter over the inertial sensors
+ sampled by the IMU service
+ */
+
+#ifndef _FUSION_MODULE
+#define _FUSION_MODULE
+
+// Thread definitions
+#define FUSION_THREAD_WA     512             // Thread working area
+#define FUSION_THREAD_PRIO   (NORMALPRIO+19) // Just below the IMU service
+
+// Rate limits (the thread period is an integer number of ticks)
+#define FUSION_MIN_RATE      10
+#define FUSION_MAX_RATE      CH_FREQUENCY
+#define FUSION_DEF_RATE      200
+
+// Filter gain 2Kp in thousandths
+#define FUSION_MAX_GAIN      20000
+#define FUSION_DEF_GAIN      1000
+
+// Sensor scales
+#define FUSION_GYR_Q24       2562    // rad/s in Q24 for 8.75 mdps/count
+#define FUSION_MAG_XY_GAIN   670     // Magnetometer X,Y count/gauss
+#define FUSION_MAG_Z_GAIN    600     // Magnetometer Z count/gauss
+
+// Output scales
+#define FUSION_QUAT_SCALE    10000   // Quaternion output is 1/10000
+#define FUSION_ANGLE_DIV     100     // CORDIC gives 1/10000 degree
+
+// CORDIC iterations
+#define FUSION_CORDIC_N      16
+
+// Function prototypes
+void fusionModuleInit(void);
+
+// Command functions
+int32_t fusionFunction(ContextType *context,int32_t value);
+#define FUSION_F_RATE     0   // Set update rate
+#define FUSION_F_GAIN     1   // Set filter gain
+#define FUSION_F_START    2   // Start the engine
+#define FUSION_F_STOP     3   // Stop the engine
+#define FUSION_F_ANGLES   4   // Roll, pitch and yaw
+#define FUSION_F_QUAT     5   // Attitude quaternion
+#define FUSION_F_RESET    6   // Reset attitude
+
+#endif // _FUSION_MODULE
+
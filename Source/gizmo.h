@@ -116,6 +116,14 @@
 #define GYR_CS_PORT     GPIOE
 #define GYR_CS_PIN      3
 
+// Accelerometer / Magnetometer interrupt lines
+
+#define ACCEL_INT_PORT  GPIOE
+#define ACCEL_INT1_PIN  4
+#define ACCEL_INT2_PIN  5
+#define MAG_DRDY_PORT   GPIOE
+#define MAG_DRDY_PIN    2
+
 // SPI3 Information
 
 #define SPI3_PORT       GPIOC
@@ -25,6 +25,11 @@ const uint16_t GpioArray[10]={GPIO0_PIN,GPIO1_PIN,GPIO2_PIN,
 		                      GPIO6_PIN,GPIO7_PIN,GPIO8_PIN,
 		                      GPIO9_PIN};
 
+// EXT driver configuration
+// All channels start disabled and modules program
+// the ones they use with gpioExtSet
+static EXTConfig ExtConfig;
+
 /******************** PUBIC FUNCTIONS ***************************/
 
 // Initializes the GPIO Module
@@ -38,6 +43,24 @@ void gpioModuleInit(void)
 	palSetPadMode(GPIO_PORT,GpioArray[i],PAL_MODE_INPUT);
 	GpioOff(i);
     }
+
+ // Start the EXT driver with all channels disabled
+ extStart(&EXTD1,&ExtConfig);
+ }
+
+// Programs one EXT channel
+// mode includes edges and port (EXT_MODE_GPIOx)
+// EXT_CH_MODE_DISABLED disables the channel
+void gpioExtSet(expchannel_t channel,uint32_t mode,extcallback_t callback)
+ {
+ EXTChannelConfig config;
+
+ config.mode=mode;
+ config.cb=callback;
+
+ chSysLock();
+ extSetChannelModeI(&EXTD1,channel,&config);
+ chSysUnlock();
  }
 
 /******************** COMMAND FUNCTIONS *************************/
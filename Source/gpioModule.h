@@ -63,6 +63,7 @@
 
 // Function prototypes
 void gpioModuleInit(void);
+void gpioExtSet(expchannel_t channel,uint32_t mode,extcallback_t callback);
 
 // Command function prototypes
 int32_t ledFunction(ContextType *context,int32_t value);
@@ -0,0 +1,428 @@
+/*
+ imuModule.c
+ Inertial sensors background sampling source file
+
+ When started, the gyroscope and accelerometer FIFOs work
+ in stream mode and signal a watermark level on their interrupt
+ lines. The magnetometer has no FIFO and uses its DRDY line.
+ Each interrupt wakes the sampling thread that drains all
+ available data in burst transfers so no samples are lost
+ at high data rates and Forth words never wait for the buses.
+
+ FIFO bursts rely on the sensors rolling back the register
+ address from OUT_Z_H to OUT_X_L when the FIFO is enabled.
+
+ Timestamps of the samples in one burst are spread between
+ the previous drain and the current one.
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "buses.h"         // Sensor register access
+#include "gpioModule.h"    // EXT lines
+#include "timeModule.h"    // Microsecond clock
+#include "edgeModule.h"    // Edge lines
+#include "pwmModule.h"     // Duty streaming
+#include "imuModule.h"     // This module header
+
+// Sensor rings
+static ImuSensor ImuSensors[IMU_NSENSORS];
+
+// Service running flag
+static volatile int32_t ImuRunning=0;
+
+// Thread synchronization
+static BinarySemaphore ImuSemaphore;  // Signaled by the interrupt lines
+static Mutex ImuMutex;                // Taken during each drain
+
+// Thread working area
+static WORKING_AREA(waImuThread,IMU_THREAD_WA);
+
+// Burst buffer (in SRAM for the bus DMAs)
+static uint8_t ImuBuffer[6*IMU_FIFO_SIZE];
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// EXT callback for all sensor lines
+static void imuExtCallback(EXTDriver *extp,expchannel_t channel)
+ {
+ UNUSED(extp);
+ UNUSED(channel);
+
+ chSysLockFromIsr();
+ chBSemSignalI(&ImuSemaphore);
+ chSysUnlockFromIsr();
+ }
+
+// Number of samples to read from a FIFO_SRC value
+static int32_t imuFifoLevel(ImuSensor *s,uint8_t src)
+ {
+ // FIFO full with lost samples
+ if (src&IMU_FIFO_OVRN)
+     {
+	 s->Overruns++;
+	 return IMU_FIFO_SIZE;
+     }
+
+ return src&IMU_FIFO_FSS;
+ }
+
+// Stores n samples from a burst buffer
+// Magnetometer data is big endian in X,Z,Y order
+static void imuStore(ImuSensor *s,uint8_t *buf,int32_t n,uint32_t now,int32_t mag)
+ {
+ int32_t i;
+ uint32_t elapsed;
+ ImuSample *p;
+
+ elapsed=now-(s->LastTime);
+ s->LastTime=now;
+
+ chSysLock();
+ for(i=0;i<n;i++)
+     {
+	 p=&(s->Ring[(s->Count)%IMU_RING_SIZE]);
+	 p->Time=now-(elapsed*(n-1-i))/n;
+	 if (mag)
+	     {
+		 p->Data[0]=(int16_t)((buf[0]<<8)|buf[1]);
+		 p->Data[2]=(int16_t)((buf[2]<<8)|buf[3]);
+		 p->Data[1]=(int16_t)((buf[4]<<8)|buf[5]);
+	     }
+	    else
+	     {
+	     p->Data[0]=(int16_t)(buf[0]|(buf[1]<<8));
+	     p->Data[1]=(int16_t)(buf[2]|(buf[3]<<8));
+	     p->Data[2]=(int16_t)(buf[4]|(buf[5]<<8));
+	     }
+	 s->Count++;
+	 buf+=6;
+     }
+ chSysUnlock();
+ }
+
+// Drains the gyroscope FIFO
+static void imuDrainGyr(uint32_t now)
+ {
+ uint8_t src;
+ int32_t n;
+
+ busesGyrRead(GYR_FIFO_SRC,&src,1);
+ n=imuFifoLevel(&ImuSensors[IMU_GYR],src);
+ if (!n) return;
+
+ busesGyrRead(GYR_X_L,ImuBuffer,6*n);
+ imuStore(&ImuSensors[IMU_GYR],ImuBuffer,n,now,0);
+ }
+
+// Drains the accelerometer FIFO
+static void imuDrainAcc(uint32_t now)
+ {
+ uint8_t src;
+ int32_t n;
+
+ if (busesSensorRead(ACCEL_ADDR,ACCEL_FIFO_SRC_A,&src,1)) return;
+ n=imuFifoLevel(&ImuSensors[IMU_ACC],src);
+ if (!n) return;
+
+ // Bit 7 sets autoincrement
+ if (busesSensorRead(ACCEL_ADDR,ACCE_OUT_XL|0x80,ImuBuffer,6*n)) return;
+ imuStore(&ImuSensors[IMU_ACC],ImuBuffer,n,now,0);
+ }
+
+// Reads the magnetometer if it has new data
+static void imuDrainMag(uint32_t now)
+ {
+ // DRDY line is high when there is new data
+ if (!palReadPad(MAG_DRDY_PORT,MAG_DRDY_PIN)) return;
+
+ if (busesSensorRead(MAGNET_ADDR,MAG_OUT_X_H,ImuBuffer,6)) return;
+ imuStore(&ImuSensors[IMU_MAG],ImuBuffer,1,now,1);
+ }
+
+// Sampling thread
+static msg_t imuThread(void *arg)
+ {
+ uint32_t now;
+
+ UNUSED(arg);
+
+ while (TRUE)
+     {
+	 // Wait for an interrupt line or the poll time
+	 if (ImuRunning)
+		 chBSemWaitTimeout(&ImuSemaphore,IMU_POLL_TICKS);
+	    else
+	     chBSemWait(&ImuSemaphore);
+
+	 chMtxLock(&ImuMutex);
+	 if (ImuRunning)
+	     {
+		 now=timeMicros();
+		 imuDrainGyr(now);
+		 imuDrainAcc(now);
+		 imuDrainMag(now);
+	     }
+	 chMtxUnlock();
+     }
+
+ return 0;
+ }
+
+// Starts the background sampling
+// Returns 0 on error
+int32_t imuStart(ContextType *context)
+ {
+ int32_t i;
+ uint32_t now;
+
+ chMtxLock(&ImuMutex);
+
+ if (!ImuRunning)
+     {
+	 // The interrupt lines cannot be shared with edge lines
+	 if ((edgeChannelUsed(GYR_INT2_PIN))||(edgeChannelUsed(ACCEL_INT1_PIN))
+		 ||(edgeChannelUsed(MAG_DRDY_PIN)))
+	     {
+		 chMtxUnlock();
+		 consoleErrorMessage(context,"IMU interrupt lines used by edge events");
+		 return 0;
+	     }
+
+	 // A duty stream holds the I2C1 DMA
+	 if (pwmIsStreaming())
+	     {
+		 chMtxUnlock();
+		 consoleErrorMessage(context,"I2C1 DMA in use by a PWM stream");
+		 return 0;
+	     }
+
+	 // Reset rings
+	 now=timeMicros();
+	 for(i=0;i<IMU_NSENSORS;i++)
+	     {
+		 ImuSensors[i].Count=0;
+		 ImuSensors[i].Overruns=0;
+		 ImuSensors[i].LastTime=now;
+	     }
+
+	 // Gyroscope rate, FIFO in stream mode and watermark on INT2
+	 busesGyrWrite(GYR_CREG1,IMU_GYR_CREG1);
+	 busesGyrWrite(GYR_FIFO_CTRL,IMU_GYR_FIFO|IMU_FIFO_WTM);
+	 busesGyrWrite(GYR_CREG5,IMU_FIFO_EN);
+	 busesGyrWrite(GYR_CREG3,IMU_GYR_CREG3);
+
+	 // Accelerometer rate, FIFO in stream mode and watermark on INT1
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_CTRL_REG1_A,IMU_ACC_CTRL1);
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_FIFO_CTRL_A,IMU_ACC_FIFO|IMU_FIFO_WTM);
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_CTRL_REG5_A,IMU_FIFO_EN);
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_CTRL_REG3_A,IMU_ACC_CTRL3);
+
+	 // Magnetometer rate
+	 busesSensorWrite(MAGNET_ADDR,MAG_CRA_REG_M,IMU_MAG_CRA);
+
+	 // Interrupt lines
+	 gpioExtSet(GYR_INT2_PIN,EXT_CH_MODE_RISING_EDGE|EXT_MODE_GPIOE,imuExtCallback);
+	 gpioExtSet(ACCEL_INT1_PIN,EXT_CH_MODE_RISING_EDGE|EXT_MODE_GPIOE,imuExtCallback);
+	 gpioExtSet(MAG_DRDY_PIN,EXT_CH_MODE_RISING_EDGE|EXT_MODE_GPIOE,imuExtCallback);
+
+	 ImuRunning=1;
+     }
+
+ chMtxUnlock();
+
+ // Wake the thread
+ chBSemSignal(&ImuSemaphore);
+
+ return 1; // Ok
+ }
+
+// Stops the background sampling
+void imuStop(void)
+ {
+ chMtxLock(&ImuMutex);
+
+ if (ImuRunning)
+     {
+	 ImuRunning=0;
+
+	 // Interrupt lines
+	 gpioExtSet(GYR_INT2_PIN,EXT_CH_MODE_DISABLED,NULL);
+	 gpioExtSet(ACCEL_INT1_PIN,EXT_CH_MODE_DISABLED,NULL);
+	 gpioExtSet(MAG_DRDY_PIN,EXT_CH_MODE_DISABLED,NULL);
+
+	 // Gyroscope back to bypass mode
+	 busesGyrWrite(GYR_CREG3,0);
+	 busesGyrWrite(GYR_CREG5,0);
+	 busesGyrWrite(GYR_FIFO_CTRL,0);
+	 busesGyrWrite(GYR_CREG1,IMU_GYR_CREG1_IDLE);
+
+	 // Accelerometer back to bypass mode
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_CTRL_REG3_A,0);
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_CTRL_REG5_A,0);
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_FIFO_CTRL_A,0);
+	 busesSensorWrite(ACCEL_ADDR,ACCEL_CTRL_REG1_A,IMU_ACC_CTRL1_IDLE);
+
+	 // Magnetometer rate
+	 busesSensorWrite(MAGNET_ADDR,MAG_CRA_REG_M,IMU_MAG_CRA_IDLE);
+     }
+
+ chMtxUnlock();
+ }
+
+// Copies the last n samples of a sensor as four cells
+// (time x y z) each, oldest first
+// Returns the number of samples copied
+static int32_t imuCopy(int32_t sensor,int32_t *dest,int32_t n)
+ {
+ ImuSensor *s;
+ ImuSample *p;
+ uint32_t first;
+ int32_t i;
+
+ s=&ImuSensors[sensor];
+
+ chSysLock();
+
+ // Limit to the available samples
+ if (((uint32_t)n)>(s->Count)) n=s->Count;
+ if (n>IMU_RING_SIZE) n=IMU_RING_SIZE;
+
+ first=(s->Count)-n;
+ for(i=0;i<n;i++)
+     {
+	 p=&(s->Ring[(first+i)%IMU_RING_SIZE]);
+	 (*dest++)=(int32_t)p->Time;
+	 (*dest++)=p->Data[0];
+	 (*dest++)=p->Data[1];
+	 (*dest++)=p->Data[2];
+     }
+
+ chSysUnlock();
+
+ return n;
+ }
+
+// Try to get a sensor number from the stack
+// Returns 0 on error
+static int32_t getSensor(ContextType *context,int32_t *sensor)
+ {
+ if (PstackPop(context,sensor)) return 0;
+
+ if (((*sensor)<0)||((*sensor)>=IMU_NSENSORS))
+     {
+	 consoleErrorMessage(context,"Invalid sensor");
+	 return 0;
+     }
+
+ return 1; // Ok
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void imuModuleInit(void)
+ {
+ chBSemInit(&ImuSemaphore,TRUE);
+ chMtxInit(&ImuMutex);
+
+ // The thread waits until the service is started
+ chThdCreateStatic(waImuThread,sizeof(waImuThread),IMU_THREAD_PRIO,imuThread,NULL);
+ }
+
+// Indicates if the background sampling is running
+int32_t imuIsRunning(void)
+ {
+ return ImuRunning;
+ }
+
+// Gets the latest raw sample of a sensor
+// Gives zeros if there is none yet
+void imuLatest(int32_t sensor,int16_t *xyz)
+ {
+ ImuSensor *s;
+ ImuSample *p;
+
+ s=&ImuSensors[sensor];
+
+ chSysLock();
+ if (s->Count)
+     {
+	 p=&(s->Ring[((s->Count)-1)%IMU_RING_SIZE]);
+	 xyz[0]=p->Data[0];
+	 xyz[1]=p->Data[1];
+	 xyz[2]=p->Data[2];
+     }
+    else
+     xyz[0]=xyz[1]=xyz[2]=0;
+ chSysUnlock();
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic IMU service function
+int32_t imuFunction(ContextType *context,int32_t value)
+ {
+ int32_t sensor,n,addr;
+ int16_t xyz[3];
+
+ switch (value)
+     {
+     case IMU_F_START: // Start background sampling
+    	 imuStart(context);
+    	 break;
+
+     case IMU_F_STOP: // Stop background sampling
+    	 imuStop();
+    	 break;
+
+     case IMU_F_LAST: // Latest sample ( us -- z y x )
+    	 if (!getSensor(context,&sensor)) return 0;
+    	 imuLatest(sensor,xyz);
+    	 PstackPush(context,xyz[2]);
+    	 PstackPush(context,xyz[1]);
+    	 PstackPush(context,xyz[0]);
+    	 break;
+
+     case IMU_F_COPY: // Copy last samples ( addr n us -- n )
+    	 if (!getSensor(context,&sensor)) return 0;
+    	 if (PstackPop(context,&n)) return 0;
+    	 if (PstackPop(context,&addr)) return 0;
+    	 if ((n<1)||(n>IMU_RING_SIZE))
+    	       {
+    		   consoleErrorMessage(context,"Invalid number of samples");
+    		   return 0;
+    	       }
+    	 if ((addr&3)||(!portUserBuffer((uint32_t)addr,n*IMU_RECORD_SIZE)))
+    	       {
+    		   consoleErrorMessage(context,"Invalid buffer");
+    		   return 0;
+    	       }
+    	 PstackPush(context,imuCopy(sensor,(int32_t*)(uintptr_t)addr,n));
+    	 break;
+
+     case IMU_F_COUNT: // Number of samples ( us -- u )
+    	 if (!getSensor(context,&sensor)) return 0;
+    	 PstackPush(context,(int32_t)ImuSensors[sensor].Count);
+    	 break;
+
+     case IMU_F_OVERRUNS: // FIFO overruns ( us -- u )
+    	 if (!getSensor(context,&sensor)) return 0;
+    	 PstackPush(context,(int32_t)ImuSensors[sensor].Overruns);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in imuFunction");
+     }
+
+ return 0;
+ }
+
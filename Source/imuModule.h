@@ -0,0 +1,82 @@
+/*
+ imuModule.h
+ Inertial sensors background sampling header file
+
+ A thread drains the gyroscope and accelerometer FIFOs
+ and the magnetometer data registers when their interrupt
+ lines signal new data and keeps timestamped rings
+ */
+
+#ifndef _IMU_MODULE
+#define _IMU_MODULE
+
+// Sensors
+#define IMU_GYR           0    // Gyroscope
+#define IMU_ACC           1    // Accelerometer
+#define IMU_MAG           2    // Magnetometer
+#define IMU_NSENSORS      3
+
+// Service definitions
+#define IMU_RING_SIZE     64             // Samples per sensor (power of 2)
+#define IMU_THREAD_WA     512            // Thread working area
+#define IMU_THREAD_PRIO   (NORMALPRIO+20)
+#define IMU_POLL_TICKS    20             // Max time between drains (ms)
+#define IMU_RECORD_SIZE   16             // Bytes per copied sample
+
+// FIFO definitions (same in L3GD20 and LSM303DLHC)
+#define IMU_FIFO_SIZE     32     // FIFO depth in samples
+#define IMU_FIFO_WTM      4      // Watermark level for the interrupt
+#define IMU_FIFO_EN       0x40   // FIFO enable bit in CTRL_REG5
+#define IMU_FIFO_OVRN     0x40   // Overrun bit in FIFO_SRC
+#define IMU_FIFO_FSS      0x1F   // Stored samples in FIFO_SRC
+
+// Sensor configuration while sampling
+#define IMU_GYR_CREG1     0x8F   // 380Hz all axes enabled
+#define IMU_GYR_FIFO      0x40   // Stream mode
+#define IMU_GYR_CREG3     0x04   // Watermark on INT2
+#define IMU_ACC_CTRL1     0x77   // 400Hz all axes enabled
+#define IMU_ACC_FIFO      0x80   // Stream mode
+#define IMU_ACC_CTRL3     0x04   // Watermark on INT1
+#define IMU_MAG_CRA       (7<<2) // 220Hz
+
+// Sensor configuration when stopped (as set by busesInit)
+#define IMU_GYR_CREG1_IDLE  0x0F
+#define IMU_ACC_CTRL1_IDLE  0x57
+#define IMU_MAG_CRA_IDLE    (6<<2)
+
+// One sample in the ring
+typedef struct
+ {
+ uint32_t Time;     // Timestamp in us
+ int16_t Data[3];   // X,Y,Z raw values
+ }
+ ImuSample;
+
+// Ring data for one sensor
+typedef struct
+ {
+ ImuSample Ring[IMU_RING_SIZE];
+ volatile uint32_t Count;    // Total number of samples stored
+ uint32_t Overruns;          // Sensor FIFO overruns
+ uint32_t LastTime;          // Time of previous drain
+ }
+ ImuSensor;
+
+// Function prototypes
+void imuModuleInit(void);
+int32_t imuStart(ContextType *context);
+void imuStop(void);
+int32_t imuIsRunning(void);
+void imuLatest(int32_t sensor,int16_t *xyz);
+
+// Command functions
+int32_t imuFunction(ContextType *context,int32_t value);
+#define IMU_F_START      0   // Start background sampling
+#define IMU_F_STOP       1   // Stop background sampling
+#define IMU_F_LAST       2   // Latest sample of a sensor
+#define IMU_F_COPY       3   // Copy last samples of a sensor
+#define IMU_F_COUNT      4   // Number of samples taken
+#define IMU_F_OVERRUNS   5   // Number of FIFO overruns
+
+#endif // _IMU_MODULE
+
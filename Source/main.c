@@ -30,6 +30,18 @@
 #include "timeModule.h"
 #include "gpioModule.h"
 #include "pwmModule.h"
+#include "acqModule.h"
+#include "waveModule.h"
+#include "patternModule.h"
+#include "imuModule.h"
+#include "fusionModule.h"
+#include "edgeModule.h"
+#include "captureModule.h"
+#include "encoderModule.h"
+#include "uartModule.h"
+#include "usbDataModule.h"
+#include "telemetryModule.h"
+#include "rpcModule.h"
 
 
 // Main function ---------------------------------
@@ -44,6 +56,9 @@ int main(void)
  // Start GPIOs
  gpioModuleInit();
 
+ // USB binary data channel must be ready before the USB starts
+ usbDataModuleInit();
+
  // Start serial over USB
  startUSBserial();
 
@@ -73,6 +88,39 @@ int main(void)
  // Initialize the PWM module
  pwmModuleInit();
 
+ // Initialize the analog capture module
+ acqModuleInit();
+
+ // Initialize the waveform module
+ waveModuleInit();
+
+ // Initialize the GPIO pattern engine
+ patternModuleInit();
+
+ // Initialize the sensors sampling service
+ imuModuleInit();
+
+ // Initialize the attitude fusion engine
+ fusionModuleInit();
+
+ // Initialize the GPIO edge events
+ edgeModuleInit();
+
+ // Initialize the input capture module
+ captureModuleInit();
+
+ // Initialize the quadrature encoder module
+ encoderModuleInit();
+
+ // Initialize the UART data port
+ uartModuleInit();
+
+ // Initialize the binary telemetry
+ telemetryModuleInit();
+
+ // Initialize the binary RPC mode
+ rpcModuleInit();
+
  // Load flash memory
  //flashLoad();
 
@@ -0,0 +1,536 @@
+/*
+ patternModule.c
+ GPIO pattern output and logic capture source file
+
+ TIM8 update event requests DMA2 Channel 1 that writes the
+ next buffer word to the GPIO port so pulse trains and custom
+ protocols are generated without CPU intervention
+
+ Port format buffers hold half words written to the whole ODR
+ BSRR format buffers hold words with the bits to set in the
+ low half and the bits to clear in the high half so only the
+ selected lines change
+
+ Buffers use port bit positions. PatMap converts buffers
+ written with GPIO line numbers as DigitalBinWrite uses
+
+ Lines must be set as outputs before starting the output
+
+ Logic capture uses the same timer and DMA to sample the
+ port input register into a half word buffer. An optional
+ trigger pattern is polled by the CPU before the capture
+ starts so there are no pre trigger samples
+
+ DMA2 Channel 1 is shared with SPI3 RX so the engine
+ cannot start while the SPI is started and the SPI cannot
+ start while the engine holds the DMA. The DMA is released
+ as soon as a one shot output or a capture completes
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "gpioModule.h"    // GPIO module header
+#include "patternModule.h" // This module header
+
+// GPIO Array in gpioModule.c
+extern const uint16_t GpioArray[10];
+
+// Engine status
+static volatile int32_t patStatus=PATS_STOP;
+
+// Word frequency
+static int32_t patFreq=PAT_DEF_FREQ;
+
+// DMA allocation flag
+static int32_t patDmaAllocated=0;
+
+// Capture trigger in port bits (no trigger if mask is zero)
+static uint32_t patTrigMask=0;
+static uint32_t patTrigValue=0;
+
+// Real sample frequency of the last capture
+static int32_t patCaptureFreq=PAT_DEF_FREQ;
+
+// Dump checksum
+static uint8_t patDumpSum;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Program the request timer for the given frequency
+// Returns the real frequency obtained
+static int32_t patTimerSet(int32_t freq)
+ {
+ uint32_t div,psc,arr;
+
+ // Total division from the timer clock
+ div=PAT_TIMER_CLOCK/freq;
+
+ // Prescaler needed to fit the 16 bit counter
+ psc=div/65536;
+ arr=(div/(psc+1))-1;
+
+ // Configure the timer stopped
+ PAT_TIMER->CR1=0;
+ PAT_TIMER->PSC=psc;
+ PAT_TIMER->ARR=arr;
+ PAT_TIMER->RCR=0;
+
+ // Load prescaler and clear flags
+ PAT_TIMER->DIER=0;
+ PAT_TIMER->EGR=TIM_EGR_UG;
+ PAT_TIMER->SR=0;
+
+ return PAT_TIMER_CLOCK/((psc+1)*(arr+1));
+ }
+
+// Stops the output
+// The DMA channel is only touched if the engine owns it
+// as it is shared with SPI3 RX
+// Can be called from the DMA interrupt
+static void patHalt(int32_t status)
+ {
+ if (patDmaAllocated)
+     {
+	 // Stop the requests
+	 PAT_TIMER->CR1&=~TIM_CR1_CEN;
+	 PAT_TIMER->DIER=0;
+
+	 // Stop the DMA
+	 dmaStreamDisable(PAT_DMA_STREAM);
+     }
+
+ patStatus=status;
+ }
+
+// Releases the DMA if it is allocated
+// Must be called with the system locked
+static void patReleaseS(void)
+ {
+ if (patDmaAllocated)
+     {
+	 dmaStreamRelease(PAT_DMA_STREAM);
+	 patDmaAllocated=0;
+     }
+ }
+
+// DMA interrupt callback
+// Only used in one shot mode
+static void patDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+
+ if (flags&(STM32_DMA_ISR_TCIF|STM32_DMA_ISR_TEIF))
+     {
+	 patHalt(PATS_DONE);
+
+	 // Free the DMA for the SPI
+	 chSysLockFromIsr();
+	 patReleaseS();
+	 chSysUnlockFromIsr();
+     }
+ }
+
+// Stops any output and releases the DMA
+static void patStop(void)
+ {
+ patHalt(PATS_STOP);
+
+ chSysLock();
+ patReleaseS();
+ chSysUnlock();
+ }
+
+// Maps a GPIO line mask to port bits
+static uint32_t patMapLines(uint32_t lines)
+ {
+ int32_t i;
+ uint32_t port=0;
+
+ for(i=0;i<10;i++)
+	 if (lines&BIT(i))
+		 port|=BIT(GpioArray[i]);
+
+ return port;
+ }
+
+// Maps port bits to a GPIO line mask
+static uint32_t patUnmapPort(uint32_t port)
+ {
+ int32_t i;
+ uint32_t lines=0;
+
+ for(i=0;i<10;i++)
+	 if (port&BIT(GpioArray[i]))
+		 lines|=BIT(i);
+
+ return lines;
+ }
+
+// Try to get a buffer and its format from the stack ( addr n uformat -- )
+// Returns 0 on error
+static int32_t getPattern(ContextType *context,uint32_t *addr,int32_t *n,int32_t *format)
+ {
+ int32_t data,size;
+
+ if (PstackPop(context,format)) return 0;
+ if (PstackPop(context,n)) return 0;
+ if (PstackPop(context,&data)) return 0;
+
+ // Check format
+ if (((*format)!=PAT_FORMAT_PORT)&&((*format)!=PAT_FORMAT_BSRR))
+      {
+	  consoleErrorMessage(context,"Invalid pattern format");
+	  return 0;
+      }
+ size=((*format)==PAT_FORMAT_PORT)?sizeof(uint16_t):sizeof(uint32_t);
+
+ // Check number of words
+ if (((*n)<1)||((*n)>PAT_MAX_WORDS))
+      {
+	  consoleErrorMessage(context,"Invalid number of words");
+	  return 0;
+      }
+
+ // Check buffer
+ (*addr)=(uint32_t)data;
+ if (((*addr)&(size-1))||(!portDmaBuffer(*addr,(*n)*size)))
+      {
+	  consoleErrorMessage(context,"Invalid buffer");
+	  return 0;
+      }
+
+ return 1; // Ok
+ }
+
+// Start an output ( addr n uformat -- )
+static void patStart(ContextType *context,int32_t loop)
+ {
+ uint32_t addr,dmaMode;
+ int32_t n,format;
+
+ if (!getPattern(context,&addr,&n,&format)) return;
+
+ // Stop any previous output
+ patStop();
+
+ // Try to allocate the DMA
+ if (dmaStreamAllocate(PAT_DMA_STREAM,PAT_IRQ_PRIORITY,patDmaCallback,NULL))
+      {
+	  consoleErrorMessage(context,"Pattern DMA is busy (SPI started?)");
+	  return;
+      }
+ patDmaAllocated=1;
+
+ // Program the timer
+ patTimerSet(patFreq);
+
+ // Program the DMA
+ dmaMode=STM32_DMA_CR_DIR_M2P|STM32_DMA_CR_MINC|STM32_DMA_CR_PSIZE_WORD
+		|STM32_DMA_CR_PL(PAT_DMA_PRIORITY);
+ if (format==PAT_FORMAT_PORT)
+     {
+	 dmaMode|=STM32_DMA_CR_MSIZE_HWORD;
+	 dmaStreamSetPeripheral(PAT_DMA_STREAM,&(GPIO_PORT->ODR));
+     }
+    else
+     {
+     dmaMode|=STM32_DMA_CR_MSIZE_WORD;
+     dmaStreamSetPeripheral(PAT_DMA_STREAM,&(GPIO_PORT->BSRR.W));
+     }
+ if (loop)
+	 dmaMode|=STM32_DMA_CR_CIRC;
+    else
+     dmaMode|=STM32_DMA_CR_TCIE|STM32_DMA_CR_TEIE;
+ dmaStreamSetMemory0(PAT_DMA_STREAM,(void*)addr);
+ dmaStreamSetTransactionSize(PAT_DMA_STREAM,n);
+ dmaStreamSetMode(PAT_DMA_STREAM,dmaMode);
+ dmaStreamEnable(PAT_DMA_STREAM);
+
+ // Start the requests
+ patStatus=loop?PATS_LOOP:PATS_ONCE;
+ PAT_TIMER->DIER=TIM_DIER_UDE;
+ PAT_TIMER->CR1|=TIM_CR1_CEN;
+ }
+
+// Map a buffer in place from line values to port values
+// ( addr n uformat -- )
+static void patMap(ContextType *context)
+ {
+ uint32_t addr;
+ int32_t n,format,i;
+ uint16_t *pHalf;
+ uint32_t *pWord;
+
+ if (!getPattern(context,&addr,&n,&format)) return;
+
+ if (format==PAT_FORMAT_PORT)
+     {
+	 pHalf=(uint16_t*)addr;
+	 for(i=0;i<n;i++)
+		 pHalf[i]=patMapLines(pHalf[i]);
+     }
+    else
+     {
+     pWord=(uint32_t*)addr;
+     for(i=0;i<n;i++)
+    	 pWord[i]=patMapLines(pWord[i]&0xFFFF)
+		         |(patMapLines(pWord[i]>>16)<<16);
+     }
+ }
+
+// Start a logic capture ( addr n -- )
+// Blocks until the trigger pattern is found
+static void patCapture(ContextType *context)
+ {
+ int32_t addr,n;
+ uint32_t count;
+
+ // Get parameters
+ if (PstackPop(context,&n)) return;
+ if (PstackPop(context,&addr)) return;
+
+ // Check them
+ if ((n<1)||(n>PAT_MAX_WORDS))
+      {
+	  consoleErrorMessage(context,"Invalid number of samples");
+	  return;
+      }
+ if ((addr&1)||(!portDmaBuffer((uint32_t)addr,n*sizeof(uint16_t))))
+      {
+	  consoleErrorMessage(context,"Invalid buffer");
+	  return;
+      }
+
+ // Stop any previous operation
+ patStop();
+
+ // Try to allocate the DMA
+ if (dmaStreamAllocate(PAT_DMA_STREAM,PAT_IRQ_PRIORITY,patDmaCallback,NULL))
+      {
+	  consoleErrorMessage(context,"Pattern DMA is busy (SPI started?)");
+	  return;
+      }
+ patDmaAllocated=1;
+
+ // Program the timer so the first request comes
+ // on the first clock after the start
+ patCaptureFreq=patTimerSet(patFreq);
+ PAT_TIMER->CNT=PAT_TIMER->ARR;
+
+ // Program the DMA
+ dmaStreamSetPeripheral(PAT_DMA_STREAM,&(GPIO_PORT->IDR));
+ dmaStreamSetMemory0(PAT_DMA_STREAM,(void*)addr);
+ dmaStreamSetTransactionSize(PAT_DMA_STREAM,n);
+ dmaStreamSetMode(PAT_DMA_STREAM,STM32_DMA_CR_DIR_P2M|STM32_DMA_CR_MINC
+		          |STM32_DMA_CR_PSIZE_HWORD|STM32_DMA_CR_MSIZE_HWORD
+		          |STM32_DMA_CR_TCIE|STM32_DMA_CR_TEIE
+		          |STM32_DMA_CR_PL(PAT_DMA_PRIORITY));
+ dmaStreamEnable(PAT_DMA_STREAM);
+ PAT_TIMER->DIER=TIM_DIER_UDE;
+
+ // Wait for the trigger
+ count=0;
+ if (patTrigMask)
+   while (((GPIO_PORT->IDR)&patTrigMask)!=patTrigValue)
+     if (!((++count)&(PAT_TRIG_CHECK-1)))
+        if (PORT_ABORT)
+           {
+           patStop();
+    	   runtimeErrorMessage(context,"Capture trigger aborted");
+    	   return;
+           }
+
+ // Start the requests
+ patStatus=PATS_CAPTURE;
+ PAT_TIMER->CR1|=TIM_CR1_CEN;
+ }
+
+// Sends one dump byte adding it to the checksum
+static void patDumpByte(uint32_t value)
+ {
+ patDumpSum+=(uint8_t)value;
+ consolePutChar(value&0xFF);
+ }
+
+// Sends a 32 bit little endian dump value
+static void patDumpWord(uint32_t value)
+ {
+ int32_t i;
+
+ for(i=0;i<4;i++)
+     {
+	 patDumpByte(value);
+	 value>>=8;
+     }
+ }
+
+// Dump a capture buffer RLE encoded ( addr n -- )
+static void patDump(ContextType *context)
+ {
+ int32_t addr,n,i,runs;
+ uint16_t *buffer;
+ uint32_t value,length;
+
+ // Get parameters
+ if (PstackPop(context,&n)) return;
+ if (PstackPop(context,&addr)) return;
+
+ // Check them
+ if ((n<1)||(n>PAT_MAX_WORDS))
+      {
+	  consoleErrorMessage(context,"Invalid number of samples");
+	  return;
+      }
+ if ((addr&1)||(!portUserBuffer((uint32_t)addr,n*sizeof(uint16_t))))
+      {
+	  consoleErrorMessage(context,"Invalid buffer");
+	  return;
+      }
+ if (patStatus==PATS_CAPTURE)
+      {
+	  consoleErrorMessage(context,"Capture in progress");
+	  return;
+      }
+ buffer=(uint16_t*)addr;
+
+ // Count the runs
+ runs=1;
+ for(i=1;i<n;i++)
+	 if (patUnmapPort(buffer[i])!=patUnmapPort(buffer[i-1])) runs++;
+
+ // Header
+ consolePutChar('L');
+ consolePutChar('A');
+ patDumpSum=0;
+ patDumpByte(PAT_DUMP_VERSION);
+ patDumpByte(10);
+ patDumpWord(patCaptureFreq);
+ patDumpWord(n);
+ patDumpWord(runs);
+
+ // Runs
+ i=0;
+ while (i<n)
+    {
+	value=patUnmapPort(buffer[i]);
+	length=1;
+	while (((i+length)<(uint32_t)n)&&(patUnmapPort(buffer[i+length])==value))
+		length++;
+	i+=length;
+
+	patDumpByte(value);
+	patDumpByte(value>>8);
+	while (length>0x7F)
+	    {
+		patDumpByte((length&0x7F)|0x80);
+		length>>=7;
+	    }
+	patDumpByte(length);
+    }
+
+ // Checksum
+ consolePutChar(patDumpSum);
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void patternModuleInit(void)
+ {
+ // Enable request timer clock
+ RCC->APB2ENR|=RCC_APB2ENR_TIM8EN;
+ }
+
+// Indicates if the engine holds DMA2 Channel 1
+// that is shared with SPI3 RX
+int32_t patternDmaInUse(void)
+ {
+ return patDmaAllocated;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic pattern function
+int32_t patternFunction(ContextType *context,int32_t value)
+ {
+ int32_t data;
+
+ switch (value)
+     {
+     case PAT_F_FREQ: // Set word frequency ( uf -- uf )
+    	 if (PstackPop(context,&data)) return 0;
+    	 // Check range
+    	 if ((data<PAT_MIN_FREQ)||(data>PAT_MAX_FREQ))
+    	       {
+    		   consoleErrorMessage(context,"Invalid frequency");
+    		   return 0;
+    	       }
+    	 if ((patStatus==PATS_ONCE)||(patStatus==PATS_LOOP)||(patStatus==PATS_CAPTURE))
+    	       {
+    		   consoleErrorMessage(context,"Pattern output is running");
+    		   return 0;
+    	       }
+    	 patFreq=data;
+    	 PstackPush(context,patTimerSet(patFreq));
+    	 break;
+
+     case PAT_F_ONCE: // One shot output ( addr n uformat -- )
+    	 patStart(context,0);
+    	 break;
+
+     case PAT_F_LOOP: // Circular output ( addr n uformat -- )
+    	 patStart(context,1);
+    	 break;
+
+     case PAT_F_STOP: // Stop output
+    	 patStop();
+    	 break;
+
+     case PAT_F_WAIT: // Wait end of one shot output or capture
+    	 while ((patStatus==PATS_ONCE)||(patStatus==PATS_CAPTURE))
+    	     {
+    		 if (PORT_ABORT)
+    		      {
+    			  patStop();
+    			  runtimeErrorMessage(context,"Pattern wait aborted");
+    			  return 0;
+    		      }
+    		 chThdSleep(PAT_WAIT_POLL);
+    	     }
+    	 break;
+
+     case PAT_F_MAP: // Map buffer from lines to port ( addr n uformat -- )
+    	 patMap(context);
+    	 break;
+
+     case PAT_F_TRIGGER: // Set capture trigger ( umask uvalue -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 patTrigValue=patMapLines(data);
+    	 if (PstackPop(context,&data)) return 0;
+    	 patTrigMask=patMapLines(data);
+    	 patTrigValue&=patTrigMask;
+    	 break;
+
+     case PAT_F_CAPTURE: // Start capture ( addr n -- )
+    	 patCapture(context);
+    	 break;
+
+     case PAT_F_DUMP: // Dump capture ( addr n -- )
+    	 patDump(context);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in patternFunction");
+     }
+
+ return 0;
+ }
+
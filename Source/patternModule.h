@@ -0,0 +1,67 @@
+/*
+ patternModule.h
+ GPIO pattern output and logic capture header file
+
+ TIM8 update requests DMA2 Channel 1 to move words
+ from user memory to the GPIO port registers or
+ from the port input register to user memory
+ */
+
+#ifndef _PATTERN_MODULE
+#define _PATTERN_MODULE
+
+// Hardware used for this module
+#define PAT_TIMER            TIM8                // Request timer
+#define PAT_DMA_STREAM       STM32_DMA2_STREAM1  // TIM8 UP DMA channel
+#define PAT_DMA_PRIORITY     3                   // DMA priority (0..3)
+#define PAT_IRQ_PRIORITY     6                   // DMA IRQ priority
+
+// Pattern limits
+#define PAT_TIMER_CLOCK      72000000    // TIM8 clock (f APB2 x 2)
+#define PAT_MIN_FREQ         1           // Min word frequency
+#define PAT_MAX_FREQ         2000000     // Max word frequency
+#define PAT_MAX_WORDS        65535       // DMA counter limit
+#define PAT_DEF_FREQ         100000      // Default word frequency
+
+// Wait poll interval for abort check (in system ticks)
+#define PAT_WAIT_POLL        10
+
+// Buffer formats
+#define PAT_FORMAT_PORT      0    // Half words written to ODR
+#define PAT_FORMAT_BSRR      1    // Words written to BSRR
+
+// Engine status
+#define PATS_STOP            0    // Not running
+#define PATS_ONCE            1    // One shot output in progress
+#define PATS_LOOP            2    // Circular output
+#define PATS_DONE            3    // One shot output or capture completed
+#define PATS_CAPTURE         4    // Logic capture in progress
+
+// Trigger poll iterations between abort checks (power of 2)
+#define PAT_TRIG_CHECK       1024
+
+// Logic capture dump format
+// Header:  'L' 'A' version nlines freq(4) samples(4) runs(4)
+// Runs:    value(2) length(LEB128 varint)
+// End:     8 bit sum of all bytes after the magic
+// Multibyte fields are little endian and values use GPIO line bits
+#define PAT_DUMP_VERSION     1
+
+// Function prototypes
+void patternModuleInit(void);
+int32_t patternDmaInUse(void);
+
+// Command functions
+int32_t patternFunction(ContextType *context,int32_t value);
+#define PAT_F_FREQ        0   // Set word frequency
+#define PAT_F_ONCE        1   // Start one shot output
+#define PAT_F_LOOP        2   // Start circular output
+#define PAT_F_STOP        3   // Stop the output
+#define PAT_F_WAIT        4   // Wait end of one shot output
+#define PAT_F_MAP         5   // Map line values to port values
+#define PAT_F_TRIGGER     6   // Set logic capture trigger
+#define PAT_F_CAPTURE     7   // Start logic capture
+#define PAT_F_DUMP        8   // Dump logic capture
+
+#endif // _PATTERN_MODULE
+
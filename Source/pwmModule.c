@@ -1,6 +1,16 @@
 /*
  pwmModule.c
  PWM functions source file
+
+ Duty streaming sets TIM3 so the CH1 DMA request comes on each
+ update event and uses the timer DMA burst to write one frame
+ of CCR values from a user memory table every PWM period
+
+ DMA1 Channel 6 is also used by the I2C1 driver so the
+ accelerometer and magnetometer cannot be accessed while
+ a duty stream is running. The DMA is released as soon as
+ a one shot stream completes and it is never touched while
+ the stream does not own it
  */
 
 // Includes
@@ -16,6 +26,7 @@
 #include "gizmo.h"         // Main include for the project
 #include "serialModule.h"  // Serial module header
 #include "timeModule.h"
+#include "imuModule.h"     // IMU service
 #include "pwmModule.h"     // This module header
 
 
@@ -25,6 +36,12 @@ static PWMConfig pwmcfg;
 // Global PWM status
 static int32_t pwmStatus=PWMS_OFF;
 
+// Duty streaming
+static PwmStream pwmStream={NULL,0,0,0,NULL,0,PWMSS_STOP};
+
+// DMA allocation flag
+static int32_t pwmDmaAllocated=0;
+
 /****************** STATIC FUNCTIONS *********************/
 
 // Activate PWM module if inactive
@@ -75,6 +92,176 @@ static int32_t getChannelNumber(ContextType *context,int32_t *num)
  return 1; // Ok
  }
 
+// Program the DMA for a table and enable it
+static void pwmStreamDmaSet(uint16_t *table,int32_t frames,int32_t loop)
+ {
+ uint32_t mode;
+
+ mode=STM32_DMA_CR_DIR_M2P|STM32_DMA_CR_MINC|STM32_DMA_CR_PSIZE_HWORD
+	 |STM32_DMA_CR_MSIZE_HWORD|STM32_DMA_CR_TCIE|STM32_DMA_CR_PL(PWM_DMA_PRIORITY);
+ if (loop) mode|=STM32_DMA_CR_CIRC;
+
+ dmaStreamSetPeripheral(PWM_DMA_STREAM,&(PWM_TIMER->DMAR));
+ dmaStreamSetMemory0(PWM_DMA_STREAM,table);
+ dmaStreamSetTransactionSize(PWM_DMA_STREAM,frames*pwmStream.Channels);
+ dmaStreamSetMode(PWM_DMA_STREAM,mode);
+ dmaStreamEnable(PWM_DMA_STREAM);
+ }
+
+// Stops the timer DMA requests
+// The DMA channel is only touched if the stream owns it
+// as it is shared with I2C1 TX
+// Can be called from the DMA interrupt
+static void pwmStreamHalt(int32_t status)
+ {
+ if (pwmDmaAllocated)
+     {
+	 PWM_TIMER->DIER&=~TIM_DIER_CC1DE;
+	 PWM_TIMER->CR2&=~TIM_CR2_CCDS;
+	 PWM_TIMER->DCR=0;
+	 dmaStreamDisable(PWM_DMA_STREAM);
+     }
+ pwmStream.Pending=NULL;
+ pwmStream.Status=status;
+ }
+
+// Releases the DMA if it is allocated
+// Must be called with the system locked
+static void pwmReleaseS(void)
+ {
+ if (pwmDmaAllocated)
+     {
+	 dmaStreamRelease(PWM_DMA_STREAM);
+	 pwmDmaAllocated=0;
+     }
+ }
+
+// DMA interrupt callback
+// Called at the end of each table pass
+static void pwmDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+
+ if (!(flags&STM32_DMA_ISR_TCIF)) return;
+
+ chSysLockFromIsr();
+
+ if (pwmStream.Status==PWMSS_ONCE)
+     {
+	 // Free the DMA for I2C1
+	 pwmStreamHalt(PWMSS_DONE);
+	 pwmReleaseS();
+     }
+    else
+     if (pwmStream.Pending!=NULL)
+         {
+    	 // Change the table at a frame boundary
+    	 dmaStreamDisable(PWM_DMA_STREAM);
+    	 pwmStream.Table=pwmStream.Pending;
+    	 pwmStream.Frames=pwmStream.PendingFrames;
+    	 pwmStreamDmaSet(pwmStream.Table,pwmStream.Frames,1);
+    	 pwmStream.Pending=NULL;
+         }
+
+ chSysUnlockFromIsr();
+ }
+
+// Stops the duty streaming and releases the DMA
+static void pwmStreamStop(void)
+ {
+ pwmStreamHalt(PWMSS_STOP);
+
+ chSysLock();
+ pwmReleaseS();
+ chSysUnlock();
+ }
+
+// Try to get a duty table from the stack ( addr nframes -- )
+// Each frame has nch half words
+// Returns 0 on error
+static int32_t getTable(ContextType *context,int32_t nch,uint16_t **table,int32_t *frames)
+ {
+ int32_t addr;
+
+ if (PstackPop(context,frames)) return 0;
+ if (PstackPop(context,&addr)) return 0;
+
+ // Check size
+ if (((*frames)<1)||(((*frames)*nch)>PWM_MAX_TRANSFERS))
+      {
+	  consoleErrorMessage(context,"Invalid number of frames");
+	  return 0;
+      }
+
+ // Check buffer
+ if ((addr&1)||(!portDmaBuffer((uint32_t)addr,(*frames)*nch*sizeof(uint16_t))))
+      {
+	  consoleErrorMessage(context,"Invalid duty table");
+	  return 0;
+      }
+
+ (*table)=(uint16_t*)addr;
+ return 1; // Ok
+ }
+
+// Start duty streaming ( addr nframes uch1 nch -- )
+static void pwmStreamStart(ContextType *context,int32_t loop)
+ {
+ int32_t first,nch,frames,i;
+ uint16_t *table;
+
+ // Get channels
+ if (PstackPop(context,&nch)) return;
+ if (!getChannelNumber(context,&first)) return;
+ if ((nch<1)||((first+nch-1)>PWM_NLINES))
+      {
+	  consoleErrorMessage(context,"Invalid number of channels");
+	  return;
+      }
+
+ // Get table
+ if (!getTable(context,nch,&table,&frames)) return;
+
+ // The IMU service needs I2C1 and its DMA
+ if (imuIsRunning())
+      {
+	  consoleErrorMessage(context,"I2C1 DMA in use by the IMU service");
+	  return;
+      }
+
+ // Stop any previous stream
+ pwmStreamStop();
+
+ // Try to allocate the DMA
+ if (dmaStreamAllocate(PWM_DMA_STREAM,PWM_IRQ_PRIORITY,pwmDmaCallback,NULL))
+      {
+	  consoleErrorMessage(context,"PWM DMA is busy");
+	  return;
+      }
+ pwmDmaAllocated=1;
+
+ // Activate the channels with the first frame
+ pwmActivate();
+ for(i=0;i<nch;i++)
+	 pwmEnableChannel(&PWM_DRIVER,first-1+i,table[i]);
+
+ // Set stream data
+ pwmStream.Table=table;
+ pwmStream.Frames=frames;
+ pwmStream.First=first-1;
+ pwmStream.Channels=nch;
+ pwmStream.Pending=NULL;
+ pwmStream.Status=loop?PWMSS_LOOP:PWMSS_ONCE;
+
+ // DMA burst of nch registers from the first CCR
+ PWM_TIMER->DCR=((nch-1)<<8)|(PWM_DBA_CCR1+first-1);
+ pwmStreamDmaSet(table,frames,loop);
+
+ // CH1 DMA requests on update events
+ PWM_TIMER->CR2|=TIM_CR2_CCDS;
+ PWM_TIMER->DIER|=TIM_DIER_CC1DE;
+ }
+
 /****************** PUBLIC FUNCTIONS *********************/
 
 // Initializes the PWM module
@@ -100,12 +287,20 @@ void pwmModuleInit(void)
  pwmcfg.channels[3].callback=NULL;
  }
 
+// Gives non zero if a duty stream is using the DMA
+// A completed one shot stream has already released it
+int32_t pwmIsStreaming(void)
+ {
+ return pwmDmaAllocated;
+ }
+
 /****************** COMMAND FUNCTIONS *********************/
 
 // Generic PWM function
 int32_t pwmFunction(ContextType *context,int32_t value)
  {
  int32_t nch,number;
+ uint16_t *table;
 
  switch (value)
    {
@@ -132,6 +327,8 @@ int32_t pwmFunction(ContextType *context,int32_t value)
    case PWM_F_FREQ: // Change frequency ( ufreq -- )
 	   // Try to get frequency
 	   if (!getFreq(context,&number)) return 0;
+	   // Restarting the driver ends any stream
+	   pwmStreamStop();
 	   // Stop peripheral if activated
 	   if (pwmStatus==PWMS_ON)
 	           pwmStop(&PWM_DRIVER);
@@ -153,10 +350,48 @@ int32_t pwmFunction(ContextType *context,int32_t value)
 	   break;
 
    case PWM_F_STOP: // Stop all the PWM device
+	   pwmStreamStop();
 	   pwmStop(&PWM_DRIVER);
 	   pwmStatus=PWMS_OFF;
 	   break;
 
+   case PWM_F_SONCE: // Stream table once ( addr nframes uch1 nch -- )
+	   pwmStreamStart(context,0);
+	   break;
+
+   case PWM_F_SLOOP: // Stream table in a loop ( addr nframes uch1 nch -- )
+	   pwmStreamStart(context,1);
+	   break;
+
+   case PWM_F_STABLE: // Swap table at the end of the pass ( addr nframes -- )
+	   if (pwmStream.Status!=PWMSS_LOOP)
+	        {
+		    consoleErrorMessage(context,"No PWM loop stream running");
+		    return 0;
+	        }
+	   if (!getTable(context,pwmStream.Channels,&table,&number)) return 0;
+	   chSysLock();
+	   pwmStream.PendingFrames=number;
+	   pwmStream.Pending=table;
+	   chSysUnlock();
+	   break;
+
+   case PWM_F_SSTOP: // Stop streaming
+	   pwmStreamStop();
+	   break;
+
+   case PWM_F_SWAIT: // Wait one shot end or pending swap
+	   while ((pwmStream.Status==PWMSS_ONCE)||(pwmStream.Pending!=NULL))
+	       {
+		   if (PORT_ABORT)
+		        {
+			    runtimeErrorMessage(context,"PWM stream wait aborted");
+			    return 0;
+		        }
+		   chThdSleep(PWM_WAIT_POLL);
+	       }
+	   break;
+
    }
  return 0;
  }
@@ -18,6 +18,17 @@
 // Driver used
 #define PWM_DRIVER   PWMD3
 
+// Duty streaming hardware
+// The CH1 DMA request is generated on update events (CCDS)
+// and the DMA burst writes the selected CCR registers
+#define PWM_TIMER          TIM3
+#define PWM_DMA_STREAM     STM32_DMA1_STREAM6  // TIM3 CH1 DMA channel
+#define PWM_DMA_PRIORITY   2                   // DMA priority (0..3)
+#define PWM_IRQ_PRIORITY   6                   // DMA IRQ priority
+#define PWM_DBA_CCR1       13                  // CCR1 offset in timer registers
+#define PWM_MAX_TRANSFERS  65535               // DMA counter limit
+#define PWM_WAIT_POLL      10                  // Ticks between abort checks
+
 // Default PWM values
 #define PWM_DEF_FREQ	   10000   // 10 kHz
 #define PWM_DEF_PERIOD      1000   // 100ms (1000 clock cycles)
@@ -29,8 +40,28 @@
 #define PWMS_OFF	0 // Not used
 #define PWMS_ON	    1 // Active
 
+// Values of the duty streaming status
+#define PWMSS_STOP   0 // Not streaming
+#define PWMSS_ONCE   1 // One shot playback
+#define PWMSS_LOOP   2 // Circular playback
+#define PWMSS_DONE   3 // One shot playback completed
+
+// Duty streaming data
+typedef struct
+ {
+ uint16_t *Table;             // Current table
+ int32_t Frames;              // Frames in current table
+ int32_t First;               // First channel (0..2)
+ int32_t Channels;            // Channels in each frame
+ uint16_t *volatile Pending;  // Table to swap (or NULL)
+ volatile int32_t PendingFrames;
+ volatile int32_t Status;     // Streaming status
+ }
+ PwmStream;
+
 // Function prototypes
 void pwmModuleInit(void);
+int32_t pwmIsStreaming(void);
 
 // Command function prototypes
 int32_t pwmFunction(ContextType *context,int32_t value);
@@ -39,6 +70,11 @@ int32_t pwmFunction(ContextType *context,int32_t value);
 #define PWM_F_FREQ     3   // Set frequency
 #define PWM_F_PERIOD   4   // Set period
 #define PWM_F_STOP     5   // Stop the driver
+#define PWM_F_SONCE    6   // Stream duty table once
+#define PWM_F_SLOOP    7   // Stream duty table in a loop
+#define PWM_F_STABLE   8   // Swap streamed table
+#define PWM_F_SSTOP    9   // Stop streaming
+#define PWM_F_SWAIT   10   // Wait end of stream or table swap
 
 #endif  //_PWM_MODULE
 
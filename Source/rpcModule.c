@@ -0,0 +1,263 @@
+/*
+ rpcModule.c
+ Binary RPC mode source file
+
+ In RPC mode the console reads binary call frames instead of
+ text. Each call runs in its own context with a clean stack
+ and error messages disabled so nothing but responses is sent
+ to the console. Words called this way should not print
+
+ The mode ends with an exit frame or with the abort button
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_register.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "rpcModule.h"     // This module header
+
+// Console channel in console.c
+extern BaseChannel *Console_BC;
+
+// Context for the calls
+static ContextType RpcContext;
+
+// Frame buffer
+static uint8_t rpcFrame[8+4*RPC_MAX_CELLS];
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Reads n bytes from the console
+// Returns 0 on timeout
+static int32_t rpcRead(uint8_t *data,int32_t n)
+ {
+ return (chnReadTimeout(Console_BC,data,n,RPC_BYTE_TIMEOUT)==(size_t)n);
+ }
+
+// 8 bit sum of a buffer
+static uint8_t rpcSum(const uint8_t *data,int32_t n)
+ {
+ uint8_t sum=0;
+
+ while (n--) sum+=*(data++);
+ return sum;
+ }
+
+// Store a little endian word
+static void putWord(uint8_t *p,uint32_t data)
+ {
+ p[0]=data;
+ p[1]=data>>8;
+ p[2]=data>>16;
+ p[3]=data>>24;
+ }
+
+// Read a little endian word
+static uint32_t getWord(const uint8_t *p)
+ {
+ return p[0]|(p[1]<<8)|(p[2]<<16)|(((uint32_t)p[3])<<24);
+ }
+
+// Sends a response with the cells in the frame buffer
+static void rpcRespond(int32_t status,int32_t n)
+ {
+ rpcFrame[0]=RPC_SYNC_RESP;
+ rpcFrame[1]=status;
+ rpcFrame[2]=n;
+ rpcFrame[3+4*n]=rpcSum(rpcFrame+1,2+4*n);
+ chnWriteTimeout(Console_BC,rpcFrame,4+4*n,TIME_INFINITE);
+ }
+
+// Check if an execution token can be called by RPC
+// Calls are interactive so words that can only run
+// inside a definition are rejected
+// Returns 1 if it can be called
+static int32_t rpcCallable(uint16_t token)
+ {
+ if (!xtValid(token)) return 0;
+ if ((token&XT_BASE)&&(BaseDictionary[token&(~XT_BASE)].flags&DF_NI))
+	 return 0;
+ return 1;
+ }
+
+// Executes a token in the RPC context
+// Returns the RPC status
+static int32_t rpcExecute(uint16_t token)
+ {
+ int32_t pos;
+
+ if (!rpcCallable(token)) return RPC_ST_TOKEN;
+
+ if (token&XT_BASE)
+     {
+	 // Base dictionary word
+	 pos=token&(~XT_BASE);
+	 (BaseDictionary[pos].function)(&RpcContext,BaseDictionary[pos].argument);
+     }
+    else
+     // User dictionary word
+     programExecute(&RpcContext,token,1);
+
+ return RPC_ST_OK;
+ }
+
+// Process a call frame
+static void rpcCall(void)
+ {
+ int32_t nargs,nres,i,status,data;
+ uint32_t oldFlags;
+
+ // Rest of the header
+ if (!rpcRead(rpcFrame+1,4))
+     {
+	 rpcRespond(RPC_ST_FRAME,0);
+	 return;
+     }
+ nargs=rpcFrame[3];
+ nres=rpcFrame[4];
+ if ((nargs>RPC_MAX_CELLS)||(nres>RPC_MAX_CELLS))
+     {
+	 rpcRespond(RPC_ST_FRAME,0);
+	 return;
+     }
+
+ // Arguments and sum
+ if ((!rpcRead(rpcFrame+5,4*nargs+1))
+		 ||(rpcSum(rpcFrame,5+4*nargs)!=rpcFrame[5+4*nargs]))
+     {
+	 rpcRespond(RPC_ST_FRAME,0);
+	 return;
+     }
+
+ // Clean context with the arguments
+ PstackInit(&RpcContext);
+ RstackInit(&RpcContext);
+ clearContextAbort(&RpcContext);
+ for(i=0;i<nargs;i++)
+	 PstackPush(&RpcContext,(int32_t)getWord(rpcFrame+5+4*i));
+
+ // Execute it keeping the interpreter error flag
+ oldFlags=MainFlags;
+ MainFlags&=~MFLAG_IERROR;
+ status=rpcExecute(rpcFrame[1]|(rpcFrame[2]<<8));
+ if ((status==RPC_ST_OK)
+		 &&(((RpcContext.Flags)&CFLAG_ABORT)||(MainFlags&MFLAG_IERROR)))
+	 status=RPC_ST_ERROR;
+ MainFlags=(MainFlags&(~MFLAG_IERROR))|(oldFlags&MFLAG_IERROR);
+
+ // Results
+ if (status!=RPC_ST_OK) nres=0;
+ if (PstackGetSize(&RpcContext)<nres)
+     {
+	 status=RPC_ST_STACK;
+	 nres=PstackGetSize(&RpcContext);
+     }
+ for(i=nres-1;i>=0;i--)
+     {
+	 PstackPop(&RpcContext,&data);
+	 putWord(rpcFrame+3+4*i,data);
+     }
+
+ rpcRespond(status,nres);
+ }
+
+// RPC mode loop
+static void rpcMode(void)
+ {
+ msg_t data;
+
+ while (1)
+    {
+	// Wait for a sync byte
+	data=chnGetTimeout(Console_BC,RPC_WAIT_POLL);
+	if (PORT_ABORT) return;
+	if (data!=RPC_SYNC_REQ) continue;
+
+	// Command
+	data=chnGetTimeout(Console_BC,RPC_BYTE_TIMEOUT);
+	if (data<0) continue;
+	rpcFrame[0]=data;
+
+	switch (data)
+	    {
+	    case RPC_CMD_CALL:
+	    	rpcCall();
+	    	break;
+
+	    case RPC_CMD_PING:
+	    case RPC_CMD_EXIT:
+	    	if ((!rpcRead(rpcFrame+1,1))||(rpcFrame[1]!=rpcFrame[0]))
+	    	    {
+	    		rpcRespond(RPC_ST_FRAME,0);
+	    		break;
+	    	    }
+	    	rpcRespond(RPC_ST_OK,0);
+	    	if (data==RPC_CMD_EXIT) return;
+	    	break;
+
+	    default:
+	    	rpcRespond(RPC_ST_FRAME,0);
+	    }
+    }
+ }
+
+// Gives the token of the next word in the line
+// Returns 0 if not found
+static int32_t rpcToken(ContextType *context,int32_t *token)
+ {
+ uint16_t xt;
+
+ xt=xtLocate(tokenGet());
+ if ((xt==NO_WORD)||(!rpcCallable(xt)))
+     {
+	 consoleErrorMessage(context,"Word cannot be called by RPC");
+	 return 0;
+     }
+
+ (*token)=xt;
+ return 1;
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void rpcModuleInit(void)
+ {
+ // Calls context
+ RpcContext.Process=FOREGROUND;
+ RpcContext.VerboseLevel=0;
+ RpcContext.Flags=0;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic RPC function
+int32_t rpcFunction(ContextType *context,int32_t value)
+ {
+ int32_t token;
+
+ switch (value)
+     {
+     case RPC_F_MODE: // Enter binary RPC mode
+    	 rpcMode();
+    	 break;
+
+     case RPC_F_TOKEN: // Token of a word ( -- token )
+    	 if (!rpcToken(context,&token)) return 0;
+    	 PstackPush(context,token);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in rpcFunction");
+     }
+
+ return 0;
+ }
+
@@ -0,0 +1,55 @@
+/*
+ rpcModule.h
+ Binary RPC mode header file
+
+ Lets a host call words with binary frames on the console
+
+ Request frame (little endian):
+    0xA5      1 byte    Sync
+    cmd       1 byte    'C' call, 'P' ping, 'X' exit RPC mode
+ For calls:
+    token     2 bytes   Execution token given by RpcToken or '
+    nargs     1 byte    Number of argument cells
+    nres      1 byte    Number of result cells
+    args      4*nargs   Argument cells, deepest first
+ All requests:
+    sum       1 byte    8 bit sum of all bytes after sync
+
+ Response frame:
+    0x5A      1 byte    Sync
+    status    1 byte    RPC_ST_ code
+    n         1 byte    Number of result cells
+    results   4*n       Result cells, deepest first
+    sum       1 byte    8 bit sum of all bytes after sync
+ */
+
+#ifndef _RPC_MODULE
+#define _RPC_MODULE
+
+// Frame definitions
+#define RPC_SYNC_REQ      0xA5
+#define RPC_SYNC_RESP     0x5A
+#define RPC_CMD_CALL      'C'
+#define RPC_CMD_PING      'P'
+#define RPC_CMD_EXIT      'X'
+#define RPC_MAX_CELLS     16      // Max arguments or results
+#define RPC_BYTE_TIMEOUT  100     // Max ticks between frame bytes
+#define RPC_WAIT_POLL     10      // Ticks between abort checks
+
+// Response status
+#define RPC_ST_OK         0   // Call executed
+#define RPC_ST_FRAME      1   // Bad frame
+#define RPC_ST_TOKEN      2   // Invalid token
+#define RPC_ST_ERROR      3   // Word ended with an error
+#define RPC_ST_STACK      4   // Less results than requested
+
+// Function prototypes
+void rpcModuleInit(void);
+
+// Command functions
+int32_t rpcFunction(ContextType *context,int32_t value);
+#define RPC_F_MODE        0   // Enter binary RPC mode
+#define RPC_F_TOKEN       1   // Token of a word
+
+#endif // _RPC_MODULE
+
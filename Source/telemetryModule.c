@@ -0,0 +1,325 @@
+/*
+ telemetryModule.c
+ Binary telemetry source file
+
+ Producers copy records in the word ring with the system
+ locked only for the copy. The thread is the only consumer
+ so it reads the ring without locking
+
+ Ring record: header word (id | n<<8), timestamp, n cells
+
+ The thread frames all pending records in a buffer and sends
+ it with one write so the channel is used in bulk
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"            // Main include for the project
+#include "console.h"          // Console streams
+#include "timeModule.h"       // Microsecond clock
+#include "uartModule.h"       // UART data port
+#include "usbDataModule.h"    // USB binary data channel
+#include "telemetryModule.h"  // This module header
+
+// Console stream in console.c
+extern BaseSequentialStream *Console_BSS;
+
+// Thread working area
+static WORKING_AREA(waTelemetryThread,TEL_THREAD_WA);
+
+// Record ring
+static uint32_t telRing[TEL_RING_SIZE];
+static volatile uint32_t telHead=0;   // Written by producers
+static volatile uint32_t telTail=0;   // Written by the thread
+
+// Counters
+static volatile uint32_t telLost=0;
+static volatile uint32_t telCount=0;
+
+// Destination or -1 if stopped
+static volatile int32_t telDest=-1;
+
+// Thread busy sending the output buffer
+static volatile int32_t telSending=0;
+
+// Thread wake semaphore
+static BinarySemaphore TelemetrySem;
+
+// Thread buffers
+static uint8_t telFrame[TEL_MAX_FRAME];
+static uint8_t telOut[TEL_OUT_SIZE];
+
+// CRC-16/CCITT table for one nibble
+static const uint16_t crcNibble[16]={
+		0x0000,0x1021,0x2042,0x3063,0x4084,0x50A5,0x60C6,0x70E7,
+		0x8108,0x9129,0xA14A,0xB16B,0xC18C,0xD1AD,0xE1CE,0xF1EF };
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Update a CRC with one byte
+static uint16_t crcByte(uint16_t crc,uint8_t data)
+ {
+ crc=(crc<<4)^crcNibble[(crc>>12)^(data>>4)];
+ crc=(crc<<4)^crcNibble[(crc>>12)^(data&0x0F)];
+ return crc;
+ }
+
+// Store a little endian word in the frame
+static int32_t putWord(uint8_t *p,uint32_t data)
+ {
+ p[0]=data;
+ p[1]=data>>8;
+ p[2]=data>>16;
+ p[3]=data>>24;
+ return 4;
+ }
+
+// COBS encode the frame and add the delimiter
+// Returns the number of bytes written in out
+static int32_t cobsEncode(const uint8_t *in,int32_t n,uint8_t *out)
+ {
+ int32_t code=0,pos=1,i;
+
+ for(i=0;i<n;i++)
+	 {
+	 if (in[i])
+	     {
+		 out[pos++]=in[i];
+		 if ((pos-code)<0xFF) continue;
+	     }
+	 // End of block
+	 out[code]=pos-code;
+	 code=pos++;
+	 }
+ out[code]=pos-code;
+ out[pos++]=0;
+
+ return pos;
+ }
+
+// Takes one record from the ring and frames it in out
+// Returns the number of bytes written in out
+static int32_t frameRecord(uint8_t *out)
+ {
+ uint32_t header,tail;
+ int32_t n,i,size;
+ uint16_t crc;
+
+ tail=telTail;
+ header=telRing[(tail++)&(TEL_RING_SIZE-1)];
+ n=(header>>8)&0xFF;
+
+ // Record contents
+ telFrame[0]=header;
+ telFrame[1]=n;
+ size=2+putWord(telFrame+2,telRing[(tail++)&(TEL_RING_SIZE-1)]);
+ for(i=0;i<n;i++)
+	 size+=putWord(telFrame+size,telRing[(tail++)&(TEL_RING_SIZE-1)]);
+ telTail=tail;
+
+ // CRC
+ crc=TEL_CRC_INIT;
+ for(i=0;i<size;i++)
+	 crc=crcByte(crc,telFrame[i]);
+ telFrame[size++]=crc;
+ telFrame[size++]=crc>>8;
+
+ return cobsEncode(telFrame,size,out);
+ }
+
+// Sends the output buffer to the destination
+static void telWrite(int32_t n)
+ {
+ switch (telDest)
+     {
+     case TEL_DEST_CONSOLE:
+    	 chSequentialStreamWrite(Console_BSS,telOut,n);
+    	 break;
+     case TEL_DEST_USB:
+    	 usbDataSend(telOut,n);
+    	 break;
+     case TEL_DEST_UART:
+    	 uartSend(telOut,n);
+    	 break;
+     }
+ }
+
+// Telemetry thread
+static msg_t telemetryThread(void *arg)
+ {
+ int32_t n;
+
+ UNUSED(arg);
+
+ while (1)
+    {
+	chBSemWait(&TelemetrySem);
+
+	// Frame all the pending records
+	while (telTail!=telHead)
+	   {
+	   telSending=1;
+	   n=0;
+	   while ((telTail!=telHead)&&((n+TEL_MAX_FRAME)<=TEL_OUT_SIZE))
+	       {
+		   n+=frameRecord(telOut+n);
+		   telCount++;
+	       }
+	   if (telDest>=0) telWrite(n);
+	   }
+	telSending=0;
+    }
+
+ return 0;
+ }
+
+// Append the record on the stack ( x1..xn n uid -- )
+static void telSend(ContextType *context)
+ {
+ int32_t id,n,i;
+ int32_t cells[TEL_MAX_CELLS];
+
+ if (PstackPop(context,&id)) return;
+ if (PstackPop(context,&n)) return;
+
+ if ((id<0)||(id>255))
+      {
+	  consoleErrorMessage(context,"Invalid telemetry id");
+	  return;
+      }
+ if ((n<0)||(n>TEL_MAX_CELLS))
+      {
+	  consoleErrorMessage(context,"Invalid number of cells");
+	  return;
+      }
+
+ for(i=n-1;i>=0;i--)
+	 if (PstackPop(context,cells+i)) return;
+
+ if (telDest<0)
+      {
+	  consoleErrorMessage(context,"Telemetry not started");
+	  return;
+      }
+
+ telemetryAppend(id,n,cells);
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void telemetryModuleInit(void)
+ {
+ chBSemInit(&TelemetrySem,TRUE);
+ chThdCreateStatic(waTelemetryThread,sizeof(waTelemetryThread)
+		          ,TEL_THREAD_PRIO,telemetryThread,NULL);
+ }
+
+// Append a record to the ring
+// Can be called from any thread
+// Returns 0 if the ring is full
+int32_t telemetryAppend(int32_t id,int32_t n,const int32_t *cells)
+ {
+ uint32_t head,time;
+ int32_t i;
+
+ time=timeMicros();
+
+ chSysLock();
+
+ // Check space
+ head=telHead;
+ if ((TEL_RING_SIZE-(head-telTail))<(uint32_t)(n+2))
+     {
+	 telLost++;
+	 chSysUnlock();
+	 return 0;
+     }
+
+ // Copy the record
+ telRing[(head++)&(TEL_RING_SIZE-1)]=(id&0xFF)|(n<<8);
+ telRing[(head++)&(TEL_RING_SIZE-1)]=time;
+ for(i=0;i<n;i++)
+	 telRing[(head++)&(TEL_RING_SIZE-1)]=cells[i];
+ telHead=head;
+
+ chBSemSignalI(&TelemetrySem);
+ chSchRescheduleS();
+ chSysUnlock();
+
+ return 1;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic telemetry function
+int32_t telemetryFunction(ContextType *context,int32_t value)
+ {
+ int32_t data;
+
+ switch (value)
+     {
+     case TEL_F_START: // Start sending ( udest -- )
+    	 if (PstackPop(context,&data)) return 0;
+    	 if ((data<0)||(data>=TEL_NDEST))
+    	      {
+    		  consoleErrorMessage(context,"Invalid telemetry destination");
+    		  return 0;
+    	      }
+    	 if ((data==TEL_DEST_USB)&&(!usbDataReady()))
+    	      {
+    		  consoleErrorMessage(context,"USB data channel not connected");
+    		  return 0;
+    	      }
+    	 if ((data==TEL_DEST_UART)&&(!uartIsOpen()))
+    	      {
+    		  consoleErrorMessage(context,"UART port not open");
+    		  return 0;
+    	      }
+    	 telLost=0;
+    	 telCount=0;
+    	 telDest=data;
+    	 break;
+
+     case TEL_F_STOP: // Stop sending
+    	 telDest=-1;
+    	 break;
+
+     case TEL_F_SEND: // Append a record ( x1..xn n uid -- )
+    	 telSend(context);
+    	 break;
+
+     case TEL_F_WAIT: // Wait until all records are sent
+    	 while ((telTail!=telHead)||telSending)
+    	     {
+    		 if (PORT_ABORT)
+    		      {
+    			  runtimeErrorMessage(context,"Telemetry wait aborted");
+    			  return 0;
+    		      }
+    		 chThdSleep(TEL_WAIT_POLL);
+    	     }
+    	 break;
+
+     case TEL_F_LOST: // Lost records ( -- n )
+    	 PstackPush(context,(int32_t)telLost);
+    	 break;
+
+     case TEL_F_COUNT: // Sent records ( -- n )
+    	 PstackPush(context,(int32_t)telCount);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in telemetryFunction");
+     }
+
+ return 0;
+ }
+
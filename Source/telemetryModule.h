@@ -0,0 +1,54 @@
+/*
+ telemetryModule.h
+ Binary telemetry header file
+
+ Records are appended to a ring and a background thread sends
+ them framed to the selected channel
+
+ Frame contents before encoding (little endian):
+    id        1 byte    Record channel id
+    n         1 byte    Number of cells
+    time      4 bytes   Timestamp in us
+    cells     4*n bytes Cell values
+    crc       2 bytes   CRC-16/CCITT-FALSE of all previous bytes
+
+ Each frame is COBS encoded and ends with a zero byte
+ */
+
+#ifndef _TELEMETRY_MODULE
+#define _TELEMETRY_MODULE
+
+// Destinations
+#define TEL_DEST_CONSOLE   0   // Current console channel
+#define TEL_DEST_USB       1   // USB binary data channel
+#define TEL_DEST_UART      2   // UART data port
+#define TEL_NDEST          3
+
+// Module definitions
+#define TEL_RING_SIZE      1024           // Ring size in words (power of 2)
+#define TEL_MAX_CELLS      16             // Max cells in a record
+#define TEL_OUT_SIZE       512            // Thread output buffer
+#define TEL_MAX_FRAME      80             // Max encoded frame with delimiter
+#define TEL_THREAD_WA      512            // Thread working area
+#define TEL_THREAD_PRIO    NORMALPRIO     // As the console so records batch
+#define TEL_WAIT_POLL      10             // Ticks between abort checks
+
+// CRC definitions
+#define TEL_CRC_INIT       0xFFFF
+#define TEL_CRC_POLY       0x1021
+
+// Function prototypes
+void telemetryModuleInit(void);
+int32_t telemetryAppend(int32_t id,int32_t n,const int32_t *cells);
+
+// Command functions
+int32_t telemetryFunction(ContextType *context,int32_t value);
+#define TEL_F_START       0   // Start sending to a destination
+#define TEL_F_STOP        1   // Stop sending
+#define TEL_F_SEND        2   // Append a record
+#define TEL_F_WAIT        3   // Wait until all records are sent
+#define TEL_F_LOST        4   // Records lost with the ring full
+#define TEL_F_COUNT       5   // Records sent
+
+#endif // _TELEMETRY_MODULE
+
@@ -20,6 +20,15 @@
 // GPT configurations for TIM6 and TIM7 ( Timers 1 and 2 )
 GenTimer gpt[N_GPT];
 
+// Microsecond clock state
+// Cycles are accumulated in 64 bits so the 32 bit
+// cycle counter only needs to be read once every 59s
+// A virtual timer reads it periodically so idle gaps
+// longer than that are not lost
+static uint32_t MicroLastCycles=0;
+static uint64_t MicroCycles=0;
+static VirtualTimer MicroTimer;
+
 /*********************** STATIC FUNCTIONS *****************************/
 
 // Callbacks execute in their own interrupt context
@@ -42,6 +51,17 @@ static void gptCallback2(GPTDriver *driver)
  programExecute(&InterruptContext,gpt[1].Word,0);
  }
 
+// Microsecond clock update virtual timer callback
+// Executes locked in the system tick interrupt
+static void microTimerCallback(void *p)
+ {
+ UNUSED(p);
+
+ timeMicrosI();
+
+ chVTSetI(&MicroTimer,MS2ST(TIME_MICRO_UPDATE),microTimerCallback,NULL);
+ }
+
 // General Timer Initializations
 static void initGPT(void)
  {
@@ -127,6 +147,16 @@ void timeInit(void)
  {
  // Init global timers
  initGPT();
+
+ // Start the DWT cycle counter for the microsecond clock
+ CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;
+ DWT->CYCCNT=0;
+ DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;
+
+ // Count the cycle counter wraps
+ chSysLock();
+ chVTSetI(&MicroTimer,MS2ST(TIME_MICRO_UPDATE),microTimerCallback,NULL);
+ chSysUnlock();
  }
 
 // Try to get frequency from the stack
@@ -163,6 +193,32 @@ int32_t isAnyTimerCallback(void)
  return any;
  }
 
+// Microseconds since start (I-Class)
+// Must be called from a locked state or an ISR
+uint32_t timeMicrosI(void)
+ {
+ uint32_t now;
+
+ // Accumulate elapsed cycles
+ now=DWT->CYCCNT;
+ MicroCycles+=(uint32_t)(now-MicroLastCycles);
+ MicroLastCycles=now;
+
+ return (uint32_t)(MicroCycles/TIME_CPU_MHZ);
+ }
+
+// Microseconds since start
+uint32_t timeMicros(void)
+ {
+ uint32_t value;
+
+ chSysLock();
+ value=timeMicrosI();
+ chSysUnlock();
+
+ return value;
+ }
+
 /*********************** COMMAND FUNCTIONS ***************************/
 
 // Basic generic time function
@@ -267,6 +323,10 @@ int32_t timeFunction(ContextType *context,int32_t value)
 
     	 break;
 
+     case TIME_F_MICROS: // Microseconds since start ( -- us )
+    	 PstackPush(context,(int32_t)timeMicros());
+    	 break;
+
      default:
     	 DEBUG_MESSAGE("Cannot arrive to default in timeFunction");
      }
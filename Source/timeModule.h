@@ -15,6 +15,10 @@
 #define TIM_MIN_FREQ      1100        //Preescaler limit
 #define TIM_MAX_INTERVAL  65535       //16 bit counter
 
+// Microsecond clock defines
+#define TIME_CPU_MHZ      72          // DWT cycle counter frequency in MHz
+#define TIME_MICRO_UPDATE 10000       // Clock update period in ms (wrap is 59.6s)
+
 // Timer structure data
 typedef struct
  {
@@ -33,6 +37,8 @@ typedef struct
 void timeInit(void);
 int32_t getFreq(ContextType *context,int32_t *freq);
 int32_t isAnyTimerCallback(void);
+uint32_t timeMicros(void);
+uint32_t timeMicrosI(void);
 
 // Command functions
 int32_t timeFunction(ContextType *context,int32_t value);
@@ -47,6 +53,7 @@ int32_t timeFunction(ContextType *context,int32_t value);
 //#define  TIME_F_STOP         8
 //#define  TIME_F_INTERVAL     9
 //#define  TIME_F_START       10
+#define  TIME_F_MICROS      11
 
 
 #endif // _TIME_MODULE
@@ -0,0 +1,550 @@
+/*
+ uartModule.c
+ UART data port source file
+
+ USART1 is a data port for user programs. The console keeps
+ using USART2 or the USB
+
+ RX: circular DMA into the RX ring. The received byte count is
+ updated from the DMA counter in the DMA half and full interrupts
+ and in the USART idle and character match interrupts so it
+ never misses a ring turn. Waiting threads are woken when a
+ line delimiter arrives or the line goes idle after a frame
+
+ TX: bytes are copied in the TX ring and the DMA sends the
+ contiguous part pending. The transfer complete interrupt
+ starts the next part
+
+ DMA1 Channels 4 and 5 are also used by the I2C2 driver so the
+ I2C2 bus cannot be used while the port is open. DMA1 Channel 5
+ is also used by the input capture so the port cannot be opened
+ while a capture measurement runs and the other way round
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "uartModule.h"    // This module header
+
+// Rings
+static uint8_t uartRxRing[UART_RX_SIZE];
+static uint8_t uartTxRing[UART_TX_SIZE];
+
+// RX state
+static uint32_t uartRxLastPos=0;              // Last DMA position seen
+static volatile uint32_t uartRxTotal=0;       // Total bytes received
+static volatile uint32_t uartRxFrame=0;       // Total at last idle line
+static uint32_t uartRxRead=0;                 // Total bytes read
+static uint32_t uartRxLost=0;                 // Bytes overwritten
+static BinarySemaphore UartRxSem;             // Wakes RX waiters
+
+// TX state
+static volatile uint32_t uartTxHead=0;        // Total bytes written
+static volatile uint32_t uartTxTail=0;        // Total bytes sent
+static volatile uint32_t uartTxBusy=0;        // Bytes in DMA transfer
+static BinarySemaphore UartTxSem;             // Wakes TX writers
+static Mutex UartTxMutex;                     // Serializes TX writers
+
+// Line delimiter
+static int32_t uartDelim=UART_NO_DELIM;
+
+// Open flag
+static int32_t uartOpen=0;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Updates the received byte count (I-Class)
+// Must be called at least once each half ring
+static void uartRxUpdateI(void)
+ {
+ uint32_t pos;
+
+ pos=UART_RX_SIZE-dmaStreamGetTransactionSize(UART_RX_DMA_STREAM);
+ uartRxTotal+=(pos-uartRxLastPos)&(UART_RX_SIZE-1);
+ uartRxLastPos=pos;
+ }
+
+// Starts the next TX transfer if there are bytes pending (I-Class)
+// The port must be open as the DMA is released on close
+static void uartTxStartI(void)
+ {
+ uint32_t pending,start;
+
+ if ((!uartOpen)||uartTxBusy) return;
+
+ pending=uartTxHead-uartTxTail;
+ if (!pending) return;
+
+ // Contiguous part of the ring
+ start=uartTxTail&(UART_TX_SIZE-1);
+ if (pending>(UART_TX_SIZE-start)) pending=UART_TX_SIZE-start;
+
+ uartTxBusy=pending;
+ dmaStreamSetMemory0(UART_TX_DMA_STREAM,uartTxRing+start);
+ dmaStreamSetTransactionSize(UART_TX_DMA_STREAM,pending);
+ dmaStreamSetMode(UART_TX_DMA_STREAM,STM32_DMA_CR_DIR_M2P|STM32_DMA_CR_MINC
+		          |STM32_DMA_CR_PSIZE_BYTE|STM32_DMA_CR_MSIZE_BYTE
+		          |STM32_DMA_CR_TCIE|STM32_DMA_CR_PL(UART_DMA_PRIORITY));
+ dmaStreamEnable(UART_TX_DMA_STREAM);
+ }
+
+// RX DMA interrupt callback
+static void uartRxDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+ UNUSED(flags);
+
+ chSysLockFromIsr();
+ uartRxUpdateI();
+ chBSemSignalI(&UartRxSem);
+ chSysUnlockFromIsr();
+ }
+
+// TX DMA interrupt callback
+static void uartTxDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+
+ if (!(flags&STM32_DMA_ISR_TCIF)) return;
+
+ chSysLockFromIsr();
+ dmaStreamDisable(UART_TX_DMA_STREAM);
+ uartTxTail+=uartTxBusy;
+ uartTxBusy=0;
+ uartTxStartI();
+ chBSemSignalI(&UartTxSem);
+ chSysUnlockFromIsr();
+ }
+
+// Program the baud rate register
+// Returns 0 if the rate cannot be obtained
+static int32_t uartSetBaud(uint32_t baud)
+ {
+ uint32_t div;
+
+ // Oversampling by 16 if possible
+ div=(UART_CLOCK+baud/2)/baud;
+ if (div>=16)
+     {
+	 UART_USART->CR1&=~USART_CR1_OVER8;
+	 UART_USART->BRR=div;
+	 return 1;
+     }
+
+ // Oversampling by 8
+ div=(2*UART_CLOCK+baud/2)/baud;
+ if (div<16) return 0;
+ UART_USART->CR1|=USART_CR1_OVER8;
+ UART_USART->BRR=(div&0xFFF0)|((div&0xF)>>1);
+ return 1;
+ }
+
+// Closes the port
+static void uartClose(void)
+ {
+ if (!uartOpen) return;
+
+ nvicDisableVector(UART_IRQ_NUMBER);
+ UART_USART->CR1=0;
+ UART_USART->CR3=0;
+
+ // The flag is checked locked before any TX start
+ // so no writer arms the DMA after it is released
+ chSysLock();
+ uartOpen=0;
+ dmaStreamDisable(UART_RX_DMA_STREAM);
+ dmaStreamDisable(UART_TX_DMA_STREAM);
+ dmaStreamRelease(UART_RX_DMA_STREAM);
+ dmaStreamRelease(UART_TX_DMA_STREAM);
+ chSysUnlock();
+ }
+
+// Opens the port ( ubaud udelim -- )
+static void uartOpenPort(ContextType *context)
+ {
+ int32_t baud,delim;
+
+ // Get parameters
+ if (PstackPop(context,&delim)) return;
+ if (PstackPop(context,&baud)) return;
+
+ // Check them
+ if ((baud<UART_MIN_BAUD)||(baud>UART_MAX_BAUD))
+      {
+	  consoleErrorMessage(context,"Invalid baud rate");
+	  return;
+      }
+ if ((delim<UART_NO_DELIM)||(delim>255))
+      {
+	  consoleErrorMessage(context,"Invalid delimiter");
+	  return;
+      }
+
+ // Reopen if open
+ uartClose();
+
+ // Try to allocate the DMA
+ // RX fails while an input capture is running as it
+ // also uses DMA1 Channel 5
+ if (dmaStreamAllocate(UART_RX_DMA_STREAM,UART_IRQ_PRIORITY,uartRxDmaCallback,NULL))
+      {
+	  consoleErrorMessage(context,"UART RX DMA is busy (capture running?)");
+	  return;
+      }
+ if (dmaStreamAllocate(UART_TX_DMA_STREAM,UART_IRQ_PRIORITY,uartTxDmaCallback,NULL))
+      {
+	  dmaStreamRelease(UART_RX_DMA_STREAM);
+	  consoleErrorMessage(context,"UART TX DMA is busy");
+	  return;
+      }
+
+ // Clear the state
+ uartRxLastPos=0;
+ uartRxTotal=0;
+ uartRxFrame=0;
+ uartRxRead=0;
+ uartRxLost=0;
+ uartTxHead=0;
+ uartTxTail=0;
+ uartTxBusy=0;
+ uartDelim=delim;
+ chBSemReset(&UartRxSem,TRUE);
+ chBSemReset(&UartTxSem,TRUE);
+
+ // USART configuration
+ UART_USART->CR1=0;
+ if (!uartSetBaud(baud))
+      {
+	  dmaStreamRelease(UART_RX_DMA_STREAM);
+	  dmaStreamRelease(UART_TX_DMA_STREAM);
+	  consoleErrorMessage(context,"Invalid baud rate");
+	  return;
+      }
+ UART_USART->CR2=(delim==UART_NO_DELIM)?0:(((uint32_t)delim)<<24);
+ UART_USART->CR3=USART_CR3_DMAR|USART_CR3_DMAT|USART_CR3_OVRDIS;
+ UART_USART->ICR=0xFFFFFFFF;
+
+ // RX circular DMA
+ dmaStreamSetPeripheral(UART_RX_DMA_STREAM,&(UART_USART->RDR));
+ dmaStreamSetMemory0(UART_RX_DMA_STREAM,uartRxRing);
+ dmaStreamSetTransactionSize(UART_RX_DMA_STREAM,UART_RX_SIZE);
+ dmaStreamSetMode(UART_RX_DMA_STREAM,STM32_DMA_CR_DIR_P2M|STM32_DMA_CR_MINC
+		          |STM32_DMA_CR_PSIZE_BYTE|STM32_DMA_CR_MSIZE_BYTE
+		          |STM32_DMA_CR_CIRC|STM32_DMA_CR_HTIE|STM32_DMA_CR_TCIE
+		          |STM32_DMA_CR_PL(UART_DMA_PRIORITY));
+ dmaStreamEnable(UART_RX_DMA_STREAM);
+
+ // TX DMA peripheral
+ dmaStreamSetPeripheral(UART_TX_DMA_STREAM,&(UART_USART->TDR));
+
+ // Enable the USART with idle and character match interrupts
+ UART_USART->CR1|=USART_CR1_IDLEIE|USART_CR1_TE|USART_CR1_RE|USART_CR1_UE;
+ if (delim!=UART_NO_DELIM) UART_USART->CR1|=USART_CR1_CMIE;
+ nvicEnableVector(UART_IRQ_NUMBER,CORTEX_PRIORITY_MASK(UART_IRQ_PRIORITY));
+
+ uartOpen=1;
+ }
+
+// Copies received bytes to user memory
+// Returns the number of bytes copied
+static int32_t uartCopy(uint8_t *buffer,int32_t n)
+ {
+ int32_t i;
+
+ for(i=0;i<n;i++)
+	 buffer[i]=uartRxRing[(uartRxRead++)&(UART_RX_SIZE-1)];
+
+ return n;
+ }
+
+// Gives the number of bytes available to read
+// Old bytes overwritten by the DMA are lost
+static int32_t uartAvailable(void)
+ {
+ uint32_t avail;
+
+ chSysLock();
+ uartRxUpdateI();
+ avail=uartRxTotal-uartRxRead;
+ if (avail>UART_RX_SIZE)
+     {
+	 uartRxLost+=avail-UART_RX_SIZE;
+	 uartRxRead=uartRxTotal-UART_RX_SIZE;
+	 avail=UART_RX_SIZE;
+     }
+ chSysUnlock();
+
+ return (int32_t)avail;
+ }
+
+// Try to get a buffer from the stack ( addr n -- )
+// Returns 0 on error
+static int32_t getBuffer(ContextType *context,uint8_t **buffer,int32_t *n)
+ {
+ int32_t addr;
+
+ if (PstackPop(context,n)) return 0;
+ if (PstackPop(context,&addr)) return 0;
+
+ if (((*n)<1)||(!portUserBuffer((uint32_t)addr,*n)))
+      {
+	  consoleErrorMessage(context,"Invalid buffer");
+	  return 0;
+      }
+
+ (*buffer)=(uint8_t*)addr;
+ return 1; // Ok
+ }
+
+// Check that the port is open
+// Returns 0 if not
+static int32_t checkOpen(ContextType *context)
+ {
+ if (!uartOpen)
+      {
+	  consoleErrorMessage(context,"UART port not open");
+	  return 0;
+      }
+ return 1;
+ }
+
+// Write a buffer ( addr n -- )
+static void uartWrite(ContextType *context)
+ {
+ uint8_t *buffer;
+ int32_t n;
+
+ if (!getBuffer(context,&buffer,&n)) return;
+ if (!checkOpen(context)) return;
+
+ if (uartSend(buffer,n)<n)
+	 runtimeErrorMessage(context,"UART write aborted");
+ }
+
+// Wait for received data ( addr n ums -- nread )
+// In line mode ends after the delimiter
+// In frame mode ends at the last idle line
+static void uartWaitData(ContextType *context,int32_t line)
+ {
+ uint8_t *buffer;
+ int32_t n,timeout,avail,count,i;
+ systime_t start;
+
+ if (PstackPop(context,&timeout)) return;
+ if (!getBuffer(context,&buffer,&n)) return;
+ if (!checkOpen(context)) return;
+ if (line&&(uartDelim==UART_NO_DELIM))
+      {
+	  consoleErrorMessage(context,"UART port without delimiter");
+	  return;
+      }
+
+ start=chTimeNow();
+ while (1)
+    {
+	avail=uartAvailable();
+	count=0;
+
+	if (line)
+	    {
+		// Search the delimiter
+		for(i=0;(i<avail)&&(i<n);i++)
+			if (uartRxRing[(uartRxRead+i)&(UART_RX_SIZE-1)]==uartDelim)
+			    {
+				count=i+1;
+				break;
+			    }
+	    }
+	   else
+	    {
+	    // Bytes up to the last idle line
+	    i=(int32_t)(uartRxFrame-uartRxRead);
+	    if ((i>0)&&(i<=avail)) count=i;
+	    }
+
+	// Full buffer also ends the wait
+	if ((!count)&&(avail>=n)) count=n;
+	if (count>n) count=n;
+
+	if (count)
+	    {
+		PstackPush(context,uartCopy(buffer,count));
+		return;
+	    }
+
+	// Check timeout
+	if ((timeout>=0)&&((int32_t)(chTimeNow()-start)>=timeout))
+	    {
+		PstackPush(context,0);
+		return;
+	    }
+
+	// Check abort
+	if (PORT_ABORT)
+	    {
+		runtimeErrorMessage(context,"UART wait aborted");
+		return;
+	    }
+
+	chBSemWaitTimeout(&UartRxSem,UART_WAIT_POLL);
+    }
+ }
+
+/*********************** INTERRUPT FUNCTIONS *************************/
+
+// USART1 interrupt
+// Idle line and character match wake the RX waiters
+CH_IRQ_HANDLER(STM32_USART1_HANDLER)
+ {
+ uint32_t isr;
+
+ CH_IRQ_PROLOGUE();
+
+ isr=UART_USART->ISR;
+ UART_USART->ICR=USART_ICR_IDLECF|USART_ICR_CMCF|USART_ICR_ORECF
+		        |USART_ICR_FECF|USART_ICR_NCF|USART_ICR_PECF;
+
+ chSysLockFromIsr();
+ uartRxUpdateI();
+ if (isr&USART_ISR_IDLE) uartRxFrame=uartRxTotal;
+ chBSemSignalI(&UartRxSem);
+ chSysUnlockFromIsr();
+
+ CH_IRQ_EPILOGUE();
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void uartModuleInit(void)
+ {
+ chBSemInit(&UartRxSem,TRUE);
+ chBSemInit(&UartTxSem,TRUE);
+ chMtxInit(&UartTxMutex);
+
+ // USART1 clock and pins
+ rccEnableUSART1(FALSE);
+ palSetPadMode(SERIAL1_PORT,SERIAL1_TX_PIN,PAL_MODE_ALTERNATE(7));
+ palSetPadMode(SERIAL1_PORT,SERIAL1_RX_PIN,PAL_MODE_ALTERNATE(7));
+ }
+
+// Send a buffer
+// The telemetry thread and the Forth words can send
+// at the same time so the writers take a mutex
+// Returns the number of bytes queued that is less
+// than n on abort or if the port is closed
+int32_t uartSend(const uint8_t *buffer,int32_t n)
+ {
+ int32_t i;
+
+ chMtxLock(&UartTxMutex);
+
+ i=0;
+ while (uartOpen&&(i<n))
+    {
+	// Copy while there is space in the ring
+	// The byte is stored before the head is published
+	// as the DMA interrupt reads the head
+	while ((i<n)&&((uartTxHead-uartTxTail)<UART_TX_SIZE))
+	    {
+		uartTxRing[uartTxHead&(UART_TX_SIZE-1)]=buffer[i++];
+		__DMB();
+		uartTxHead++;
+	    }
+
+	// Send it
+	chSysLock();
+	uartTxStartI();
+	chSysUnlock();
+
+	// Wait for space
+	if (i<n)
+	   {
+	   if (PORT_ABORT) break;
+	   chBSemWaitTimeout(&UartTxSem,UART_WAIT_POLL);
+	   }
+    }
+
+ chMtxUnlock();
+
+ return i;
+ }
+
+// Gives non zero if the port is using the DMA
+int32_t uartIsOpen(void)
+ {
+ return uartOpen;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic UART port function
+int32_t uartFunction(ContextType *context,int32_t value)
+ {
+ uint8_t *buffer;
+ int32_t n,avail;
+
+ switch (value)
+     {
+     case UART_F_OPEN: // Open port ( ubaud udelim -- )
+    	 uartOpenPort(context);
+    	 break;
+
+     case UART_F_CLOSE: // Close port
+    	 uartClose();
+    	 break;
+
+     case UART_F_WRITE: // Write buffer ( addr n -- )
+    	 uartWrite(context);
+    	 break;
+
+     case UART_F_READ: // Read available bytes ( addr n -- nread )
+    	 if (!getBuffer(context,&buffer,&n)) return 0;
+    	 if (!checkOpen(context)) return 0;
+    	 avail=uartAvailable();
+    	 if (n>avail) n=avail;
+    	 PstackPush(context,uartCopy(buffer,n));
+    	 break;
+
+     case UART_F_AVAIL: // Available bytes ( -- n )
+    	 PstackPush(context,uartOpen?uartAvailable():0);
+    	 break;
+
+     case UART_F_LINE: // Wait line ( addr n ums -- nread )
+    	 uartWaitData(context,1);
+    	 break;
+
+     case UART_F_FRAME: // Wait frame ( addr n ums -- nread )
+    	 uartWaitData(context,0);
+    	 break;
+
+     case UART_F_LOST: // Lost bytes ( -- n )
+    	 PstackPush(context,(int32_t)uartRxLost);
+    	 break;
+
+     case UART_F_FLUSH: // Wait end of transmission
+    	 while (uartOpen&&((uartTxHead!=uartTxTail)||(!(UART_USART->ISR&USART_ISR_TC))))
+    	     {
+    		 if (PORT_ABORT)
+    		      {
+    			  runtimeErrorMessage(context,"UART flush aborted");
+    			  return 0;
+    		      }
+    		 chBSemWaitTimeout(&UartTxSem,1);
+    	     }
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in uartFunction");
+     }
+
+ return 0;
+ }
+
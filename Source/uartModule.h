@@ -0,0 +1,47 @@
+/*
+ uartModule.h
+ UART data port header file
+
+ USART1 on PC4 (TX) and PC5 (RX) with DMA ring buffers
+ DMA1 Channel 5 fills the RX ring and Channel 4 sends the TX ring
+ */
+
+#ifndef _UART_MODULE
+#define _UART_MODULE
+
+// Hardware used for this module
+#define UART_USART           USART1              // USART peripheral
+#define UART_CLOCK           STM32_USART1CLK     // USART kernel clock
+#define UART_IRQ_NUMBER      STM32_USART1_NUMBER // USART IRQ
+#define UART_RX_DMA_STREAM   STM32_DMA1_STREAM5  // USART1 RX DMA channel
+#define UART_TX_DMA_STREAM   STM32_DMA1_STREAM4  // USART1 TX DMA channel
+#define UART_DMA_PRIORITY    3                   // DMA priority (0..3)
+#define UART_IRQ_PRIORITY    8                   // DMA and USART IRQ priority
+
+// Port definitions
+#define UART_RX_SIZE         512         // RX ring size (power of 2)
+#define UART_TX_SIZE         256         // TX ring size (power of 2)
+#define UART_MIN_BAUD        1200        // Min baud rate
+#define UART_MAX_BAUD        4000000     // Max baud rate (OVER8)
+#define UART_WAIT_POLL       10          // Ticks between abort checks
+#define UART_NO_DELIM        (-1)        // No line delimiter
+
+// Function prototypes
+void uartModuleInit(void);
+int32_t uartIsOpen(void);
+int32_t uartSend(const uint8_t *buffer,int32_t n);
+
+// Command functions
+int32_t uartFunction(ContextType *context,int32_t value);
+#define UART_F_OPEN       0   // Open the port
+#define UART_F_CLOSE      1   // Close the port
+#define UART_F_WRITE      2   // Write a buffer
+#define UART_F_READ       3   // Read available bytes
+#define UART_F_AVAIL      4   // Available bytes
+#define UART_F_LINE       5   // Wait for a line
+#define UART_F_FRAME      6   // Wait for a frame
+#define UART_F_LOST       7   // Lost RX bytes
+#define UART_F_FLUSH      8   // Wait end of transmission
+
+#endif // _UART_MODULE
+
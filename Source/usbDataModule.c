@@ -0,0 +1,382 @@
+/*
+ usbDataModule.c
+ USB binary data channel source file
+
+ Data is moved in full speed 64 byte packets with two packet
+ buffers in each direction so the USB can send or receive one
+ packet while the CPU copies the other one
+
+ TX: the user buffer is copied in packets. The endpoint callback
+ starts the packet that is ready when the previous one ends.
+ Only the last packet of a write can be a short one. A write
+ that ends in a full packet is followed by a zero length packet
+ so the host read completes
+
+ RX: one buffer is always receiving while the other is not full.
+ If both are full the endpoint NAKs the host until one is read
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"          // Main include for the project
+#include "usbDataModule.h"  // This module header
+
+// TX packet buffers
+static uint8_t txPacket[2][USBDATA_PACKET];
+static int32_t txFill=0;                // Buffer being filled
+static volatile int32_t txActive=-1;    // Buffer in transmission or -1
+static volatile int32_t txReady=-1;     // Buffer waiting to be sent or -1
+static int32_t txSize[2];               // Bytes in each buffer
+
+// RX packet buffers
+static uint8_t rxPacket[2][USBDATA_PACKET];
+static volatile int32_t rxCount[2];     // Bytes received in each buffer
+static volatile int32_t rxActive=-1;    // Buffer in reception or -1
+static int32_t rxRead=0;                // Next buffer to read
+static int32_t rxPos=0;                 // Read position in this buffer
+
+// Wakes the waiting threads
+static BinarySemaphore UsbDataSem;
+
+// Serializes the writers
+static Mutex UsbDataTxMutex;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Start the transmission of a buffer (I-Class)
+static void txStartI(int32_t buffer)
+ {
+ txActive=buffer;
+ usbPrepareTransmit(&USBDATA_DRIVER,USBDATA_EP,txPacket[buffer],txSize[buffer]);
+ usbStartTransmitI(&USBDATA_DRIVER,USBDATA_EP);
+ }
+
+// Start the reception in a buffer (I-Class)
+static void rxStartI(int32_t buffer)
+ {
+ rxActive=buffer;
+ usbPrepareReceive(&USBDATA_DRIVER,USBDATA_EP,rxPacket[buffer],USBDATA_PACKET);
+ usbStartReceiveI(&USBDATA_DRIVER,USBDATA_EP);
+ }
+
+// Gives non zero if the channel is configured by the host
+static int32_t channelReady(void)
+ {
+ return (usbGetDriverStateI(&USBDATA_DRIVER)==USB_ACTIVE);
+ }
+
+// Check that the channel is configured
+// Returns 0 if not
+static int32_t checkReady(ContextType *context)
+ {
+ if (!channelReady())
+      {
+	  consoleErrorMessage(context,"USB data channel not connected");
+	  return 0;
+      }
+ return 1;
+ }
+
+// Try to get a buffer from the stack ( addr n -- )
+// Returns 0 on error
+static int32_t getBuffer(ContextType *context,uint8_t **buffer,int32_t *n)
+ {
+ int32_t addr;
+
+ if (PstackPop(context,n)) return 0;
+ if (PstackPop(context,&addr)) return 0;
+
+ if (((*n)<1)||(!portUserBuffer((uint32_t)addr,*n)))
+      {
+	  consoleErrorMessage(context,"Invalid buffer");
+	  return 0;
+      }
+
+ (*buffer)=(uint8_t*)addr;
+ return 1; // Ok
+ }
+
+// Wait on the semaphore checking abort and disconnection
+// Returns 0 if the wait must end
+static int32_t waitEventSilent(void)
+ {
+ if (PORT_ABORT) return 0;
+ if (!channelReady()) return 0;
+ chBSemWaitTimeout(&UsbDataSem,USBDATA_WAIT_POLL);
+ return 1;
+ }
+
+// Error message for a wait that ended
+static void waitError(ContextType *context)
+ {
+ if (!channelReady())
+	 runtimeErrorMessage(context,"USB data channel disconnected");
+    else
+     runtimeErrorMessage(context,"USB data transfer aborted");
+ }
+
+// Same as waitEventSilent but reports the errors
+static int32_t waitEvent(ContextType *context)
+ {
+ if (waitEventSilent()) return 1;
+ waitError(context);
+ return 0;
+ }
+
+// Queue the buffer being filled
+// Waits while there is already one waiting
+// Returns 0 on error
+static int32_t txQueue(void)
+ {
+ while (1)
+    {
+	chSysLock();
+	if (txReady<0)
+	    {
+		if (txActive<0)
+			txStartI(txFill);
+		   else
+			txReady=txFill;
+		chSysUnlock();
+		txFill^=1;
+		txSize[txFill]=0;
+		return 1;
+	    }
+	chSysUnlock();
+
+	if (!waitEventSilent()) return 0;
+    }
+ }
+
+// Send a buffer in packets
+// Must be called with the TX mutex locked
+// Returns the number of bytes queued
+static int32_t txSend(const uint8_t *buffer,int32_t n)
+ {
+ int32_t i,size=0,sent=0;
+
+ txSize[txFill]=0;
+ while (sent<n)
+    {
+	// Fill one packet
+	size=USBDATA_PACKET;
+	if (size>(n-sent)) size=n-sent;
+	for(i=0;i<size;i++)
+		txPacket[txFill][i]=buffer[sent+i];
+	txSize[txFill]=size;
+
+	// Queue it
+	if (!txQueue()) return sent;
+	sent+=size;
+    }
+
+ // Zero length packet after a full one
+ if (size==USBDATA_PACKET)
+	 txQueue();
+
+ return sent;
+ }
+
+// Write a buffer ( addr n -- )
+static void usbDataWrite(ContextType *context)
+ {
+ uint8_t *buffer;
+ int32_t n;
+
+ if (!getBuffer(context,&buffer,&n)) return;
+ if (!checkReady(context)) return;
+
+ if (usbDataSend(buffer,n)<n) waitError(context);
+ }
+
+// Number of received bytes pending to read
+static int32_t usbDataAvailable(void)
+ {
+ int32_t avail;
+
+ chSysLock();
+ avail=rxCount[0]+rxCount[1]-rxPos;
+ chSysUnlock();
+
+ return avail;
+ }
+
+// Read to a buffer ( addr n ums -- nread )
+// Waits for the first byte, then reads what is available
+static void usbDataRead(ContextType *context)
+ {
+ uint8_t *buffer;
+ int32_t n,timeout,count;
+ systime_t start;
+
+ if (PstackPop(context,&timeout)) return;
+ if (!getBuffer(context,&buffer,&n)) return;
+ if (!checkReady(context)) return;
+
+ // Wait for data
+ start=chTimeNow();
+ while (!rxCount[rxRead])
+     {
+	 if ((timeout>=0)&&((int32_t)(chTimeNow()-start)>=timeout))
+	      {
+		  PstackPush(context,0);
+		  return;
+	      }
+	 if (!waitEvent(context)) return;
+     }
+
+ // Copy full packets while there are
+ count=0;
+ while ((count<n)&&(rxCount[rxRead]))
+     {
+	 buffer[count++]=rxPacket[rxRead][rxPos++];
+
+	 // Release the buffer when read
+	 if (rxPos>=rxCount[rxRead])
+	      {
+		  chSysLock();
+		  rxCount[rxRead]=0;
+		  if ((rxActive<0)&&channelReady()) rxStartI(rxRead);
+		  chSysUnlock();
+		  rxRead^=1;
+		  rxPos=0;
+	      }
+     }
+
+ PstackPush(context,count);
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void usbDataModuleInit(void)
+ {
+ chBSemInit(&UsbDataSem,TRUE);
+ chMtxInit(&UsbDataTxMutex);
+ }
+
+// Send a buffer in packets
+// The telemetry thread and the Forth words can send
+// at the same time so the writers take a mutex
+// Returns the number of bytes queued that is less
+// than n on abort or disconnection
+int32_t usbDataSend(const uint8_t *buffer,int32_t n)
+ {
+ int32_t sent;
+
+ if (!channelReady()) return 0;
+
+ chMtxLock(&UsbDataTxMutex);
+ sent=txSend(buffer,n);
+ chMtxUnlock();
+
+ return sent;
+ }
+
+// Gives non zero if the channel is configured by the host
+int32_t usbDataReady(void)
+ {
+ return channelReady();
+ }
+
+// IN endpoint callback
+// Starts the packet waiting if there is one
+void usbDataTransmitted(USBDriver *usbp,usbep_t ep)
+ {
+ UNUSED(usbp);
+ UNUSED(ep);
+
+ chSysLockFromIsr();
+ txActive=-1;
+ if (txReady>=0)
+     {
+	 txStartI(txReady);
+	 txReady=-1;
+     }
+ chBSemSignalI(&UsbDataSem);
+ chSysUnlockFromIsr();
+ }
+
+// OUT endpoint callback
+// Continues in the other buffer if it is free
+void usbDataReceived(USBDriver *usbp,usbep_t ep)
+ {
+ int32_t buffer;
+
+ chSysLockFromIsr();
+ buffer=rxActive;
+ rxCount[buffer]=usbGetReceiveTransactionSizeI(usbp,ep);
+ if (!rxCount[buffer])
+	 rxStartI(buffer);  // Zero length packet
+    else
+     {
+	 if (!rxCount[buffer^1])
+		 rxStartI(buffer^1);
+	    else
+	     rxActive=-1;
+     }
+ chBSemSignalI(&UsbDataSem);
+ chSysUnlockFromIsr();
+ }
+
+// Resets the channel when the host configures the device (I-Class)
+void usbDataConfigureHookI(USBDriver *usbp)
+ {
+ UNUSED(usbp);
+
+ txFill=0;
+ txSize[0]=0;
+ txActive=-1;
+ txReady=-1;
+
+ rxCount[0]=0;
+ rxCount[1]=0;
+ rxRead=0;
+ rxPos=0;
+ rxStartI(0);
+
+ chBSemSignalI(&UsbDataSem);
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic USB data channel function
+int32_t usbDataFunction(ContextType *context,int32_t value)
+ {
+ switch (value)
+     {
+     case USBDATA_F_WRITE: // Write buffer ( addr n -- )
+    	 usbDataWrite(context);
+    	 break;
+
+     case USBDATA_F_READ: // Read buffer ( addr n ums -- nread )
+    	 usbDataRead(context);
+    	 break;
+
+     case USBDATA_F_AVAIL: // Available bytes ( -- n )
+    	 PstackPush(context,usbDataAvailable());
+    	 break;
+
+     case USBDATA_F_WAIT: // Wait end of transmission
+    	 while ((txActive>=0)||(txReady>=0))
+    		 if (!waitEvent(context)) return 0;
+    	 break;
+
+     case USBDATA_F_READY: // Channel configured ( -- flag )
+    	 PstackPush(context,channelReady()?FTRUE:FFALSE);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in usbDataFunction");
+     }
+
+ return 0;
+ }
+
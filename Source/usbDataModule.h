@@ -0,0 +1,37 @@
+/*
+ usbDataModule.h
+ USB binary data channel header file
+
+ Second CDC interface of the composite USB device reserved
+ for binary data. The console stays on the first one
+ */
+
+#ifndef _USB_DATA_MODULE
+#define _USB_DATA_MODULE
+
+// Channel definitions
+#define USBDATA_DRIVER      USBD1    // USB driver
+#define USBDATA_EP          3        // Bulk IN and OUT endpoint
+#define USBDATA_PACKET      64       // Full speed bulk packet size
+#define USBDATA_WAIT_POLL   10       // Ticks between abort checks
+
+// Function prototypes
+void usbDataModuleInit(void);
+int32_t usbDataSend(const uint8_t *buffer,int32_t n);
+int32_t usbDataReady(void);
+
+// Endpoint callbacks used by usbcfg.c
+void usbDataTransmitted(USBDriver *usbp,usbep_t ep);
+void usbDataReceived(USBDriver *usbp,usbep_t ep);
+void usbDataConfigureHookI(USBDriver *usbp);
+
+// Command functions
+int32_t usbDataFunction(ContextType *context,int32_t value);
+#define USBDATA_F_WRITE     0   // Write a buffer
+#define USBDATA_F_READ      1   // Read to a buffer
+#define USBDATA_F_AVAIL     2   // Received bytes available
+#define USBDATA_F_WAIT      3   // Wait end of transmission
+#define USBDATA_F_READY     4   // Channel configured
+
+#endif // _USB_DATA_MODULE
+
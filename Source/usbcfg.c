@@ -24,14 +24,27 @@
 #define USBD1_DATA_AVAILABLE_EP         1
 #define USBD1_INTERRUPT_REQUEST_EP      2
 
+/*
+ * Endpoints of the binary data channel (second CDC interface).
+ */
+#define USBD1_BIN_DATA_EP               3
+#define USBD1_BIN_INTERRUPT_EP          4
+
+/*
+ * Binary data channel endpoint callbacks in usbDataModule.c
+ */
+extern void usbDataTransmitted(USBDriver *usbp, usbep_t ep);
+extern void usbDataReceived(USBDriver *usbp, usbep_t ep);
+extern void usbDataConfigureHookI(USBDriver *usbp);
+
 /*
  * USB Device Descriptor.
  */
 static const uint8_t vcom_device_descriptor_data[18] = {
-  USB_DESC_DEVICE       (0x0110,        /* bcdUSB (1.1).                    */
-                         0x02,          /* bDeviceClass (CDC).              */
-                         0x00,          /* bDeviceSubClass.                 */
-                         0x00,          /* bDeviceProtocol.                 */
+  USB_DESC_DEVICE       (0x0200,        /* bcdUSB (2.0).                    */
+                         0xEF,          /* bDeviceClass (Miscellaneous).    */
+                         0x02,          /* bDeviceSubClass (Common).        */
+                         0x01,          /* bDeviceProtocol (IAD).           */
                          0x40,          /* bMaxPacketSize.                  */
                          0x0483,        /* idVendor (ST).                   */
                          0x5740,        /* idProduct.                       */
@@ -50,15 +63,31 @@ static const USBDescriptor vcom_device_descriptor = {
   vcom_device_descriptor_data
 };
 
-/* Configuration Descriptor tree for a CDC.*/
-static const uint8_t vcom_configuration_descriptor_data[67] = {
+/*
+ * Interface Association Descriptor for a CDC function.
+ */
+#define CDC_IAD(first)                                                        \
+  USB_DESC_BYTE         (8),            /* bLength.                         */\
+  USB_DESC_BYTE         (0x0B),         /* bDescriptorType (IAD).           */\
+  USB_DESC_BYTE         (first),        /* bFirstInterface.                 */\
+  USB_DESC_BYTE         (0x02),         /* bInterfaceCount.                 */\
+  USB_DESC_BYTE         (0x02),         /* bFunctionClass (CDC).            */\
+  USB_DESC_BYTE         (0x02),         /* bFunctionSubClass (ACM).         */\
+  USB_DESC_BYTE         (0x01),         /* bFunctionProtocol.               */\
+  USB_DESC_BYTE         (0x00)          /* iFunction.                       */
+
+/* Configuration Descriptor tree for two CDCs.
+   Interfaces 0 and 1 are the console and 2 and 3 the binary data channel.*/
+static const uint8_t vcom_configuration_descriptor_data[141] = {
   /* Configuration Descriptor.*/
-  USB_DESC_CONFIGURATION(67,            /* wTotalLength.                    */
-                         0x02,          /* bNumInterfaces.                  */
+  USB_DESC_CONFIGURATION(141,           /* wTotalLength.                    */
+                         0x04,          /* bNumInterfaces.                  */
                          0x01,          /* bConfigurationValue.             */
                          0,             /* iConfiguration.                  */
                          0xC0,          /* bmAttributes (self powered).     */
                          50),           /* bMaxPower (100mA).               */
+  /* Console function.*/
+  CDC_IAD(0x00),
   /* Interface Descriptor.*/
   USB_DESC_INTERFACE    (0x00,          /* bInterfaceNumber.                */
                          0x00,          /* bAlternateSetting.               */
@@ -122,6 +151,62 @@ static const uint8_t vcom_configuration_descriptor_data[67] = {
                          0x00),         /* bInterval.                       */
   /* Endpoint 1 Descriptor.*/
   USB_DESC_ENDPOINT     (USBD1_DATA_REQUEST_EP|0x80,    /* bEndpointAddress.*/
+                         0x02,          /* bmAttributes (Bulk).             */
+                         0x0040,        /* wMaxPacketSize.                  */
+                         0x00),         /* bInterval.                       */
+  /* Binary data function.*/
+  CDC_IAD(0x02),
+  /* Interface Descriptor.*/
+  USB_DESC_INTERFACE    (0x02,          /* bInterfaceNumber.                */
+                         0x00,          /* bAlternateSetting.               */
+                         0x01,          /* bNumEndpoints.                   */
+                         0x02,          /* bInterfaceClass (CDC).           */
+                         0x02,          /* bInterfaceSubClass (ACM).        */
+                         0x01,          /* bInterfaceProtocol.              */
+                         0),            /* iInterface.                      */
+  /* Header Functional Descriptor (CDC section 5.2.3).*/
+  USB_DESC_BYTE         (5),            /* bLength.                         */
+  USB_DESC_BYTE         (0x24),         /* bDescriptorType (CS_INTERFACE).  */
+  USB_DESC_BYTE         (0x00),         /* bDescriptorSubtype (Header).     */
+  USB_DESC_BCD          (0x0110),       /* bcdCDC.                          */
+  /* Call Management Functional Descriptor. */
+  USB_DESC_BYTE         (5),            /* bFunctionLength.                 */
+  USB_DESC_BYTE         (0x24),         /* bDescriptorType (CS_INTERFACE).  */
+  USB_DESC_BYTE         (0x01),         /* bDescriptorSubtype (Call
+                                           Management).                     */
+  USB_DESC_BYTE         (0x00),         /* bmCapabilities (D0+D1).          */
+  USB_DESC_BYTE         (0x03),         /* bDataInterface.                  */
+  /* ACM Functional Descriptor.*/
+  USB_DESC_BYTE         (4),            /* bFunctionLength.                 */
+  USB_DESC_BYTE         (0x24),         /* bDescriptorType (CS_INTERFACE).  */
+  USB_DESC_BYTE         (0x02),         /* bDescriptorSubtype (ACM).        */
+  USB_DESC_BYTE         (0x02),         /* bmCapabilities.                  */
+  /* Union Functional Descriptor.*/
+  USB_DESC_BYTE         (5),            /* bFunctionLength.                 */
+  USB_DESC_BYTE         (0x24),         /* bDescriptorType (CS_INTERFACE).  */
+  USB_DESC_BYTE         (0x06),         /* bDescriptorSubtype (Union).      */
+  USB_DESC_BYTE         (0x02),         /* bMasterInterface.                */
+  USB_DESC_BYTE         (0x03),         /* bSlaveInterface0.                */
+  /* Endpoint 4 Descriptor.*/
+  USB_DESC_ENDPOINT     (USBD1_BIN_INTERRUPT_EP|0x80,
+                         0x03,          /* bmAttributes (Interrupt).        */
+                         0x0008,        /* wMaxPacketSize.                  */
+                         0xFF),         /* bInterval.                       */
+  /* Interface Descriptor.*/
+  USB_DESC_INTERFACE    (0x03,          /* bInterfaceNumber.                */
+                         0x00,          /* bAlternateSetting.               */
+                         0x02,          /* bNumEndpoints.                   */
+                         0x0A,          /* bInterfaceClass (Data).          */
+                         0x00,          /* bInterfaceSubClass.              */
+                         0x00,          /* bInterfaceProtocol.              */
+                         0x00),         /* iInterface.                      */
+  /* Endpoint 3 OUT Descriptor.*/
+  USB_DESC_ENDPOINT     (USBD1_BIN_DATA_EP,             /* bEndpointAddress.*/
+                         0x02,          /* bmAttributes (Bulk).             */
+                         0x0040,        /* wMaxPacketSize.                  */
+                         0x00),         /* bInterval.                       */
+  /* Endpoint 3 IN Descriptor.*/
+  USB_DESC_ENDPOINT     (USBD1_BIN_DATA_EP|0x80,        /* bEndpointAddress.*/
                          0x02,          /* bmAttributes (Bulk).             */
                          0x0040,        /* wMaxPacketSize.                  */
                          0x00)          /* bInterval.                       */
@@ -258,6 +343,55 @@ static const USBEndpointConfig ep2config = {
   NULL
 };
 
+/**
+ * @brief   IN EP3 state.
+ */
+static USBInEndpointState ep3instate;
+
+/**
+ * @brief   OUT EP3 state.
+ */
+static USBOutEndpointState ep3outstate;
+
+/**
+ * @brief   EP3 initialization structure (both IN and OUT).
+ * @note    Binary data channel, packets are handled by usbDataModule.c
+ */
+static const USBEndpointConfig ep3config = {
+  USB_EP_MODE_TYPE_BULK,
+  NULL,
+  usbDataTransmitted,
+  usbDataReceived,
+  0x0040,
+  0x0040,
+  &ep3instate,
+  &ep3outstate,
+  2,
+  NULL
+};
+
+/**
+ * @brief   IN EP4 state.
+ */
+static USBInEndpointState ep4instate;
+
+/**
+ * @brief   EP4 initialization structure (IN only).
+ * @note    Notifications are never sent on the binary data channel.
+ */
+static const USBEndpointConfig ep4config = {
+  USB_EP_MODE_TYPE_INTR,
+  NULL,
+  NULL,
+  NULL,
+  0x0008,
+  0x0000,
+  &ep4instate,
+  NULL,
+  1,
+  NULL
+};
+
 /*
  * Handles the USB driver global events.
  */
@@ -277,10 +411,15 @@ static void usb_event(USBDriver *usbp, usbevent_t event) {
        must be used.*/
     usbInitEndpointI(usbp, USBD1_DATA_REQUEST_EP, &ep1config);
     usbInitEndpointI(usbp, USBD1_INTERRUPT_REQUEST_EP, &ep2config);
+    usbInitEndpointI(usbp, USBD1_BIN_DATA_EP, &ep3config);
+    usbInitEndpointI(usbp, USBD1_BIN_INTERRUPT_EP, &ep4config);
 
     /* Resetting the state of the CDC subsystem.*/
     sduConfigureHookI(&SDU1);
 
+    /* Resetting the state of the binary data channel.*/
+    usbDataConfigureHookI(usbp);
+
     chSysUnlockFromIsr();
     return;
   case USB_EVENT_SUSPEND:
@@ -0,0 +1,337 @@
+/*
+ waveModule.c
+ DAC waveform generator source file
+
+ Table output: TIM15 update triggers the DAC and each trigger
+ requests the next table value to the circular DMA so the CPU
+ is not used while the waveform is generated
+
+ Table swaps while running are done at the end of the current
+ table period from the DMA interrupt so the output never
+ mixes the two tables
+
+ Noise and triangle modes use the DAC internal generators
+ with the same trigger. Then AnalogWrite sets the base level.
+ */
+
+// Includes
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_debug.h"
+#include "fm_screen.h"
+
+#include "gizmo.h"         // Main include for the project
+#include "waveModule.h"    // This module header
+
+// Generator status
+static volatile int32_t waveStatus=WAVES_STOP;
+
+// Sample frequency
+static int32_t waveFreq=WAVE_DEF_FREQ;
+
+// Current table
+static uint16_t *waveTable=NULL;
+static int32_t waveSize=0;
+
+// Table pending to be swapped
+static uint16_t *volatile wavePendingTable=NULL;
+static volatile int32_t wavePendingSize=0;
+
+// DMA allocation flag
+static int32_t waveDmaAllocated=0;
+
+/*********************** STATIC FUNCTIONS *****************************/
+
+// Program the trigger timer for the given frequency
+// Returns the real frequency obtained
+static int32_t waveTimerSet(int32_t freq)
+ {
+ uint32_t div,psc,arr;
+
+ // Total division from the timer clock
+ div=WAVE_TIMER_CLOCK/freq;
+
+ // Prescaler needed to fit the 16 bit counter
+ psc=div/65536;
+ arr=(div/(psc+1))-1;
+
+ // Configure the timer stopped
+ WAVE_TIMER->CR1=0;
+ WAVE_TIMER->PSC=psc;
+ WAVE_TIMER->ARR=arr;
+
+ // Update event is selected as TRGO
+ WAVE_TIMER->CR2=TIM_CR2_MMS_1;
+
+ // Load prescaler and clear flags
+ WAVE_TIMER->EGR=TIM_EGR_UG;
+ WAVE_TIMER->SR=0;
+
+ return WAVE_TIMER_CLOCK/((psc+1)*(arr+1));
+ }
+
+// Program the DMA for a table and enable it
+static void waveDmaSet(uint16_t *table,int32_t size)
+ {
+ dmaStreamSetPeripheral(WAVE_DMA_STREAM,&(DAC->DHR12R1));
+ dmaStreamSetMemory0(WAVE_DMA_STREAM,table);
+ dmaStreamSetTransactionSize(WAVE_DMA_STREAM,size);
+ dmaStreamSetMode(WAVE_DMA_STREAM,STM32_DMA_CR_DIR_M2P|STM32_DMA_CR_MINC
+		        |STM32_DMA_CR_PSIZE_WORD|STM32_DMA_CR_MSIZE_HWORD
+		        |STM32_DMA_CR_CIRC|STM32_DMA_CR_TCIE
+		        |STM32_DMA_CR_PL(WAVE_DMA_PRIORITY));
+ dmaStreamEnable(WAVE_DMA_STREAM);
+ }
+
+// DMA interrupt callback
+// Called at the end of each table period
+static void waveDmaCallback(void *p,uint32_t flags)
+ {
+ UNUSED(p);
+
+ // Only transfer complete is used
+ if (!(flags&STM32_DMA_ISR_TCIF)) return;
+
+ chSysLockFromIsr();
+
+ // Check if there is a table to swap
+ if (wavePendingTable!=NULL)
+     {
+	 // Hold the trigger during the change
+	 WAVE_TIMER->CR1&=~TIM_CR1_CEN;
+
+	 // Change the table
+	 dmaStreamDisable(WAVE_DMA_STREAM);
+	 waveTable=wavePendingTable;
+	 waveSize=wavePendingSize;
+	 waveDmaSet(waveTable,waveSize);
+
+	 // Restart the trigger
+	 WAVE_TIMER->CR1|=TIM_CR1_CEN;
+
+	 wavePendingTable=NULL;
+     }
+
+ chSysUnlockFromIsr();
+ }
+
+// Stops any generation and returns DAC to software mode
+static void waveStop(void)
+ {
+ // Stop the trigger
+ WAVE_TIMER->CR1&=~TIM_CR1_CEN;
+
+ // DAC channel 1 without trigger, DMA nor wave generation
+ DAC->CR&=~(DAC_CR_EN1|DAC_CR_DMAEN1|DAC_CR_TEN1|DAC_CR_TSEL1
+		    |DAC_CR_WAVE1|DAC_CR_MAMP1);
+ DAC->CR|=DAC_CR_EN1;
+
+ // Release the DMA
+ if (waveDmaAllocated)
+     {
+	 dmaStreamDisable(WAVE_DMA_STREAM);
+	 dmaStreamRelease(WAVE_DMA_STREAM);
+	 waveDmaAllocated=0;
+     }
+
+ wavePendingTable=NULL;
+ waveStatus=WAVES_STOP;
+ }
+
+// Program DAC channel 1 triggered by the timer
+// wave is the WAVE1 code and amp the MAMP1 code
+static void waveDacTrigger(uint32_t wave,uint32_t amp,uint32_t dma)
+ {
+ // Configuration must be changed with the channel disabled
+ DAC->CR&=~DAC_CR_EN1;
+ DAC->CR=(DAC->CR&(~(DAC_CR_DMAEN1|DAC_CR_TEN1|DAC_CR_TSEL1
+		              |DAC_CR_WAVE1|DAC_CR_MAMP1)))
+		 |DAC_CR_TEN1|(WAVE_DAC_TSEL<<3)|(wave<<6)|(amp<<8)|dma;
+ DAC->CR|=DAC_CR_EN1;
+ }
+
+// Try to get a table from the stack ( addr n -- )
+// Returns 0 on error
+static int32_t getTable(ContextType *context,uint16_t **table,int32_t *size)
+ {
+ int32_t addr;
+
+ if (PstackPop(context,size)) return 0;
+ if (PstackPop(context,&addr)) return 0;
+
+ // Check size
+ if (((*size)<1)||((*size)>WAVE_MAX_SAMPLES))
+      {
+	  consoleErrorMessage(context,"Invalid table size");
+	  return 0;
+      }
+
+ // Check buffer
+ if ((addr&1)||(!portDmaBuffer((uint32_t)addr,(*size)*sizeof(uint16_t))))
+      {
+	  consoleErrorMessage(context,"Invalid table");
+	  return 0;
+      }
+
+ (*table)=(uint16_t*)addr;
+ return 1; // Ok
+ }
+
+// Start table output
+static void waveStartTable(ContextType *context)
+ {
+ // Check table
+ if (waveTable==NULL)
+      {
+	  consoleErrorMessage(context,"No waveform table");
+	  return;
+      }
+
+ // Stop any previous generation
+ waveStop();
+
+ // Try to allocate the DMA
+ if (dmaStreamAllocate(WAVE_DMA_STREAM,WAVE_IRQ_PRIORITY,waveDmaCallback,NULL))
+      {
+	  consoleErrorMessage(context,"Waveform DMA is busy");
+	  return;
+      }
+ waveDmaAllocated=1;
+
+ // Program the timer, DMA and DAC
+ waveTimerSet(waveFreq);
+ waveDmaSet(waveTable,waveSize);
+ waveDacTrigger(0,0,DAC_CR_DMAEN1);
+
+ // Start the trigger
+ waveStatus=WAVES_TABLE;
+ WAVE_TIMER->CR1|=TIM_CR1_CEN;
+ }
+
+// Start a hardware generator
+// ( ubase uamp -- )
+static void waveStartHardware(ContextType *context,int32_t mode)
+ {
+ int32_t base,amp;
+
+ // Get parameters
+ if (PstackPop(context,&amp)) return;
+ if (PstackPop(context,&base)) return;
+
+ // Check them
+ if ((amp<0)||(amp>WAVE_MAX_AMPLITUDE))
+      {
+	  consoleErrorMessage(context,"Invalid amplitude code");
+	  return;
+      }
+ if ((base<0)||(base>4095))
+      {
+	  consoleErrorMessage(context,"Invalid DAC value");
+	  return;
+      }
+
+ // Stop any previous generation
+ waveStop();
+
+ // Program the timer and the DAC
+ waveTimerSet(waveFreq);
+ DAC->DHR12R1=base;
+ if (mode==WAVES_NOISE)
+	 waveDacTrigger(1,amp,0);
+    else
+     waveDacTrigger(2,amp,0);
+
+ // Start the trigger
+ waveStatus=mode;
+ WAVE_TIMER->CR1|=TIM_CR1_CEN;
+ }
+
+/*********************** PUBLIC FUNCTIONS *****************************/
+
+// Module initialization
+void waveModuleInit(void)
+ {
+ // Enable trigger timer clock
+ RCC->APB2ENR|=RCC_APB2ENR_TIM15EN;
+ }
+
+/*********************** COMMAND FUNCTIONS ***************************/
+
+// Generic waveform function
+int32_t waveFunction(ContextType *context,int32_t value)
+ {
+ int32_t data;
+ uint16_t *table;
+
+ switch (value)
+     {
+     case WAVE_F_FREQ: // Set sample frequency ( uf -- uf )
+    	 if (PstackPop(context,&data)) return 0;
+    	 // Check range
+    	 if ((data<WAVE_MIN_FREQ)||(data>WAVE_MAX_FREQ))
+    	       {
+    		   consoleErrorMessage(context,"Invalid frequency");
+    		   return 0;
+    	       }
+    	 waveFreq=data;
+    	 // Program it keeping the timer state
+    	 data=WAVE_TIMER->CR1&TIM_CR1_CEN;
+    	 PstackPush(context,waveTimerSet(waveFreq));
+    	 WAVE_TIMER->CR1|=data;
+    	 break;
+
+     case WAVE_F_TABLE: // Set table ( addr n -- )
+    	 if (!getTable(context,&table,&data)) return 0;
+    	 if (waveStatus==WAVES_TABLE)
+    	      {
+    		  // Swap at the end of the current period
+    		  chSysLock();
+    		  wavePendingSize=data;
+    		  wavePendingTable=table;
+    		  chSysUnlock();
+    	      }
+    	     else
+    	      {
+    	      waveTable=table;
+    	      waveSize=data;
+    	      }
+    	 break;
+
+     case WAVE_F_START: // Start table output
+    	 waveStartTable(context);
+    	 break;
+
+     case WAVE_F_STOP: // Stop generation
+    	 waveStop();
+    	 break;
+
+     case WAVE_F_WAIT: // Wait pending swap
+    	 while (wavePendingTable!=NULL)
+    	     {
+    		 if (PORT_ABORT)
+    		      {
+    			  runtimeErrorMessage(context,"Waveform wait aborted");
+    			  return 0;
+    		      }
+    		 chThdSleep(WAVE_WAIT_POLL);
+    	     }
+    	 break;
+
+     case WAVE_F_NOISE: // Noise generation ( ubase uamp -- )
+    	 waveStartHardware(context,WAVES_NOISE);
+    	 break;
+
+     case WAVE_F_TRIANGLE: // Triangle generation ( ubase uamp -- )
+    	 waveStartHardware(context,WAVES_TRIANGLE);
+    	 break;
+
+     default:
+    	 DEBUG_MESSAGE("Cannot arrive to default in waveFunction");
+     }
+
+ return 0;
+ }
+
@@ -0,0 +1,50 @@
+/*
+ waveModule.h
+ DAC waveform generator header file
+
+ TIM15 TRGO triggers DAC channel 1 and circular DMA2 Channel 3
+ feeds it from a table of 12 bit values in user memory
+ */
+
+#ifndef _WAVE_MODULE
+#define _WAVE_MODULE
+
+// Hardware used for this module
+#define WAVE_TIMER           TIM15               // Trigger timer
+#define WAVE_DMA_STREAM      STM32_DMA2_STREAM3  // DAC1 CH1 DMA channel
+#define WAVE_DMA_PRIORITY    2                   // DMA priority (0..3)
+#define WAVE_IRQ_PRIORITY    6                   // DMA IRQ priority
+#define WAVE_DAC_TSEL        3                   // DAC TSEL 011 is TIM15_TRGO
+
+// Waveform limits
+#define WAVE_TIMER_CLOCK     72000000    // TIM15 clock (f APB2 x 2)
+#define WAVE_MIN_FREQ        1           // Min sample frequency
+#define WAVE_MAX_FREQ        1000000     // Max sample frequency
+#define WAVE_MAX_SAMPLES     65535       // DMA counter limit
+#define WAVE_DEF_FREQ        10000       // Default sample frequency
+#define WAVE_MAX_AMPLITUDE   11          // Max MAMP code (4095 amplitude)
+
+// Wait poll interval for abort check (in system ticks)
+#define WAVE_WAIT_POLL       10
+
+// Generator status
+#define WAVES_STOP           0    // DAC in software mode
+#define WAVES_TABLE          1    // Table output by DMA
+#define WAVES_NOISE          2    // Hardware noise generation
+#define WAVES_TRIANGLE       3    // Hardware triangle generation
+
+// Function prototypes
+void waveModuleInit(void);
+
+// Command functions
+int32_t waveFunction(ContextType *context,int32_t value);
+#define WAVE_F_FREQ       0   // Set sample frequency
+#define WAVE_F_TABLE      1   // Set table (swaps if running)
+#define WAVE_F_START      2   // Start table output
+#define WAVE_F_STOP       3   // Stop generation
+#define WAVE_F_WAIT       4   // Wait for a pending table swap
+#define WAVE_F_NOISE      5   // Start noise generation
+#define WAVE_F_TRIANGLE   6   // Start triangle generation
+
+#endif // _WAVE_MODULE
+
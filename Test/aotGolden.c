@@ -0,0 +1,241 @@
+/*
+ aotGolden.c
+ Expected CGEN output of the words in testTranslate.c
+
+ The part after the marker is compared with the translator
+ output. The file is also built in testTranslate to check
+ that the generated code compiles and does what the words do.
+ */
+
+#include "fp_config.h"     // MForth port main config
+#include "fp_port.h"       // Foth port include
+#include "fm_main.h"       // Forth Main header file
+#include "fm_stack.h"      // Stack module header
+#include "fm_program.h"
+#include "fm_screen.h"
+#include "fm_translate.h"  // Runtime for translated words
+
+/***** CGEN OUTPUT *****/
+
+// Translated from user word SQ
+// Register with: {"SQ","Translated word",aotSQ,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate SQ again"
+#endif
+int32_t aotSQ(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0,s1;
+
+ if (aotEnter(context,&frame,1)) return 0;
+ PstackPop(context,&s0);
+
+ s1=s0;
+ s0*=s1;
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word CLAMP
+// Register with: {"CLAMP","Translated word",aotCLAMP,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate CLAMP again"
+#endif
+int32_t aotCLAMP(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0,s1,s2,t;
+
+ if (aotEnter(context,&frame,3)) return 0;
+ PstackPop(context,&s2);
+ PstackPop(context,&s1);
+ PstackPop(context,&s0);
+
+ t=s0; s0=s1; s1=s2; s2=t;
+ if (s1>s2) s1=s2;
+ if (s0<s1) s0=s1;
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word SUM
+// Register with: {"SUM","Translated word",aotSUM,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate SUM again"
+#endif
+int32_t aotSUM(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0,s1,s2,t;
+
+ if (aotEnter(context,&frame,1)) return 0;
+ PstackPop(context,&s0);
+
+ s1=0;
+ t=s1; s1=s0; s0=t;
+ s2=0;
+ if (aotDo(context,&frame,s1,s2)) return 0;
+L5:
+ s1=context->rstack.LoopIndex;
+ s0+=s1;
+ if ((++(context->rstack.LoopIndex))<(context->rstack.LoopLimit)) { if (aotPoll(context,&frame)) return 0; goto L5; }
+ if (aotCall(context,&frame,195)) return 0;  // UNLOOP
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word SIGNUM
+// Register with: {"SIGNUM","Translated word",aotSIGNUM,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate SIGNUM again"
+#endif
+int32_t aotSIGNUM(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0,s1;
+
+ if (aotEnter(context,&frame,1)) return 0;
+ PstackPop(context,&s0);
+
+ s1=s0;
+ if (s1>=0) goto L6;
+ s0=-1;
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+L6:
+ s0=(s0>0)?FTRUE:FFALSE;
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word HALF
+// Register with: {"HALF","Translated word",aotHALF,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate HALF again"
+#endif
+int32_t aotHALF(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0;
+
+ if (aotEnter(context,&frame,1)) return 0;
+ PstackPop(context,&s0);
+
+ s0/=2;
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word AVG
+// Register with: {"AVG","Translated word",aotAVG,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate AVG again"
+#endif
+int32_t aotAVG(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0,s1;
+
+ if (aotEnter(context,&frame,2)) return 0;
+ PstackPop(context,&s1);
+ PstackPop(context,&s0);
+
+ s0+=s1;
+ s1=2;
+ PstackPush(context,s0);
+ PstackPush(context,s1);
+ if (aotCall(context,&frame,102)) return 0;  // /
+ PstackPop(context,&s0);
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word DOWN
+// Register with: {"DOWN","Translated word",aotDOWN,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate DOWN again"
+#endif
+int32_t aotDOWN(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0,s1;
+
+ if (aotEnter(context,&frame,1)) return 0;
+ PstackPop(context,&s0);
+
+L1:
+ s0-=1;
+ s1=s0;
+ if (s1) { if (aotPoll(context,&frame)) return 0; goto L1; }
+ PstackPush(context,s0);
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word BUMP
+// Register with: {"BUMP","Translated word",aotBUMP,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate BUMP again"
+#endif
+int32_t aotBUMP(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+ int32_t s0;
+
+ if (aotEnter(context,&frame,1)) return 0;
+ PstackPop(context,&s0);
+
+ *(int32_t*)(UDict.Mem+7)+=(int32_t)s0;
+ aotExit(context,&frame);
+ return 0;
+ }
+
+
+// Translated from user word HI
+// Register with: {"HI","Translated word",aotHI,0,0},
+#if FVERSION_INT!=107
+#error "Base codes have changed, translate HI again"
+#endif
+int32_t aotHI(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ AotFrame frame;
+
+ if (aotEnter(context,&frame,0)) return 0;
+
+ if (SHOW_RESPONSE(context)) { consolePrintf("%s"," Hi"); }
+ aotExit(context,&frame);
+ return 0;
+ }
+
@@ -0,0 +1,448 @@
+/*
+ benchCore.c
+ Host timing of the Forth core execution paths
+
+ The words are compiled by the core and then timed on the host.
+ The numbers depend on the host CPU but the ratios show the gain
+ of each change to the execution core.
+
+ Loops
+   The DO loop runtime is timed with the current codes and with
+   the codes it had before the innermost loop was kept in the
+   context (version 1.06). Both run the same compiled word in a
+   copy of the execution core, with a copy of the Base Dictionary
+   that has the old DO, LOOP, UNLOOP and I functions.
+
+ Stack effect verification
+   Typical words are timed as the compiler leaves them, with
+   a CHKD entry check and unchecked stack codes, and compiled
+   again with the unchecked code table emptied so they keep
+   the checked codes as before the verification was added.
+   Both run in the real execution core.
+
+ The program fails only if a result is wrong, the timing is
+ reported but not checked.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hostCore.c"
+#include "fm_branch.h"
+
+// The effect module is included to reach its code tables
+#include "../Source/fm_effect.c"
+
+/*********************** TIMING *****************************/
+
+static int32_t Failed=0;
+
+static void check(int32_t ok,const char *what)
+ {
+ if (ok) return;
+ printf("benchCore: FAIL %s\n",what);
+ Failed=1;
+ }
+
+// Host time in ns
+static double nowNs(void)
+ {
+ struct timespec t;
+
+ clock_gettime(CLOCK_MONOTONIC,&t);
+ return t.tv_sec*1e9+t.tv_nsec;
+ }
+
+/*********************** BASELINE LOOP *****************************/
+
+// DO, LOOP and UNLOOP as they were in version 1.06
+// Index and limit of every loop were on the return stack
+// and I was an alias of R@
+
+static int32_t baseLoopGetLimit(ContextType *context,int32_t *value)
+ {
+ int32_t pointer;
+
+ pointer=context->rstack.Pointer;
+ if (pointer<1) return 1;
+ (*value)=context->rstack.data[pointer-1];
+
+ return 0;
+ }
+
+static int32_t baseRstackAddTop(ContextType *context,int32_t value)
+ {
+ int32_t pointer;
+
+ pointer=context->rstack.Pointer;
+ if (pointer<0)
+	 {
+	 runtimeErrorMessage(context,"Rstack is empty");
+	 return 1;
+	 }
+ ((context->rstack.data)[pointer])+=value;
+
+ return 0;
+ }
+
+static int32_t baseExecuteDO(ContextType *context,int32_t value)
+ {
+ int32_t limit,index,addr;
+
+ if (PstackPop(context,&index))
+      {
+	  runtimeErrorMessage(context,"Not enough DO parameters");
+	  return 0;
+      }
+
+ if (PstackPop(context,&limit))
+      {
+	  runtimeErrorMessage(context,"Not enough DO parameters");
+ 	  return 0;
+      }
+
+ if (RstackPush(context,limit))
+      {
+	  runtimeErrorMessage(context,"Return stack overflow in DO");
+      return 0;
+      }
+
+ if (RstackPush(context,index))
+      {
+	  runtimeErrorMessage(context,"Return stack overflow in DO");
+      return 0;
+      }
+
+ if (value==F_DO_PLUS)
+        {
+	    addr=getAddrFromHere(context);
+	    if (index>=limit) context->Counter=addr;
+        }
+
+  if (value==F_DO_MINUS)
+         {
+ 	    addr=getAddrFromHere(context);
+ 	    if (index<=limit) context->Counter=addr;
+         }
+
+ return 0;
+ }
+
+static int32_t baseExecuteLOOP(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ int32_t limit,index,addr;
+
+ addr=getAddrFromHere(context);
+
+ if (baseLoopGetLimit(context,&limit))
+      {
+	  runtimeErrorMessage(context,"Indexing error in LOOP");
+      return 0;
+      }
+
+ baseRstackAddTop(context,1);
+
+ RstackGetTop(context,&index);
+ if (index>=limit) return 0;
+
+ context->Counter=addr;
+
+ return 0;
+ }
+
+static int32_t baseExecuteUNLOOP(ContextType *context,int32_t value)
+ {
+ UNUSED(value);
+
+ int32_t data;
+
+ if (RstackPop(context,&data))
+     {
+	 runtimeErrorMessage(context,"Return stack underflow in UNLOOP");
+     return 0;
+     }
+
+ if (RstackPop(context,&data))
+     {
+	 runtimeErrorMessage(context,"Return stack underflow in UNLOOP");
+     return 0;
+     }
+
+ return 0;
+ }
+
+/*********************** EXECUTION CORE *****************************/
+
+// Copies of the Base Dictionary
+#define BENCH_ENTRIES  1024
+
+// Each time is the best of this number of runs
+// that alternate the versions being compared
+#define BENCH_REPEATS  25
+static DictionaryEntry Current[BENCH_ENTRIES];
+static DictionaryEntry Baseline[BENCH_ENTRIES];
+
+// Builds the current and the baseline tables
+static void tablesInit(void)
+ {
+ int32_t i,n=0;
+
+ while (BaseDictionary[n].function!=NULL) n++;
+ if (n>BENCH_ENTRIES) n=BENCH_ENTRIES;
+
+ memcpy(Current,BaseDictionary,n*sizeof(DictionaryEntry));
+ memcpy(Baseline,BaseDictionary,n*sizeof(DictionaryEntry));
+
+ for(i=0;i<n;i++)
+     {
+	 if (Baseline[i].function==ExecuteDO)
+		 Baseline[i].function=baseExecuteDO;
+	 if (Baseline[i].function==ExecuteLOOP)
+		 Baseline[i].function=baseExecuteLOOP;
+	 if (Baseline[i].function==ExecuteUNLOOP)
+		 Baseline[i].function=baseExecuteUNLOOP;
+	 if ((Baseline[i].function==ExecuteLoopIndex)&&(Baseline[i].argument==F_INDEX_I))
+	     {
+		 Baseline[i].function=RstackFunction;
+		 Baseline[i].argument=RSTACK_RTOP;
+	     }
+     }
+ }
+
+// Runs a word with a dispatch table
+// Same steps as wordExecutionCore, the loop state is
+// only saved by the current core
+static void tableExecute(DictionaryEntry *table,uint16_t position,int32_t saveLoop)
+ {
+ ContextType *context=&MainContext;
+ uint16_t oldCounter,oldFrame;
+ int32_t oldIndex=0,oldLimit=0;
+ const DictionaryEntry *entry;
+ uint8_t byte;
+
+ oldCounter=context->Counter;
+ context->Counter=position;
+ oldFrame=context->rstack.Frame;
+ if (saveLoop)
+     {
+	 oldIndex=context->rstack.LoopIndex;
+	 oldLimit=context->rstack.LoopLimit;
+     }
+ context->rstack.Frame=context->rstack.Pointer;
+
+ while ((byte=UDict.Mem[(context->Counter)++])
+		 &&(!((context->Flags)&CFLAGS_ENDWORD)))
+     {
+	 entry=table+byte;
+	 if (byte==EXT1_CODE) entry=table+EXT1_START+UDict.Mem[(context->Counter)++];
+	 if (byte==EXT2_CODE) entry=table+EXT2_START+UDict.Mem[(context->Counter)++];
+	 if (byte==EXT3_CODE) entry=table+EXT3_START+UDict.Mem[(context->Counter)++];
+	 (entry->function)(context,entry->argument);
+     }
+
+ context->rstack.Pointer=context->rstack.Frame;
+ context->rstack.Frame=oldFrame;
+ if (saveLoop)
+     {
+	 context->rstack.LoopIndex=oldIndex;
+	 context->rstack.LoopLimit=oldLimit;
+     }
+ context->Counter=oldCounter;
+ (context->Flags)&=(~CFLAG_EXIT);
+ }
+
+// Time in ns of one call of a word with one input
+// Gives the result left on the stack
+static double timeWord(DictionaryEntry *table,int32_t saveLoop,uint16_t pos,
+		               int32_t input,int32_t calls,int32_t *result)
+ {
+ double t0;
+ int32_t i;
+
+ PstackInit(&MainContext);
+ RstackInit(&MainContext);
+ t0=nowNs();
+ for(i=0;i<calls;i++)
+     {
+	 PstackPush(&MainContext,input);
+	 tableExecute(table,pos,saveLoop);
+	 PstackPop(&MainContext,result);
+     }
+
+ return (nowNs()-t0)/calls;
+ }
+
+// Keeps the best time
+static void best(double *value,double time)
+ {
+ if (time<(*value)) (*value)=time;
+ }
+
+/*********************** BENCHMARKS *****************************/
+
+// Loop words
+// LEMPTY only runs LOOP on each step, the others also
+// run I and + so the step has the usual loop body cost
+static const struct
+    {
+	const char *def;    // Definition
+	const char *name;   // Word name
+	int32_t input;      // Number of iterations
+	int32_t result;     // Expected result
+	int32_t steps;      // Loop steps per call
+    }
+ Loops[]={
+		{": LEMPTY 0 DO LOOP 7 ;","LEMPTY",1000,7,1000},
+		{": LSUM 0 SWAP 0 DO I + LOOP ;","LSUM",1000,499500,1000},
+		{": LNEST 0 SWAP 0 DO 8 0 DO I + LOOP LOOP ;","LNEST",125,3500,1000},
+		{NULL,NULL,0,0,0} };
+
+static void benchLoops(void)
+ {
+ double tNew,tOld;
+ int32_t i,rep,rNew,rOld;
+ uint16_t pos;
+
+ printf("%-44s %7s %6s %8s\n","Loop step time (ns)","1.06","now","speedup");
+ for(i=0;Loops[i].def!=NULL;i++)
+     {
+	 run(Loops[i].def);
+	 pos=locateUserWord((char*)Loops[i].name);
+	 check(pos!=NO_WORD,Loops[i].def);
+	 if (pos==NO_WORD) continue;
+
+	 // Both versions take turns so host load affects both
+	 tOld=tNew=1e30;
+	 for(rep=0;rep<BENCH_REPEATS;rep++)
+	     {
+		 best(&tOld,timeWord(Baseline,0,pos,Loops[i].input,2000,&rOld));
+		 best(&tNew,timeWord(Current,1,pos,Loops[i].input,2000,&rNew));
+	     }
+	 check(rOld==Loops[i].result,Loops[i].name);
+	 check(rNew==Loops[i].result,Loops[i].name);
+
+	 printf("%-44s %7.2f %6.2f %7.2fx\n",Loops[i].def+2,
+			 tOld/Loops[i].steps,tNew/Loops[i].steps,tOld/tNew);
+     }
+ }
+
+// Time in ns of one call of a word in the execution core
+// Gives the result left on the stack
+static double timeCore(uint16_t pos,int32_t nin,int32_t calls,int32_t *result)
+ {
+ double t0;
+ int32_t i;
+
+ PstackInit(&MainContext);
+ RstackInit(&MainContext);
+ t0=nowNs();
+ for(i=0;i<calls;i++)
+     {
+	 PstackPush(&MainContext,5);
+	 if (nin>1) PstackPush(&MainContext,9);
+	 programExecute(&MainContext,pos,0);
+	 PstackPop(&MainContext,result);
+     }
+
+ return (nowNs()-t0)/calls;
+ }
+
+// Compiles a word that keeps the checked stack codes
+static void compileChecked(const char *def)
+ {
+ int16_t saved[UNCHECKED_WORDS];
+ int32_t i;
+
+ if (!effectReady) effectInit();
+
+ // No code has an unchecked version
+ for(i=0;i<(int32_t)UNCHECKED_WORDS;i++)
+     {
+	 saved[i]=UncheckedCodes[i][0];
+	 UncheckedCodes[i][0]=-1;
+     }
+
+ run(def);
+
+ for(i=0;i<(int32_t)UNCHECKED_WORDS;i++)
+	 UncheckedCodes[i][0]=saved[i];
+ }
+
+// Typical words with inputs 5 or 5 9
+// The checked copy has the same name ended in C
+static const struct
+    {
+	const char *def;    // Definition
+	const char *check;  // Definition of the checked copy
+	int32_t nin;        // Number of inputs
+	int32_t result;     // Expected result
+    }
+ Words[]={
+		{": POLY DUP DUP * SWAP 3 * + 7 - ;",": POLYC DUP DUP * SWAP 3 * + 7 - ;",1,33},
+		{": MIX OVER OVER + ROT ROT - * ;",": MIXC OVER OVER + ROT ROT - * ;",2,-56},
+		{": SQDIFF SWAP - DUP * ;",": SQDIFFC SWAP - DUP * ;",2,16},
+		{NULL,NULL,0,0} };
+
+// Name of a word from its definition
+static void wordName(const char *def,char *name)
+ {
+ def+=2;
+ while (*def!=' ') *(name++)=*(def++);
+ *name=0;
+ }
+
+static void benchEffect(void)
+ {
+ double tNew,tOld;
+ int32_t i,rep,rNew,rOld;
+ uint16_t pos,posC;
+ char name[16];
+
+ printf("%-44s %7s %6s %8s\n","Word call time (ns)","checked","CHKD","speedup");
+ for(i=0;Words[i].def!=NULL;i++)
+     {
+	 run(Words[i].def);
+	 compileChecked(Words[i].check);
+	 wordName(Words[i].def,name);
+	 pos=locateUserWord(name);
+	 wordName(Words[i].check,name);
+	 posC=locateUserWord(name);
+	 check((pos!=NO_WORD)&&(posC!=NO_WORD),Words[i].def);
+	 if ((pos==NO_WORD)||(posC==NO_WORD)) continue;
+
+	 // Only the first one must be changed
+	 check(UDict.Mem[pos]==CHKD_CODE,"Word verified");
+	 check(UDict.Mem[posC]!=CHKD_CODE,"Word not verified");
+
+	 tOld=tNew=1e30;
+	 for(rep=0;rep<BENCH_REPEATS;rep++)
+	     {
+		 best(&tOld,timeCore(posC,Words[i].nin,20000,&rOld));
+		 best(&tNew,timeCore(pos,Words[i].nin,20000,&rNew));
+	     }
+	 check(rOld==Words[i].result,Words[i].check);
+	 check(rNew==Words[i].result,Words[i].def);
+
+	 printf("%-44s %7.2f %6.2f %7.2fx\n",Words[i].def+2,tOld,tNew,tOld/tNew);
+     }
+ }
+
+int main(void)
+ {
+ forthInit();
+ BREAK=(char*)BRK_MATRIX[2];  // LF line breaks
+ MainContext.VerboseLevel=VBIT_ERROR|VBIT_RESPONSE;
+ tablesInit();
+
+ benchLoops();
+ benchEffect();
+
+ if (Failed) return 1;
+ printf("benchCore: OK\n");
+ return 0;
+ }
@@ -0,0 +1,6 @@
+/*
+ base.h
+ Host include of the port basic definitions
+ */
+
+#include "../../Source/Base.h"
@@ -0,0 +1,58 @@
+/*
+ ch.h
+ Host replacement of the ChibiOS/RT header
+
+ Only the types and calls used by the modules
+ under test are provided. Nothing runs in threads.
+ */
+
+#ifndef _HOST_CH
+#define _HOST_CH
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int32_t msg_t;
+typedef uint32_t systime_t;
+typedef int32_t bool_t;
+typedef uint8_t tprio_t;
+typedef uint64_t stkalign_t;
+typedef msg_t (*tfunc_t)(void *);
+
+typedef struct { int32_t dummy; } BinarySemaphore;
+typedef struct { int32_t dummy; } Mutex;
+typedef struct { int32_t dummy; } Thread;
+
+#define TRUE   1
+#define FALSE  0
+
+#define CH_FREQUENCY   1000
+#define NORMALPRIO     64
+#define HIGHPRIO       127
+#define LOWPRIO        2
+
+#define THD_WA_SIZE(n)       (n)
+#define WORKING_AREA(s,n)    stkalign_t s[(n)/sizeof(stkalign_t)]
+
+// Nothing is shared with other threads
+static inline void chSysLock(void) { }
+static inline void chSysUnlock(void) { }
+static inline void chSysLockFromIsr(void) { }
+static inline void chSysUnlockFromIsr(void) { }
+static inline void port_lock(void) { }
+static inline void port_unlock(void) { }
+static inline void chSchRescheduleS(void) { }
+static inline void chBSemInit(BinarySemaphore *s,bool_t t) { (void)s; (void)t; }
+static inline msg_t chBSemWait(BinarySemaphore *s) { (void)s; return 0; }
+static inline msg_t chBSemWaitTimeout(BinarySemaphore *s,systime_t t) { (void)s; (void)t; return 0; }
+static inline void chBSemSignal(BinarySemaphore *s) { (void)s; }
+static inline void chBSemSignalI(BinarySemaphore *s) { (void)s; }
+static inline void chMtxInit(Mutex *m) { (void)m; }
+static inline void chMtxLock(Mutex *m) { (void)m; }
+static inline void chMtxUnlock(void) { }
+static inline void chThdSleep(systime_t t) { (void)t; }
+static inline systime_t chTimeNow(void) { return 0; }
+static inline Thread *chThdCreateStatic(void *w,size_t s,tprio_t p,tfunc_t f,void *a)
+ { (void)w; (void)s; (void)p; (void)f; (void)a; return NULL; }
+
+#endif // _HOST_CH
@@ -0,0 +1,17 @@
+/*
+ chprintf.h
+ Host replacement of the ChibiOS printf header
+ */
+
+#ifndef _HOST_CHPRINTF
+#define _HOST_CHPRINTF
+
+#ifdef HOST_CONSOLE
+// The test program takes the console output
+void hostPrintf(const char *fmt,...);
+#define chprintf(chp,...)  hostPrintf(__VA_ARGS__)
+#else
+#define chprintf(...)
+#endif
+
+#endif // _HOST_CHPRINTF
@@ -0,0 +1,40 @@
+/*
+ hal.h
+ Host replacement of the ChibiOS HAL header
+ */
+
+#ifndef _HOST_HAL
+#define _HOST_HAL
+
+typedef struct { int32_t dummy; } BaseSequentialStream;
+typedef struct { int32_t dummy; } BaseChannel;
+typedef struct { uint32_t IDR; } GPIO_TypeDef;
+typedef struct { int32_t dummy; } GPTDriver;
+typedef struct { int32_t dummy; } GPTConfig;
+typedef struct { int32_t dummy; } EXTDriver;
+typedef uint32_t expchannel_t;
+typedef void (*extcallback_t)(EXTDriver *extp,expchannel_t channel);
+typedef struct { int32_t dummy; } USBDriver;
+typedef uint8_t usbep_t;
+
+// Stream writes are discarded
+static inline size_t chSequentialStreamWrite(BaseSequentialStream *ip,const uint8_t *bp,size_t n)
+ { (void)ip; (void)bp; return n; }
+
+// GPIO ports are not used on the host
+// The button reads as released so PORT_ABORT is false
+// Weak so all the core sources can share it
+__attribute__((weak)) GPIO_TypeDef HostGpioA;
+#define GPIOA  (&HostGpioA)
+#define GPIOE  ((GPIO_TypeDef*)0)
+
+// The test program gives the level of all pads
+int32_t hostPalReadPad(void);
+#define palReadPad(port,pad)  hostPalReadPad()
+
+// EXT line modes
+#define EXT_CH_MODE_DISABLED      0
+#define EXT_CH_MODE_RISING_EDGE   1
+#define EXT_MODE_GPIOE            0
+
+#endif // _HOST_HAL
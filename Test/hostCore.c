@@ -0,0 +1,99 @@
+/*
+ hostCore.c
+ Forth core on the host for the tests that run the interpreter
+
+ Included by the test programs. It includes fm_main.c to reach
+ the token parser, stubs the port modules of the Base Dictionary
+ and takes the console so run() interprets one line and leaves
+ the console output in Output.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../Source/fm_main.c"
+
+/*********************** STUBS *****************************/
+
+// Port modules of the Base Dictionary
+#define STUB(f) int32_t f(ContextType *context,int32_t value) \
+		{ (void)context; (void)value; return 0; }
+
+STUB(acqFunction) STUB(analogFunction) STUB(bufferConvertFunction)
+STUB(bufferFunction) STUB(busesFunction) STUB(captureFunction)
+STUB(consoleFunction) STUB(edgeFunction) STUB(encoderFunction)
+STUB(fusionFunction) STUB(gpioBfunction) STUB(gpioBread)
+STUB(gpioBreadOut) STUB(gpioFunction) STUB(i2cBufferFunction)
+STUB(i2cSetSpeed) STUB(i2cTransfer) STUB(imuFunction)
+STUB(internalRegistersFunction) STUB(ledBfunction) STUB(ledBinaryRead)
+STUB(ledFunction) STUB(mutexFunction) STUB(patternFunction)
+STUB(pwmFunction) STUB(rpcFunction) STUB(semaphoreFunction)
+STUB(spiBufferFunction) STUB(spiNexangeFunction) STUB(spiSetSpeed)
+STUB(telemetryFunction) STUB(timeFunction) STUB(uartFunction)
+STUB(usbDataFunction) STUB(waveFunction)
+
+// Port functions
+int32_t WhichConsole=1;
+BaseSequentialStream *Console_BSS;
+void portSaveInit(PortSave *pointer) { (void)pointer; }
+int32_t saveUserDictionary(void) { return 0; }
+int32_t loadUserDictionary(void) { return 1; }
+int32_t portThreadCreate(int32_t nth,void *pointer) { (void)nth; (void)pointer; return 0; }
+void portShowLimits(void) { }
+int32_t isAnyCallback(void) { return 0; }
+
+/*********************** CONSOLE *****************************/
+
+// Console input line
+static const char *Input="";
+
+// Console output
+static char Output[16384];
+static int32_t OutputSize=0;
+
+int32_t consoleGetChar(void)
+ {
+ if (!(*Input))
+     {
+	 printf("testTranslate: FAIL console read past the input\n");
+	 exit(1);
+     }
+ return *(Input++);
+ }
+
+void consolePutChar(int32_t value)
+ {
+ if (OutputSize<(int32_t)(sizeof(Output)-1))
+	 Output[OutputSize++]=value;
+ Output[OutputSize]=0;
+ }
+
+void hostPrintf(const char *fmt,...)
+ {
+ va_list args;
+
+ va_start(args,fmt);
+ OutputSize+=vsnprintf(Output+OutputSize,sizeof(Output)-OutputSize,fmt,args);
+ va_end(args);
+ if (OutputSize>(int32_t)(sizeof(Output)-1)) OutputSize=sizeof(Output)-1;
+ }
+
+/*********************** INTERPRETER *****************************/
+
+// Interprets one line
+static void run(const char *line)
+ {
+ static char buffer[MAX_CONSOLE_LINE+2];
+
+ snprintf(buffer,sizeof(buffer),"%s\n",line);
+ Input=buffer;
+ OutputSize=0;
+ Output[0]=0;
+
+ do
+   processToken(tokenGet());
+   while ((*linePointer)||(*Input));
+ }
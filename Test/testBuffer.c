@@ -0,0 +1,143 @@
+/*
+ testBuffer.c
+ Host test of the buffer math kernels
+
+ The module source is included so that its static kernels
+ can be called. The Cortex-M4 SMLALD instruction is emulated
+ so the half word DSP path is the one that gets tested.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Emulation of the dual 16 bit multiply accumulate
+#define __ARM_FEATURE_DSP
+static uint64_t __SMLALD(uint32_t x,uint32_t y,uint64_t acc)
+ {
+ int64_t r=(int64_t)acc;
+
+ r+=((int32_t)(int16_t)x)*((int32_t)(int16_t)y);
+ r+=((int32_t)(int16_t)(x>>16))*((int32_t)(int16_t)(y>>16));
+ return (uint64_t)r;
+ }
+
+#include "../Source/bufferModule.c"
+
+// Symbols the module needs at link time
+int32_t VddCal;
+void PstackPush(ContextType *context,int32_t value) { (void)context; (void)value; }
+int32_t PstackPop(ContextType *context,int32_t *value) { (void)context; (void)value; return 1; }
+void consoleErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+void runtimeErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+int32_t portUserBuffer(uint32_t addr,int32_t size) { (void)addr; (void)size; return 0; }
+
+// Number of failed checks
+static int32_t Failed=0;
+
+// Checks a condition
+static void check(int32_t ok,const char *what)
+ {
+ if (ok) return;
+ printf("FAIL: %s\n",what);
+ Failed++;
+ }
+
+// Reference sums with no tricks
+static void refSums(uint8_t *addr,int32_t n,int32_t size,int64_t *sum,int64_t *sumsq)
+ {
+ int32_t i,data;
+
+ (*sum)=0;
+ (*sumsq)=0;
+ for(i=0;i<n;i++)
+     {
+	 data=bufGet(addr,i,size);
+	 (*sum)+=data;
+	 (*sumsq)+=((int64_t)data)*data;
+     }
+ }
+
+// Checks the sums of one buffer
+static void checkSums(uint8_t *addr,int32_t n,int32_t size,const char *what)
+ {
+ int64_t sum,sumsq,rsum,rsumsq;
+
+ bufSums(addr,n,size,&sum,&sumsq);
+ refSums(addr,n,size,&rsum,&rsumsq);
+ check((sum==rsum)&&(sumsq==rsumsq),what);
+ }
+
+// Half word sums on every alignment, length and sign
+static void testSums(void)
+ {
+ static uint32_t words[260];
+ uint16_t *half;
+ int32_t i,n,off;
+
+ srand(1);
+ half=(uint16_t*)words;
+ for(i=0;i<520;i++) half[i]=(uint16_t)rand();
+
+ for(off=0;off<2;off++)
+	 for(n=1;n<=9;n++)
+	     {
+		 checkSums((uint8_t*)(half+off),n,2,"Unsigned half word sums");
+		 checkSums((uint8_t*)(half+off),n,-2,"Signed half word sums");
+	     }
+
+ // Extreme values
+ for(i=0;i<512;i++) half[i]=0xFFFF;
+ checkSums((uint8_t*)half,512,2,"Full scale unsigned sums");
+ checkSums((uint8_t*)(half+1),511,-2,"Minus one signed sums");
+ for(i=0;i<512;i++) half[i]=0x8000;
+ checkSums((uint8_t*)half,512,-2,"Most negative signed sums");
+
+ // Other sizes use the plain loop
+ checkSums((uint8_t*)words,37,1,"Unsigned byte sums");
+ checkSums((uint8_t*)words,37,-4,"Word sums");
+ }
+
+// Maximum and minimum location
+static void testLocate(void)
+ {
+ int16_t data[8]={3,-7,12,12,-7,0,5,1};
+ int32_t value,index;
+
+ index=bufLocate((uint8_t*)data,8,-2,1,&value);
+ check((index==2)&&(value==12),"First maximum");
+ index=bufLocate((uint8_t*)data,8,-2,-1,&value);
+ check((index==1)&&(value==-7),"First minimum");
+ index=bufLocate((uint8_t*)data,8,2,1,&value);
+ check((index==1)&&(value==65529),"Unsigned maximum");
+ }
+
+// Integer square root
+static void testSqrt(void)
+ {
+ uint64_t v;
+ int32_t r;
+
+ check(bufferSqrt64(0)==0,"Square root of 0");
+ check(bufferSqrt64(1)==1,"Square root of 1");
+ check(bufferSqrt64(15)==3,"Square root of 15");
+ check(bufferSqrt64(16)==4,"Square root of 16");
+ check(bufferSqrt64(0xFFFFFFFFFFFFFFFFULL)==(int32_t)0xFFFFFFFF,"Square root of 2^64-1");
+
+ for(v=1;v<(((uint64_t)1)<<62);v=v*3+1)
+     {
+	 r=bufferSqrt64(v);
+	 check((((uint64_t)(uint32_t)r)*(uint32_t)r<=v)
+		   &&(((uint64_t)(uint32_t)r+1)*((uint32_t)r+1)>v),"Square root bounds");
+     }
+ }
+
+int main(void)
+ {
+ testSums();
+ testLocate();
+ testSqrt();
+
+ printf("testBuffer: %s\n",Failed?"FAILED":"OK");
+ return Failed?1:0;
+ }
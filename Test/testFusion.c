@@ -0,0 +1,178 @@
+/*
+ testFusion.c
+ Host test of the attitude fusion engine
+
+ The module source is included and its filter update is fed
+ with sensor data replayed through imuLatest. The zero values
+ given by busesZero are added to the raw data so they must be
+ removed by the filter.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "../Source/bufferModule.c"
+#include "../Source/fusionModule.c"
+
+/*********************** SENSOR REPLAY *****************************/
+
+// Sensor data without zero values
+static int32_t Sensor[IMU_NSENSORS][3];
+
+// Zero values of each sensor
+static const int32_t Zero[IMU_NSENSORS][3]={{25,-40,12},{0,0,0},{0,0,0}};
+
+void imuLatest(int32_t sensor,int16_t *xyz)
+ {
+ int32_t i;
+
+ for(i=0;i<3;i++)
+	 xyz[i]=(int16_t)(Sensor[sensor][i]+Zero[sensor][i]);
+ }
+
+void busesZero(int32_t sensor,int32_t *zero)
+ {
+ int32_t i;
+
+ for(i=0;i<3;i++)
+	 zero[i]=Zero[sensor][i];
+ }
+
+// Other symbols the modules need at link time
+int32_t VddCal;
+int32_t imuStart(ContextType *context) { (void)context; return 1; }
+void PstackPush(ContextType *context,int32_t value) { (void)context; (void)value; }
+int32_t PstackPop(ContextType *context,int32_t *value) { (void)context; (void)value; return 1; }
+void consoleErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+void runtimeErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+int32_t portUserBuffer(uint32_t addr,int32_t size) { (void)addr; (void)size; return 0; }
+
+/*********************** TESTS *****************************/
+
+#define PI         3.14159265358979
+#define ACC_1G     1000            // Accelerometer counts for 1g
+#define MAG_FIELD  400             // Magnetometer horizontal counts
+#define GYR_DPS    (1000.0/8.75)   // Gyroscope counts for 1 dps
+
+// Number of failed checks
+static int32_t Failed=0;
+
+// Checks an angle in 1/100 degree
+static void checkAngle(int32_t value,double expected,double tolerance,const char *what)
+ {
+ double error;
+
+ error=value/100.0-expected;
+ if (error>180.0) error-=360.0;
+ if (error<-180.0) error+=360.0;
+ if (fabs(error)<=tolerance) return;
+
+ printf("FAIL: %s gives %.2f instead of %.2f\n",what,value/100.0,expected);
+ Failed++;
+ }
+
+// Sets the sensors for a still board
+// Roll, pitch and yaw in degrees. Null yaw field if mag is 0
+static void setStill(double roll,double pitch,double yaw,int32_t mag)
+ {
+ double r,p,y;
+
+ r=roll*PI/180.0;
+ p=pitch*PI/180.0;
+ y=yaw*PI/180.0;
+
+ // Gravity in the body frame
+ Sensor[IMU_ACC][0]=(int32_t)(-ACC_1G*sin(p));
+ Sensor[IMU_ACC][1]=(int32_t)(ACC_1G*cos(p)*sin(r));
+ Sensor[IMU_ACC][2]=(int32_t)(ACC_1G*cos(p)*cos(r));
+
+ // Horizontal north field in the body frame (level board only)
+ Sensor[IMU_MAG][0]=(int32_t)(mag*MAG_FIELD*cos(y));
+ Sensor[IMU_MAG][1]=(int32_t)(-mag*MAG_FIELD*sin(y));
+ Sensor[IMU_MAG][2]=0;
+
+ Sensor[IMU_GYR][0]=Sensor[IMU_GYR][1]=Sensor[IMU_GYR][2]=0;
+ }
+
+// Runs the filter for some seconds
+static void run(double seconds)
+ {
+ int32_t i,n;
+
+ n=(int32_t)(seconds*FusionRate);
+ for(i=0;i<n;i++) fusionUpdate();
+ }
+
+// CORDIC against the C library
+static void testAtan2(void)
+ {
+ int32_t i,x,y;
+ double a;
+
+ for(i=-179;i<=180;i+=7)
+     {
+	 a=i*PI/180.0;
+	 x=(int32_t)((1<<28)*cos(a));
+	 y=(int32_t)((1<<28)*sin(a));
+	 checkAngle(fusionAtan2(y,x)/100,i,0.02,"CORDIC angle");
+     }
+ }
+
+// Convergence to a still attitude
+static void testStill(void)
+ {
+ int32_t angles[3];
+
+ fusionReset();
+ setStill(0,0,0,1);
+ run(5);
+ fusionAngles(angles);
+ checkAngle(angles[0],0,0.2,"Level roll");
+ checkAngle(angles[1],0,0.2,"Level pitch");
+ checkAngle(angles[2],0,0.2,"Level yaw");
+
+ fusionReset();
+ setStill(30,0,0,0);
+ run(20);
+ fusionAngles(angles);
+ checkAngle(angles[0],30,0.5,"Tilted roll");
+ checkAngle(angles[1],0,0.5,"Tilted roll pitch");
+
+ fusionReset();
+ setStill(0,-20,0,0);
+ run(20);
+ fusionAngles(angles);
+ checkAngle(angles[0],0,0.5,"Tilted pitch roll");
+ checkAngle(angles[1],-20,0.5,"Tilted pitch");
+
+ fusionReset();
+ setStill(0,0,45,1);
+ run(20);
+ fusionAngles(angles);
+ checkAngle(angles[2],45,0.5,"Magnetic heading");
+ }
+
+// Integration of a constant rate with no heading reference
+static void testRate(void)
+ {
+ int32_t angles[3];
+
+ fusionReset();
+ setStill(0,0,0,0);
+ Sensor[IMU_GYR][2]=(int32_t)(10*GYR_DPS);
+ run(3);
+ fusionAngles(angles);
+ checkAngle(angles[2],30,0.5,"Yaw after 3s at 10dps");
+ checkAngle(angles[0],0,0.2,"Roll while turning");
+ }
+
+int main(void)
+ {
+ testAtan2();
+ testStill();
+ testRate();
+
+ printf("testFusion: %s\n",Failed?"FAILED":"OK");
+ return Failed?1:0;
+ }
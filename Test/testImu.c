@@ -0,0 +1,198 @@
+/*
+ testImu.c
+ Host test of the inertial sensors sampling service
+
+ The module source is included and runs over a stub bus
+ that replays a recorded sequence of FIFO levels and sample
+ data, so the drain, ring and copy code is checked without
+ the sensors.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../Source/imuModule.c"
+
+/*********************** STUB BUS *****************************/
+
+// One drain of the recording
+typedef struct
+ {
+ uint32_t now;     // Time of the drain in us
+ uint8_t gyrSrc;   // Gyroscope FIFO_SRC
+ uint8_t accSrc;   // Accelerometer FIFO_SRC
+ uint8_t magReady; // Magnetometer DRDY line
+ }
+ Drain;
+
+// Recorded sequence
+static const Drain Recording[]={
+		{ 1000, 4,              4,                 1 },
+		{ 2000, 0,              5,                 0 },
+		{ 3000, 3,              0,                 1 },
+		{ 4000, IMU_FIFO_OVRN|31, 7,               1 },
+		{ 5000, 1,              IMU_FIFO_OVRN|32,  0 },
+		{ 0, 0, 0, 0 }};
+
+// Current drain and samples sent to each sensor
+static const Drain *Current;
+static int32_t Sent[IMU_NSENSORS];
+
+// Value of one axis of one sample
+static int16_t sampleValue(int32_t sensor,int32_t n,int32_t axis)
+ {
+ return (int16_t)(sensor*10000+n*3+axis-2000);
+ }
+
+// Fills a burst from the sensor data
+// Magnetometer data is big endian in X,Z,Y order
+static void fillBurst(int32_t sensor,uint8_t *buf,int32_t n)
+ {
+ static const int32_t magOrder[3]={0,2,1};
+ int32_t i,axis;
+ int16_t v;
+
+ for(i=0;i<n;i++)
+     {
+	 for(axis=0;axis<3;axis++)
+	     {
+		 if (sensor==IMU_MAG)
+		     {
+			 v=sampleValue(sensor,Sent[sensor],magOrder[axis]);
+			 buf[2*axis]=(uint8_t)(v>>8);
+			 buf[2*axis+1]=(uint8_t)v;
+		     }
+		    else
+		     {
+			 v=sampleValue(sensor,Sent[sensor],axis);
+			 buf[2*axis]=(uint8_t)v;
+			 buf[2*axis+1]=(uint8_t)(v>>8);
+		     }
+	     }
+	 Sent[sensor]++;
+	 buf+=6;
+     }
+ }
+
+int32_t busesGyrRead(int32_t reg,uint8_t *buf,int32_t n)
+ {
+ if (reg==GYR_FIFO_SRC)
+     (*buf)=Current->gyrSrc;
+    else
+     fillBurst(IMU_GYR,buf,n/6);
+ return 0;
+ }
+
+int32_t busesSensorRead(int32_t addr,int32_t reg,uint8_t *buf,int32_t n)
+ {
+ if (addr==MAGNET_ADDR)
+	 fillBurst(IMU_MAG,buf,n/6);
+    else if (reg==ACCEL_FIFO_SRC_A)
+     (*buf)=Current->accSrc;
+    else
+     fillBurst(IMU_ACC,buf,n/6);
+ return 0;
+ }
+
+int32_t hostPalReadPad(void)
+ {
+ return Current->magReady;
+ }
+
+// Other symbols the module needs at link time
+void busesGyrWrite(int32_t reg,int32_t value) { (void)reg; (void)value; }
+int32_t busesSensorWrite(int32_t addr,int32_t reg,int32_t value) { (void)addr; (void)reg; (void)value; return 0; }
+void gpioExtSet(expchannel_t channel,uint32_t mode,extcallback_t callback) { (void)channel; (void)mode; (void)callback; }
+uint32_t timeMicros(void) { return 0; }
+int32_t edgeChannelUsed(int32_t channel) { (void)channel; return 0; }
+int32_t pwmIsStreaming(void) { return 0; }
+void PstackPush(ContextType *context,int32_t value) { (void)context; (void)value; }
+int32_t PstackPop(ContextType *context,int32_t *value) { (void)context; (void)value; return 1; }
+void consoleErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+int32_t portUserBuffer(uint32_t addr,int32_t size) { (void)addr; (void)size; return 0; }
+
+/*********************** TESTS *****************************/
+
+// Number of failed checks
+static int32_t Failed=0;
+
+// Checks a condition
+static void check(int32_t ok,const char *what)
+ {
+ if (ok) return;
+ printf("FAIL: %s\n",what);
+ Failed++;
+ }
+
+// Checks that the ring holds the last samples sent
+static void checkRing(int32_t sensor,const char *what)
+ {
+ static int32_t cells[4*IMU_RING_SIZE];
+ int32_t n,i,axis,first,ok=1;
+ int16_t xyz[3];
+
+ n=imuCopy(sensor,cells,IMU_RING_SIZE);
+ if (n!=((Sent[sensor]<IMU_RING_SIZE)?Sent[sensor]:IMU_RING_SIZE)) ok=0;
+
+ first=Sent[sensor]-n;
+ for(i=0;i<n;i++)
+	 {
+	 for(axis=0;axis<3;axis++)
+		 if (cells[4*i+1+axis]!=sampleValue(sensor,first+i,axis)) ok=0;
+
+	 // Timestamps never go back
+	 if ((i)&&(((int32_t)(cells[4*i]-cells[4*i-4]))<0)) ok=0;
+	 }
+ check(ok,what);
+
+ // Latest sample
+ imuLatest(sensor,xyz);
+ if (n)
+	 check((xyz[0]==sampleValue(sensor,Sent[sensor]-1,0))
+		   &&(xyz[2]==sampleValue(sensor,Sent[sensor]-1,2)),"Latest sample");
+ }
+
+// Replays the recording
+static void testReplay(void)
+ {
+ int32_t i,cells[4*4];
+
+ memset(Sent,0,sizeof(Sent));
+ for(i=0;i<IMU_NSENSORS;i++)
+     {
+	 ImuSensors[i].Count=0;
+	 ImuSensors[i].Overruns=0;
+	 ImuSensors[i].LastTime=0;
+     }
+
+ for(Current=Recording;Current->now;Current++)
+     {
+	 imuDrainGyr(Current->now);
+	 imuDrainAcc(Current->now);
+	 imuDrainMag(Current->now);
+     }
+
+ // Overruns read a full FIFO
+ check(ImuSensors[IMU_GYR].Count==4+3+32+1,"Gyroscope count");
+ check(ImuSensors[IMU_ACC].Count==4+5+7+32,"Accelerometer count");
+ check(ImuSensors[IMU_MAG].Count==3,"Magnetometer count");
+ check(ImuSensors[IMU_GYR].Overruns==1,"Gyroscope overruns");
+ check(ImuSensors[IMU_ACC].Overruns==1,"Accelerometer overruns");
+
+ checkRing(IMU_GYR,"Gyroscope ring");
+ checkRing(IMU_ACC,"Accelerometer ring");
+ checkRing(IMU_MAG,"Magnetometer ring");
+
+ // Samples of one burst are spread up to the drain time
+ check(imuCopy(IMU_ACC,cells,4)==4,"Copy count");
+ check((cells[12]==5000)&&(cells[8]<5000)&&(cells[8]>4000),"Burst timestamps");
+ }
+
+int main(void)
+ {
+ testReplay();
+
+ printf("testImu: %s\n",Failed?"FAILED":"OK");
+ return Failed?1:0;
+ }
@@ -0,0 +1,154 @@
+/*
+ testTelemetry.c
+ Host test of the binary telemetry framing
+
+ The module source is included to check the CRC and the
+ COBS encoder against known vectors. Then a set of records
+ is framed as the thread does and written to telemetry.bin
+ with one corrupted copy at the end. The Makefile decodes
+ that file with Tools/telDecode.py and compares the records
+ with telemetry.expected.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../Source/telemetryModule.c"
+
+/*********************** STUBS *****************************/
+
+BaseSequentialStream *Console_BSS;
+
+static uint32_t Now=1000;
+
+uint32_t timeMicros(void) { Now+=250; return Now; }
+int32_t usbDataSend(const uint8_t *buffer,int32_t n) { (void)buffer; return n; }
+int32_t usbDataReady(void) { return 0; }
+int32_t uartSend(const uint8_t *buffer,int32_t n) { (void)buffer; return n; }
+int32_t uartIsOpen(void) { return 0; }
+void PstackPush(ContextType *context,int32_t value) { (void)context; (void)value; }
+int32_t PstackPop(ContextType *context,int32_t *value) { (void)context; (void)value; return 1; }
+void consoleErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+void runtimeErrorMessage(ContextType *context,char *cad) { (void)context; (void)cad; }
+
+/*********************** TESTS *****************************/
+
+static int32_t Failed=0;
+
+static void check(int32_t ok,const char *what)
+ {
+ if (ok) return;
+ printf("testTelemetry: FAIL %s\n",what);
+ Failed=1;
+ }
+
+// CRC-16/CCITT-FALSE check value
+static void testCrc(void)
+ {
+ const char *data="123456789";
+ uint16_t crc=TEL_CRC_INIT;
+ int32_t i;
+
+ for(i=0;data[i];i++)
+	 crc=crcByte(crc,data[i]);
+ check(crc==0x29B1,"CRC check value");
+ }
+
+// COBS encoding of one vector
+static void checkCobs(const uint8_t *in,int32_t n,const uint8_t *exp,int32_t nexp,const char *what)
+ {
+ uint8_t out[300];
+ int32_t size;
+
+ size=cobsEncode(in,n,out);
+ check((size==nexp)&&(!memcmp(out,exp,nexp)),what);
+ }
+
+static void testCobs(void)
+ {
+ static const uint8_t in1[]={0x00};
+ static const uint8_t exp1[]={0x01,0x01,0x00};
+ static const uint8_t in2[]={0x11,0x22,0x00,0x33};
+ static const uint8_t exp2[]={0x03,0x11,0x22,0x02,0x33,0x00};
+ static const uint8_t in3[]={0x11,0x00,0x00};
+ static const uint8_t exp3[]={0x02,0x11,0x01,0x01,0x00};
+ uint8_t in4[254],exp4[257];
+ int32_t i;
+
+ checkCobs(in1,sizeof(in1),exp1,sizeof(exp1),"COBS single zero");
+ checkCobs(in2,sizeof(in2),exp2,sizeof(exp2),"COBS zero inside");
+ checkCobs(in3,sizeof(in3),exp3,sizeof(exp3),"COBS trailing zeros");
+
+ // A full block of 254 non zero bytes
+ exp4[0]=0xFF;
+ for(i=0;i<254;i++)
+	 exp4[i+1]=in4[i]=i+1;
+ exp4[255]=0x01;
+ exp4[256]=0x00;
+ checkCobs(in4,sizeof(in4),exp4,sizeof(exp4),"COBS full block");
+ }
+
+// Frames a set of records to telemetry.bin
+static void testFrames(void)
+ {
+ static const int32_t cells[TEL_MAX_CELLS]={
+		 1,-1,0,256,-256,0x7FFFFFFF,(int32_t)0x80000000,0x00FF00FF,
+		 1000,-1000,65536,-65536,12,34,56,78 };
+ uint8_t out[TEL_OUT_SIZE+TEL_MAX_FRAME];
+ int32_t n,size;
+ FILE *file;
+
+ check(telemetryAppend(1,0,cells),"Append empty record");
+ check(telemetryAppend(2,3,cells),"Append 3 cells");
+ check(telemetryAppend(0,TEL_MAX_CELLS,cells),"Append max cells");
+ check(telemetryAppend(255,8,cells+8),"Append id 255");
+
+ n=0;
+ while (telTail!=telHead)
+     {
+	 size=frameRecord(out+n);
+	 check(size<=TEL_MAX_FRAME,"Frame size limit");
+	 check(out[n+size-1]==0,"Frame delimiter");
+	 check(memchr(out+n,0,size-1)==NULL,"No zero inside frame");
+	 n+=size;
+     }
+
+ // Corrupted copy of the last frame
+ check(telemetryAppend(3,2,cells),"Append corrupted record");
+ size=frameRecord(out+n);
+ out[n+3]^=0x10;
+ n+=size;
+
+ file=fopen("telemetry.bin","wb");
+ check(file!=NULL,"Open telemetry.bin");
+ if (file==NULL) return;
+ check(fwrite(out,1,n,file)==(size_t)n,"Write telemetry.bin");
+ fclose(file);
+ }
+
+// Records that do not fit are counted as lost
+static void testFull(void)
+ {
+ int32_t cells[TEL_MAX_CELLS]={0};
+ int32_t i,ok=0;
+
+ telLost=0;
+ for(i=0;i<TEL_RING_SIZE;i++)
+	 ok+=telemetryAppend(4,TEL_MAX_CELLS,cells);
+ check(ok==(TEL_RING_SIZE/(TEL_MAX_CELLS+2)),"Records in full ring");
+ check(telLost==(uint32_t)(TEL_RING_SIZE-ok),"Lost records");
+ telTail=telHead;
+ }
+
+int main(void)
+ {
+ testCrc();
+ testCobs();
+ testFrames();
+ testFull();
+
+ if (Failed) return 1;
+ printf("testTelemetry: OK\n");
+ return 0;
+ }
@@ -0,0 +1,183 @@
+/*
+ testTranslate.c
+ Host test of the translation of user words to C
+
+ The Forth core runs on the host with the console taken by
+ the test. A set of words is compiled and translated with
+ CGEN and the output is compared with aotGolden.c, so any
+ change in the generated code shows up as a golden diff.
+
+ aotGolden.c is also built in this program. Each translated
+ function is run over the same inputs as the interpreted
+ word and both must leave the same stack and variables.
+
+ If the translator changes on purpose, the new output is
+ written to translate.out to review it and replace the
+ golden part of aotGolden.c.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hostCore.c"
+#include "aotGolden.c"
+
+/*********************** TESTS *****************************/
+
+static int32_t Failed=0;
+
+static void check(int32_t ok,const char *what)
+ {
+ if (ok) return;
+ printf("testTranslate: FAIL %s\n",what);
+ Failed=1;
+ }
+
+// Words under test
+// Each one shows a kind of translated code
+static const char *const Words[]={
+		": SQ DUP * ;",                              // Inline binary
+		": CLAMP ROT MIN MAX ;",                     // Rotation and max/min
+		": SUM 0 SWAP 0 DO I + LOOP ;",              // DO loop with I
+		": SIGNUM DUP 0< IF DROP -1 EXIT THEN 0> ;", // Jump and EXIT
+		": HALF 2/ ;",                               // Inline shift
+		": AVG + 2 / ;",                             // Base word call
+		": DOWN BEGIN 1- DUP 0= UNTIL ;",            // Backward jump
+		": BUMP CNT +! ;",                           // Direct variable
+		": HI .\" Hi\" ;",                           // Print string
+		NULL };
+
+// Name of a word from its definition
+static void wordName(const char *def,char *name)
+ {
+ def+=2;
+ while (*def!=' ') *(name++)=*(def++);
+ *name=0;
+ }
+
+// Compiles the words and checks their translation
+static void testGolden(void)
+ {
+ static char generated[16384];
+ char line[64],name[16];
+ char *golden,*start;
+ FILE *file;
+ long size;
+ int32_t i,n=0;
+
+ run("VARIABLE CNT");
+ for(i=0;Words[i]!=NULL;i++)
+     {
+	 run(Words[i]);
+	 check(!(MainFlags&(MFLAG_CERROR|MFLAG_IERROR)),Words[i]);
+	 wordName(Words[i],name);
+	 snprintf(line,sizeof(line),"CGEN %s",name);
+	 run(line);
+	 n+=snprintf(generated+n,sizeof(generated)-n,"%s",Output);
+     }
+
+ // Golden part of the file
+ file=fopen("aotGolden.c","rb");
+ check(file!=NULL,"Open aotGolden.c");
+ if (file==NULL) return;
+ fseek(file,0,SEEK_END);
+ size=ftell(file);
+ fseek(file,0,SEEK_SET);
+ golden=malloc(size+1);
+ golden[fread(golden,1,size,file)]=0;
+ fclose(file);
+ start=strstr(golden,"/***** CGEN OUTPUT *****/\n");
+ check(start!=NULL,"Golden marker");
+
+ if ((start==NULL)||strcmp(start+strlen("/***** CGEN OUTPUT *****/\n"),generated))
+     {
+	 check(0,"CGEN output differs from aotGolden.c (see translate.out)");
+	 file=fopen("translate.out","wb");
+	 if (file!=NULL)
+	     {
+		 fputs(generated,file);
+		 fclose(file);
+	     }
+     }
+ free(golden);
+ }
+
+// Runs a word interpreted and translated with the same inputs
+// and compares the stacks and the CNT variable
+static void compare(const char *inputs,const char *word,
+		            int32_t (*aot)(ContextType*,int32_t))
+ {
+ char line[64],what[96],out1[64],*text;
+ int32_t s1[8],s2[8],n1=0,n2=0,v1,v2,i;
+ int32_t *cnt;
+
+ cnt=(int32_t*)(UDict.Mem+locateUserWord("CNT")+1);
+ snprintf(what,sizeof(what),"%s %s",inputs,word);
+
+ // Interpreted
+ PstackInit(&MainContext);
+ *cnt=5;
+ snprintf(line,sizeof(line),"%s %s",inputs,word);
+ run(line);
+ text=Output;
+ if ((*text)=='\n') text++;  // Break before reading the line
+ strcpy(out1,text);
+ while ((n1<8)&&PstackGetSize(&MainContext)) PstackPop(&MainContext,s1+(n1++));
+ v1=*cnt;
+
+ // Translated
+ PstackInit(&MainContext);
+ *cnt=5;
+ if (*inputs) run(inputs);
+ OutputSize=0;
+ Output[0]=0;
+ aot(&MainContext,0);
+ while ((n2<8)&&PstackGetSize(&MainContext)) PstackPop(&MainContext,s2+(n2++));
+ v2=*cnt;
+
+ check(n1==n2,what);
+ for(i=0;(i<n1)&&(i<n2);i++)
+	 check(s1[i]==s2[i],what);
+ check(v1==v2,what);
+ check(!strcmp(out1,Output),what);
+ }
+
+// Runs the golden functions
+static void testRun(void)
+ {
+ MainContext.VerboseLevel=VBIT_ERROR|VBIT_RESPONSE;
+
+ compare("7","SQ",aotSQ);
+ compare("-3","SQ",aotSQ);
+ compare("15 0 10","CLAMP",aotCLAMP);
+ compare("-5 0 10","CLAMP",aotCLAMP);
+ compare("4 0 10","CLAMP",aotCLAMP);
+ compare("10","SUM",aotSUM);
+ compare("1","SUM",aotSUM);
+ compare("-9","SIGNUM",aotSIGNUM);
+ compare("0","SIGNUM",aotSIGNUM);
+ compare("9","SIGNUM",aotSIGNUM);
+ compare("9","HALF",aotHALF);
+ compare("-9","HALF",aotHALF);
+ compare("7 10","AVG",aotAVG);
+ compare("-7 2","AVG",aotAVG);
+ compare("5","DOWN",aotDOWN);
+ compare("3","BUMP",aotBUMP);
+ compare("","HI",aotHI);
+ }
+
+int main(void)
+ {
+ forthInit();
+ BREAK=(char*)BRK_MATRIX[2];  // LF line breaks
+ MainContext.VerboseLevel=VBIT_ERROR|VBIT_RESPONSE;
+
+ testGolden();
+ testRun();
+
+ if (Failed) return 1;
+ printf("testTranslate: OK\n");
+ return 0;
+ }
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+telDecode.py
+Host decoder of the binary telemetry stream
+
+Reads the frames sent by the TelStart destination and prints
+one line per record:
+
+  id time cell1 cell2 ...
+
+with the timestamp in us and the cells as signed numbers.
+The frame format is described in telemetryModule.h:
+
+  id(1) n(1) time(4) cells(4*n) crc(2)     little endian
+
+The CRC is CRC-16/CCITT-FALSE of all previous bytes and each
+frame is COBS encoded and ends with a zero byte. Frames that
+do not decode or fail the CRC are reported on stderr and
+skipped. The source is a serial port (it needs pyserial)
+or a capture file.
+
+Usage: telDecode.py (port | --file FILE) [--baud N]
+"""
+
+import argparse
+import struct
+import sys
+
+
+def cobs_decode(data):
+    """Decode one COBS frame without the delimiter, None if invalid"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out.extend(data[pos + 1:pos + code])
+        pos += code
+        if code < 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, no reflection"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+
+def decode_frame(frame):
+    """Record (id, time, cells) of one encoded frame or an error string"""
+    data = cobs_decode(frame)
+    if data is None:
+        return "bad COBS encoding"
+    if len(data) < 8:
+        return "short frame (%d bytes)" % len(data)
+    if crc16(data[:-2]) != struct.unpack("<H", data[-2:])[0]:
+        return "CRC error"
+    uid, n = data[0], data[1]
+    if len(data) != 8 + 4 * n:
+        return "length %d does not match %d cells" % (len(data), n)
+    time, = struct.unpack("<I", data[2:6])
+    cells = struct.unpack("<%di" % n, data[6:6 + 4 * n])
+    return (uid, time, cells)
+
+
+class Decoder:
+    """Splits a byte stream in frames and prints the records"""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.frames = 0
+        self.errors = 0
+
+    def feed(self, block):
+        self.pending.extend(block)
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            frame = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if frame:
+                self.record(frame)
+
+    def record(self, frame):
+        self.frames += 1
+        result = decode_frame(frame)
+        if isinstance(result, str):
+            self.errors += 1
+            print("Frame %d: %s" % (self.frames, result), file=sys.stderr)
+            return
+        uid, time, cells = result
+        print(" ".join(str(x) for x in (uid, time) + cells))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Telemetry stream decoder")
+    parser.add_argument("port", nargs="?", help="Serial port of the destination")
+    parser.add_argument("--file", help="Decode a capture file instead of a port")
+    parser.add_argument("--baud", type=int, default=115200,
+                        help="UART port baud rate (default 115200)")
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    if args.file:
+        with open(args.file, "rb") as capture:
+            decoder.feed(capture.read())
+    elif args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=1)
+        try:
+            while True:
+                decoder.feed(port.read(max(1, port.in_waiting)))
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            pass
+        port.close()
+    else:
+        parser.error("give a port or --file")
+
+    if decoder.errors:
+        print("%d of %d frames discarded" % (decoder.errors, decoder.frames),
+              file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+usbLoopback.py
+Host loopback throughput test of the USB binary data channel
+
+The board echoes everything it receives on the data channel
+with this word running (press the button to end it):
+
+  : USBLOOP BEGIN PAD 1024 100 UsbRead ?DUP IF PAD SWAP UsbWrite THEN AGAIN ;
+  USBLOOP
+
+The data channel is the second CDC interface of the board
+(for instance /dev/ttyACM1 or COM5). The script sends random
+data, checks the echo and gives the sustained rate in each
+direction. It needs pyserial.
+
+Usage: usbLoopback.py port [--bytes N] [--chunk N] [--min MBPS]
+"""
+
+import argparse
+import os
+import sys
+import threading
+import time
+
+import serial
+
+
+def main():
+    parser = argparse.ArgumentParser(description="USB data channel loopback test")
+    parser.add_argument("port", help="Serial port of the data channel")
+    parser.add_argument("--bytes", type=int, default=4 * 1024 * 1024,
+                        help="Bytes to send (default 4 MiB)")
+    parser.add_argument("--chunk", type=int, default=4096,
+                        help="Host write size (default 4096)")
+    parser.add_argument("--min", type=float, default=0.0,
+                        help="Fail if the rate is below this MB/s")
+    args = parser.parse_args()
+
+    data = os.urandom(args.bytes)
+    received = bytearray()
+    port = serial.Serial(args.port, timeout=1)
+    port.reset_input_buffer()
+
+    # The echo is read in parallel so the board never blocks
+    def reader():
+        idle = 0
+        while len(received) < len(data) and idle < 3:
+            block = port.read(max(1, min(65536, port.in_waiting)))
+            if block:
+                received.extend(block)
+                idle = 0
+            else:
+                idle += 1
+
+    thread = threading.Thread(target=reader)
+    start = time.perf_counter()
+    thread.start()
+    for pos in range(0, len(data), args.chunk):
+        port.write(data[pos:pos + args.chunk])
+    port.flush()
+    thread.join()
+    elapsed = time.perf_counter() - start
+    port.close()
+
+    if len(received) != len(data):
+        print("FAIL: %d of %d bytes echoed" % (len(received), len(data)))
+        return 1
+    if bytes(received) != data:
+        first = next(i for i in range(len(data)) if received[i] != data[i])
+        print("FAIL: echo differs at byte %d" % first)
+        return 1
+
+    rate = len(data) / elapsed / 1e6
+    print("%d bytes echoed in %.2f s: %.3f MB/s each way" % (len(data), elapsed, rate))
+    if rate < args.min:
+        print("FAIL: below %.3f MB/s" % args.min)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())